@@ -0,0 +1,98 @@
+#include "plumed/tools/XdrTrajectory.h"
+#include "plumed/tools/Random.h"
+#include "plumed/tools/Exception.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+using namespace PLMD;
+
+// Write a trajectory with random water-like molecules and read it back,
+// possibly jumping across frames using the index of the reader.
+
+int main() {
+  std::ofstream ofs("test");
+  Random rnd;
+  const int nmol=60;
+  const unsigned nframes=7;
+  std::vector<std::vector<float> > frames(nframes);
+  std::array<float,9> box{{3.0,0.0,0.0,1.0,3.0,0.0,1.0,1.0,3.0}};
+  for(unsigned f=0; f<nframes; f++) {
+    for(int i=0; i<nmol; i++) {
+      float x=3.0*rnd.RandU01(),y=3.0*rnd.RandU01(),z=3.0*rnd.RandU01();
+      frames[f].push_back(x); frames[f].push_back(y); frames[f].push_back(z);
+      frames[f].push_back(x+0.1); frames[f].push_back(y); frames[f].push_back(z);
+      frames[f].push_back(x); frames[f].push_back(y+0.1); frames[f].push_back(z-0.03);
+    }
+  }
+
+  {
+    XdrWriter xtc("test.xtc","xtc");
+    XdrWriter trr("test.trr","trr");
+    for(unsigned f=0; f<nframes; f++) {
+      xtc.write(10*f,0.5*f,box,frames[f]);
+      trr.write(10*f,0.5*f,box,frames[f]);
+    }
+// frames with few atoms are not compressed
+    XdrWriter small("small.xtc","xtc");
+    small.write(0,0.0,box,std::vector<float>(frames[0].begin(),frames[0].begin()+9));
+  }
+
+  for(const std::string format : {"xtc","trr"}) {
+    for(unsigned chunk=1; chunk<=4; chunk+=3) {
+      XdrReader reader("test."+format,format);
+      reader.setChunkSize(chunk);
+      plumed_assert(reader.getNumberOfAtoms()==3*nmol);
+      XdrFrame frame;
+      unsigned f=0;
+      double maxdev=0.0;
+      while(reader.read(frame)) {
+        plumed_assert(frame.step==long(10*f));
+        plumed_assert(frame.time==0.5*f);
+        for(unsigned i=0; i<9; i++) plumed_assert(frame.box[i]==box[i]);
+        for(unsigned i=0; i<frame.positions.size(); i++) maxdev=std::max(maxdev,std::fabs(frame.positions[i]-frames[f][i]));
+        f++;
+      }
+      plumed_assert(f==nframes);
+      if(format=="xtc") {
+        plumed_assert(maxdev<=0.0005+1e-6);
+      } else {
+        plumed_assert(maxdev==0.0);
+      }
+      ofs<<format<<" chunk "<<chunk<<" frames "<<f<<" maxdev below precision "<<(maxdev<=0.0005+1e-6)<<"\n";
+    }
+  }
+
+  {
+    XdrReader reader("test.xtc","xtc");
+    XdrFrame frame;
+    reader.read(frame);
+    reader.seek(5);
+    reader.read(frame);
+    ofs<<"after seek(5) step "<<frame.step<<"\n";
+    reader.seek(2);
+    reader.read(frame);
+    ofs<<"after seek(2) step "<<frame.step<<"\n";
+    ofs<<"number of frames "<<reader.getNumberOfFrames()<<"\n";
+    reader.read(frame);
+    ofs<<"next step "<<frame.step<<"\n";
+    reader.seek(6);
+    ofs<<"last frame found "<<reader.read(frame)<<" step "<<frame.step<<"\n";
+    ofs<<"end of file "<<!reader.read(frame)<<"\n";
+    try {
+      reader.seek(nframes);
+      ofs<<"seek beyond the end not detected\n";
+    } catch(const Exception &) {
+      ofs<<"seek beyond the end detected\n";
+    }
+  }
+
+  {
+    XdrReader reader("small.xtc","xtc");
+    XdrFrame frame;
+    plumed_assert(reader.read(frame));
+    for(unsigned i=0; i<9; i++) plumed_assert(frame.positions[i]==frames[0][i]);
+    ofs<<"small frame with "<<frame.natoms<<" atoms\n";
+  }
+  return 0;
+}
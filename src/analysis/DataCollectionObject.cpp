@@ -59,5 +59,12 @@ bool DataCollectionObject::transferDataToPDB( PDB& mypdb ) {
   return true;
 }
 
+std::size_t DataCollectionObject::getMemoryUsage() const {
+  std::size_t mem = myaction.capacity() + indices.capacity()*sizeof(AtomNumber) + positions.capacity()*sizeof(Vector);
+  // each node of a std::map also stores three pointers and a color
+  for(const auto & a : args) mem += 3*sizeof(void*) + sizeof(int) + sizeof(a) + a.first.capacity();
+  return mem;
+}
+
 }
 }
@@ -24,6 +24,7 @@
 
 #include <map>
 #include <vector>
+#include <cstddef>
 #include "tools/Vector.h"
 #include "tools/AtomNumber.h"
 
@@ -57,6 +58,8 @@ public:
   double getArgumentValue( const std::string& name ) const ;
 /// Transfer the data inside the object to a PDB object
   bool transferDataToPDB( PDB& mypdb );
+/// Return the approximate number of bytes stored in the object
+  std::size_t getMemoryUsage() const ;
 };
 
 inline
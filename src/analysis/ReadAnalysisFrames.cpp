@@ -106,6 +106,13 @@ const std::vector<AtomNumber>& ReadAnalysisFrames::getAtomIndexes() const {
   return getAbsoluteIndexes();
 }
 
+void ReadAnalysisFrames::getMemoryUsage( std::vector<std::pair<std::string,std::size_t> >& usage ) const {
+  AnalysisBase::getMemoryUsage( usage );
+  std::size_t mem = my_data_stash.capacity()*sizeof(DataCollectionObject) + (logweights.capacity()+weights.capacity())*sizeof(double);
+  for(const auto & d : my_data_stash) mem += d.getMemoryUsage();
+  usage.push_back( std::make_pair( "stored frames", mem ) );
+}
+
 void ReadAnalysisFrames::calculateWeights() {
   weights_calculated=true;
   weights.resize( logweights.size() );
@@ -72,6 +72,8 @@ public:
   DataCollectionObject & getStoredData( const unsigned& idata, const bool& calcdist ) override;
 /// Get the list of atoms that are being stored
   const std::vector<AtomNumber>& getAtomIndexes() const override;
+/// Report the memory used by the stored frames
+  void getMemoryUsage( std::vector<std::pair<std::string,std::size_t> >& usage ) const override;
 };
 
 inline
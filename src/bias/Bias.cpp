@@ -41,7 +41,7 @@ Bias::Bias(const ActionOptions&ao):
     log<<cite("Ferrarotti, Bottaro, Perez-Villa, and Bussi, J. Chem. Theory Comput. 11, 139 (2015)")<<"\n";
   }
   for(unsigned i=0; i<getNumberOfArguments(); ++i) {
-    (getPntrToArgument(i)->getPntrToAction())->turnOnDerivatives();
+    (getPntrToArgument(i)->getPntrToAction())->turnOnDerivativesFor(this);
   }
 
   turnOnDerivatives();
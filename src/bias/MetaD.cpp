@@ -31,7 +31,10 @@
 #include "tools/OpenMP.h"
 #include "tools/Random.h"
 #include "tools/File.h"
+#include "tools/Checkpoint.h"
 #include <ctime>
+#include <algorithm>
+#include <unordered_map>
 #include <numeric>
 #if defined(__PLUMED_HAS_GETCWD)
 #include <unistd.h>
@@ -154,6 +157,14 @@ By default \f$c(t)\f$ is updated every time the bias changes, but if this slows
 the keyword RCT_USTRIDE can be set to a value higher than 1.
 This option requires that a grid is used.
 
+The quantities that depend on the whole grid (\f$c(t)\f$, the maximum bias used by CALC_MAX_BIAS and DAMPFACTOR
+and the transition bias used by CALC_TRANSITION_BIAS) are not recomputed from scratch after every hill.
+The grid is split in blocks for which partial sums and maxima are stored, and only the blocks touched
+by the new hills are recomputed.  The transition bias is recomputed only when a new hill
+raises a grid point whose bias is not larger than the current transition bias, since otherwise it cannot change.
+To avoid the accumulation of rounding errors, everything is recomputed on the whole grid
+every STATS_REFRESH bias updates.
+
 Additional material and examples can be also found in the tutorials:
 
 - \ref lugano-3
@@ -214,6 +225,27 @@ METAD ...
 PRINT ARG=d1,d2,restraint.bias STRIDE=100  FILE=COLVAR
 \endplumedfile
 
+\par
+Without a grid, the cost of computing the bias grows with the number of deposited hills, whereas
+a grid has a fixed cost but is less accurate for adaptive hills, which can be narrower than the grid spacing.
+With GRID_HYBRID=n the grid and the explicit list of hills are used together.
+Hills are stored as explicit Gaussians until there are 2n of them, then the oldest n are projected
+on the grid and removed from the list. The bias is the sum of the grid and of the (at most 2n) most recent hills,
+so that its cost and memory stay bounded while the hills that are currently shaping the bias are
+evaluated exactly. GRID_SPARSE or GRID_BLOCK can be used so that the grid is only stored in the explored regions.
+\plumedfile
+DISTANCE ATOMS=3,5 LABEL=d1
+DISTANCE ATOMS=2,4 LABEL=d2
+METAD ...
+  ARG=d1,d2 SIGMA=0.05 HEIGHT=0.3 PACE=500 LABEL=restraint ADAPTIVE=GEOM
+  SIGMA_MIN=0.2,0.1 SIGMA_MAX=0.5,1.0
+  GRID_MIN=0,0 GRID_MAX=5,5 GRID_BLOCK
+  GRID_HYBRID=1000
+... METAD
+\endplumedfile
+Since the grid only contains the older hills, GRID_HYBRID cannot be used with GRID_WFILE and with the options that
+analyze the bias on the whole grid (CALC_RCT, CALC_MAX_BIAS, CALC_TRANSITION_BIAS and DAMPFACTOR).
+
 \par
 Multiple walkers can be also use as in  \cite multiplewalkers
 These are enabled by setting the number of walker used, the id of the
@@ -236,6 +268,31 @@ where all the walkers are located. WALKERS_RSTRIDE is the number of step between
 one update and the other. Since version 2.2.5, hills files are automatically
 flushed every WALKERS_RSTRIDE steps.
 
+\par
+With WALKERS_MPI the walkers are instead run as a single multi-replica simulation
+and the hills are exchanged with MPI.  By default, all walkers exchange their hills
+every PACE steps.  With many walkers it can be convenient to exchange them less often:
+with WALKERS_MPI_STRIDE=n each walker feels its own hills as soon as they are deposited, but
+the hills are exchanged (and added to the bias of all the walkers) in a single communication every n depositions.
+With WALKERS_MPI_SHARD, the work needed to add the exchanged hills to the grid
+is split among the walkers: each walker finds the grid points touched by a share of the new hills and computes their bias there.
+Only these points are then communicated and added to the grid of all the walkers.
+\plumedfile
+DISTANCE ATOMS=3,5 LABEL=d1
+METAD ...
+   ARG=d1 SIGMA=0.05 HEIGHT=0.3 PACE=500 LABEL=restraint
+   GRID_MIN=0 GRID_MAX=5
+   WALKERS_MPI
+   WALKERS_MPI_STRIDE=10
+   WALKERS_MPI_SHARD
+... METAD
+\endplumedfile
+The hills that are still waiting to be exchanged are also exchanged at the end of the simulation
+(i.e. when the MD code tells PLUMED that the run is over) and whenever a binary checkpoint is written (see \ref CHECKPOINT), so that the HILLS file
+and the checkpoint always contain all the hills deposited by all the walkers.
+Since this requires a communication among the walkers, with WALKERS_MPI_STRIDE
+all the walkers should write their checkpoints on the same steps.
+
 \par
 The \f$c(t)\f$ reweighting factor can be calculated on the fly using the equations
 presented in \cite Tiwary_jp504920s as described above.
@@ -427,6 +484,8 @@ private:
   std::vector<std::string> ifilesnames_;
   // Grids
   bool grid_;
+  // number of recent hills kept as explicit Gaussians when the grid is used (0 means that all hills are on the grid)
+  unsigned hybrid_;
   std::unique_ptr<GridBase> BiasGrid_;
   OFile gridfile_;
   bool storeOldGrids_;
@@ -438,6 +497,11 @@ private:
   int mw_rstride_;
   bool walkers_mpi_;
   unsigned mpi_nw_;
+  unsigned mpi_id_;
+  // number of depositions between two exchanges and hills of this walker that have not been exchanged yet
+  unsigned mpi_stride_;
+  std::vector<Gaussian> mpi_pending_;
+  bool mpi_shard_;
   // flying gaussians
   bool flying_;
   // kinetics from metadynamics
@@ -470,6 +534,24 @@ private:
   bool calc_rct_;
   double reweight_factor_;
   unsigned rct_ustride_;
+  // block-wise statistics of the bias grid, used to update c(t), the maximum bias
+  // and the transition bias without scanning the whole grid after every hill
+  bool stats_;
+  unsigned stats_refresh_;
+  unsigned stats_nupdates_;
+  Grid::index_t stats_blocksize_;
+  std::vector<double> block_max_;
+  std::vector<double> block_z0_;
+  std::vector<double> block_zv_;
+  double block_zref_;
+  std::vector<char> block_dirty_max_;
+  std::vector<char> block_dirty_rct_;
+  std::vector<Grid::index_t> dirty_max_;
+  std::vector<Grid::index_t> dirty_rct_;
+  // smallest bias (before the update) of the grid points raised since the last
+  // calculation of the transition bias, and whether any point was lowered
+  double trans_touched_min_;
+  bool trans_touched_lowered_;
   // work
   double work_;
   // neighbour list stuff
@@ -480,6 +562,8 @@ private:
   std::vector<Gaussian> nlist_hills_;
   std::vector<double> nlist_center_;
   std::vector<double> nlist_dev2_;
+  // number of threads used to sum the hills
+  OpenMPTuner tuner_;
 
   static void registerTemperingKeywords(const std::string &name_stem, const std::string &name, Keywords &keys);
   void   readTemperingSpecs(TemperingSpecs &t_specs);
@@ -487,6 +571,10 @@ private:
   void   readGaussians(IFile*);
   void   writeGaussian(const Gaussian&,OFile&);
   void   addGaussian(const Gaussian&);
+  void   addGaussianToGrid(const Gaussian&);
+  void   addGaussiansSharded(const std::vector<Gaussian>&);
+  void   projectOldHills();
+  void   exchangeMPIHills();
   double getHeight(const std::vector<double>&);
   void   temperHeight(double &height, const TemperingSpecs &t_specs, const double tempering_bias);
   double getBias(const std::vector<double>&);
@@ -498,15 +586,24 @@ private:
   bool   scanOneHill(IFile* ifile, std::vector<Value>& v, std::vector<double>& center, std::vector<double>& sigma, double& height, bool& multivariate);
   void   computeReweightingFactor();
   double getTransitionBarrierBias();
+  void   markBiasChanged(Grid::index_t, double, double);
+  void   refreshBlockStats();
+  void   getReweightingExponents(double&, double&);
+  double getMaxBias();
+  void   updateTransitionBias();
   void   updateFrequencyAdaptiveStride();
   void   updateNlist();
+  void   restoreCheckpoint(Checkpoint&);
 
 public:
   explicit MetaD(const ActionOptions&);
   void calculate() override;
   void update() override;
+  void runFinalJobs() override;
   static void registerKeywords(Keywords& keys);
   bool checkNeedsGradients()const override;
+  void saveCheckpoint(Checkpoint&) override;
+  void getMemoryUsage(std::vector<std::pair<std::string,std::size_t> >& usage)const override;
 };
 
 PLUMED_REGISTER_ACTION(MetaD,"METAD")
@@ -543,12 +640,17 @@ void MetaD::registerKeywords(Keywords& keys) {
                "This method is not compatible with metadynamics not on a grid.");
   keys.add("optional","RCT_USTRIDE","the update stride for calculating the \\f$c(t)\\f$ reweighting factor."
            "The default 1, so \\f$c(t)\\f$ is updated every time the bias is updated.");
+  keys.add("compulsory","STATS_REFRESH","100","the number of bias updates after which \f$c(t)\f$, the maximum bias and the transition bias are recomputed on the whole grid. "
+           "In between they are updated using only the blocks of the grid touched by the new hills");
   keys.add("optional","GRID_MIN","the lower bounds for the grid");
   keys.add("optional","GRID_MAX","the upper bounds for the grid");
   keys.add("optional","GRID_BIN","the number of bins for the grid");
   keys.add("optional","GRID_SPACING","the approximate grid spacing (to be used as an alternative or together with GRID_BIN)");
   keys.addFlag("GRID_SPARSE",false,"use a sparse grid to store hills");
+  keys.addFlag("GRID_BLOCK",false,"use a grid whose bins are allocated in blocks when hills are first deposited there, so that only the explored regions use memory");
   keys.addFlag("GRID_NOSPLINE",false,"don't use spline interpolation with grids");
+  keys.add("optional","GRID_HYBRID","keep the most recent hills as explicit Gaussians and project the older ones on the grid. "
+           "When 2 times this number of hills are stored, the oldest half is projected on the grid");
   keys.add("optional","GRID_WSTRIDE","write the grid to a file every N steps");
   keys.add("optional","GRID_WFILE","the file on which to write the grid");
   keys.add("optional","GRID_RFILE","a grid file from which the bias should be read at the initial step of the simulation");
@@ -563,6 +665,8 @@ void MetaD::registerKeywords(Keywords& keys) {
   keys.add("optional","WALKERS_DIR", "shared directory with the hills files from all the walkers");
   keys.add("optional","WALKERS_RSTRIDE","stride for reading hills files");
   keys.addFlag("WALKERS_MPI",false,"Switch on MPI version of multiple walkers - not compatible with WALKERS_* options other than WALKERS_DIR");
+  keys.add("optional","WALKERS_MPI_STRIDE","number of hills deposited by each walker between two exchanges of the hills with WALKERS_MPI (default=1)");
+  keys.addFlag("WALKERS_MPI_SHARD",false,"split among the walkers the addition to the grid of the hills exchanged with WALKERS_MPI");
   keys.add("optional","INTERVAL","one dimensional lower and upper limits, outside the limits the system will not feel the biasing force.");
   keys.addFlag("FLYING_GAUSSIAN",false,"Switch on flying Gaussian method, must be used with WALKERS_MPI");
   keys.addFlag("ACCELERATION",false,"Set to TRUE if you want to compute the metadynamics acceleration factor.");
@@ -598,9 +702,11 @@ MetaD::MetaD(const ActionOptions& ao):
   height0_(std::numeric_limits<double>::max()),
   adaptive_(FlexibleBin::none),
   grid_(false),
+  hybrid_(0),
   wgridstride_(0),
   mw_n_(1), mw_dir_(""), mw_id_(0), mw_rstride_(1),
-  walkers_mpi_(false), mpi_nw_(0),
+  walkers_mpi_(false), mpi_nw_(0), mpi_id_(0),
+  mpi_stride_(1), mpi_shard_(false),
   flying_(false),
   acceleration_(false), acc_(0.0), acc_restart_mean_(0.0),
   calc_max_bias_(false), max_bias_(0.0),
@@ -616,6 +722,13 @@ MetaD::MetaD(const ActionOptions& ao):
   calc_rct_(false),
   reweight_factor_(0.0),
   rct_ustride_(1),
+  stats_(false),
+  stats_refresh_(100),
+  stats_nupdates_(0),
+  stats_blocksize_(1024),
+  block_zref_(0.0),
+  trans_touched_min_(std::numeric_limits<double>::max()),
+  trans_touched_lowered_(false),
   work_(0),
   nlist_(false),
   nlist_update_(false),
@@ -802,6 +915,9 @@ MetaD::MetaD(const ActionOptions& ao):
 
   bool sparsegrid=false;
   parseFlag("GRID_SPARSE",sparsegrid);
+  bool blockgrid=false;
+  parseFlag("GRID_BLOCK",blockgrid);
+  if(sparsegrid && blockgrid) error("GRID_SPARSE and GRID_BLOCK cannot be used together");
   bool nospline=false;
   parseFlag("GRID_NOSPLINE",nospline);
   bool spline=!nospline;
@@ -822,6 +938,12 @@ MetaD::MetaD(const ActionOptions& ao):
   if(!grid_&&gridfilename_.length()> 0) error("To write a grid you need first to define it!");
   if(!grid_&&gridreadfilename_.length()>0) error("To read a grid you need first to define it!");
 
+  parse("GRID_HYBRID",hybrid_);
+  if(hybrid_>0) {
+    if(!grid_) error("GRID_HYBRID requires a grid");
+    if(gridfilename_.length()>0) error("GRID_WFILE cannot be used with GRID_HYBRID, since the grid only contains the older hills");
+  }
+
   /*setup neighbor list stuff*/
   parseFlag("NLIST", nlist_);
   nlist_center_.resize(getNumberOfArguments());
@@ -849,6 +971,8 @@ MetaD::MetaD(const ActionOptions& ao):
   parseFlag("CALC_RCT",calc_rct_);
   if (calc_rct_) plumed_massert(grid_,"CALC_RCT is supported only if bias is on a grid");
   parse("RCT_USTRIDE",rct_ustride_);
+  parse("STATS_REFRESH",stats_refresh_);
+  if(stats_refresh_==0) error("STATS_REFRESH should be larger than zero");
 
   if(dampfactor_>0.0) {
     if(!grid_) error("With DAMPFACTOR you should use grids");
@@ -863,6 +987,9 @@ MetaD::MetaD(const ActionOptions& ao):
 
   // MPI version
   parseFlag("WALKERS_MPI",walkers_mpi_);
+  parse("WALKERS_MPI_STRIDE",mpi_stride_);
+  parseFlag("WALKERS_MPI_SHARD",mpi_shard_);
+  tuner_.link(log,getLabel());
 
   // Flying Gaussian
   parseFlag("FLYING_GAUSSIAN", flying_);
@@ -996,7 +1123,9 @@ MetaD::MetaD(const ActionOptions& ao):
     log.printf("\n");
     if(spline) {log.printf("  Grid uses spline interpolation\n");}
     if(sparsegrid) {log.printf("  Grid uses sparse grid\n");}
+    if(blockgrid) {log.printf("  Grid is allocated in blocks where hills are deposited\n");}
     if(wgridstride_>0) {log.printf("  Grid is written on file %s with stride %d\n",gridfilename_.c_str(),wgridstride_);}
+    if(hybrid_>0) {log.printf("  The %u most recent hills are kept as explicit Gaussians, the older ones are projected on the grid every %u hills\n",hybrid_,hybrid_);}
   }
 
   if(mw_n_>1) {
@@ -1012,16 +1141,27 @@ MetaD::MetaD(const ActionOptions& ao):
       if(comm.Get_rank()==0) {
         // Only root of group can communicate with other walkers
         mpi_nw_=multi_sim_comm.Get_size();
+        mpi_id_=multi_sim_comm.Get_rank();
       }
       // Communicate to the other members of the same group
       // info abount number of walkers and walker index
       comm.Bcast(mpi_nw_,0);
+      comm.Bcast(mpi_id_,0);
+      if(mpi_stride_==0) error("WALKERS_MPI_STRIDE should be larger than zero");
+      if(mpi_stride_>1) log.printf("  hills are exchanged every %u depositions\n",mpi_stride_);
+      if(mpi_shard_) {
+        if(!grid_) error("WALKERS_MPI_SHARD can only be used with a grid");
+        log.printf("  addition of the exchanged hills to the grid is split among the walkers\n");
+      }
     }
   }
+  if(!walkers_mpi_ && (mpi_stride_!=1 || mpi_shard_)) error("WALKERS_MPI_STRIDE and WALKERS_MPI_SHARD can only be used with WALKERS_MPI");
 
   if(flying_) {
     if(!walkers_mpi_) error("Flying Gaussian method must be used with MPI version of multiple walkers");
     log.printf("  Flying Gaussian method with %d walkers active\n",mpi_nw_);
+    if(mpi_stride_>1) error("Flying Gaussian method cannot be used with WALKERS_MPI_STRIDE");
+    if(hybrid_>0) error("Flying Gaussian method cannot be used with GRID_HYBRID");
   }
 
   if(nlist_) {
@@ -1159,7 +1299,8 @@ MetaD::MetaD(const ActionOptions& ao):
         }
       }
       std::string funcl=getLabel() + ".bias";
-      if(!sparsegrid) {BiasGrid_=Tools::make_unique<Grid>(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
+      if(blockgrid) {BiasGrid_=Tools::make_unique<BlockGrid>(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
+      else if(!sparsegrid) {BiasGrid_=Tools::make_unique<Grid>(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
       else {BiasGrid_=Tools::make_unique<SparseGrid>(funcl,getArguments(),gmin,gmax,gbin,spline,true);}
       std::vector<std::string> actualmin=BiasGrid_->getMin();
       std::vector<std::string> actualmax=BiasGrid_->getMax();
@@ -1191,7 +1332,7 @@ MetaD::MetaD(const ActionOptions& ao):
         error("The GRID file you want to read: " + gridreadfilename_ + ", cannot be found!");
       }
       std::string funcl=getLabel() + ".bias";
-      BiasGrid_=GridBase::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true);
+      BiasGrid_=GridBase::create(funcl, getArguments(), gridfile, gmin, gmax, gbin, sparsegrid, spline, true, blockgrid);
       if(BiasGrid_->getDimension()!=getNumberOfArguments()) error("mismatch between dimensionality of input grid and number of arguments");
       for(unsigned i=0; i<getNumberOfArguments(); ++i) {
         if( getPntrToArgument(i)->isPeriodic()!=BiasGrid_->getIsPeriodic()[i] ) error("periodicity mismatch between arguments and input bias");
@@ -1206,6 +1347,19 @@ MetaD::MetaD(const ActionOptions& ao):
     }
   }
 
+  // restore hills and grid from the binary checkpoint, if available
+  // this is not possible with file-based multiple walkers, since the other walkers files must be read anyway
+  bool restartedFromCheckpoint=false;
+  Checkpoint* cpt=(getRestart() ? plumed.getRestartCheckpoint(getLabel()) : NULL);
+  if(cpt) {
+    if(mw_n_>1) log.printf("  WARNING: binary checkpoint cannot be used with WALKERS_N, hills will be read from files\n");
+    else {
+      restoreCheckpoint(*cpt);
+      restartedFromCheckpoint=true;
+      restartedFromGrid=grid_;
+    }
+  }
+
   // if we are restarting from GRID and using WALKERS_MPI we can check that all walkers have actually read the grid
   if(getRestart()&&walkers_mpi_) {
     std::vector<int> restarted(mpi_nw_,0);
@@ -1257,7 +1411,7 @@ MetaD::MetaD(const ActionOptions& ao):
     ifile->link(*this);
     if(ifile->FileExist(fname)) {
       ifile->open(fname);
-      if(getRestart()&&!restartedFromGrid) {
+      if(getRestart()&&!restartedFromGrid&&!restartedFromCheckpoint) {
         log.printf("  Restarting from %s:",ifilesnames_[i].c_str());
         readGaussians(ifiles_[i].get());
         restartedFromHills=true;
@@ -1267,14 +1421,14 @@ MetaD::MetaD(const ActionOptions& ao):
       if(i==mw_id_) ifiles_[i]->close();
     } else {
       // in case a file does not exist and we are restarting, complain that the file was not found
-      if(getRestart()&&!restartedFromGrid) error("restart file "+fname+" not found");
+      if(getRestart()&&!restartedFromGrid&&!restartedFromCheckpoint) error("restart file "+fname+" not found");
     }
   }
 
   // if we are restarting from FILE and using WALKERS_MPI we can check that all walkers have actually read the FILE
   if(getRestart()&&walkers_mpi_) {
     std::vector<int> restarted(mpi_nw_,0);
-    if(comm.Get_rank()==0) multi_sim_comm.Allgather(int(restartedFromHills), restarted);
+    if(comm.Get_rank()==0) multi_sim_comm.Allgather(int(restartedFromHills||restartedFromCheckpoint), restarted);
     comm.Bcast(restarted,0);
     int result = std::accumulate(restarted.begin(),restarted.end(),0);
     if(result!=0&&result!=mpi_nw_) error("in this WALKERS_MPI run some replica have restarted from FILE while other do not!");
@@ -1303,11 +1457,22 @@ MetaD::MetaD(const ActionOptions& ao):
   if(getRestart()) {
     // if this is a restart the neighbor list should be immediately updated
     if(nlist_) nlist_update_=true;
+  }
+  // blocks are only set up when the grid is scanned for the first time,
+  // sparse grids keep scanning only the stored points
+  if(hybrid_>0 && (calc_rct_ || calc_max_bias_ || calc_transition_bias_ || dampfactor_>0.0))
+    error("CALC_RCT, CALC_MAX_BIAS, CALC_TRANSITION_BIAS and DAMPFACTOR cannot be used with GRID_HYBRID, since the grid only contains the older hills");
+  stats_=grid_ && !sparsegrid && (calc_rct_ || calc_max_bias_ || calc_transition_bias_ || dampfactor_>0.0);
+  trans_touched_min_=std::numeric_limits<double>::max();
+  trans_touched_lowered_=false;
+  if(stats_) log.printf("  c(t), maximum and transition bias are recomputed on the whole grid every %u updates\n",stats_refresh_);
+  // these quantities are already stored in the binary checkpoint
+  if(getRestart()&&!restartedFromCheckpoint) {
     // Calculate the Tiwary-Parrinello reweighting factor if we are restarting from previous hills
     if(calc_rct_) computeReweightingFactor();
     // Calculate all special bias quantities desired if restarting with nonzero bias.
     if(calc_max_bias_) {
-      max_bias_ = BiasGrid_->getMaxValue();
+      max_bias_ = getMaxBias();
       getPntrToComponent("maxbias")->set(max_bias_);
     }
     if(calc_transition_bias_) {
@@ -1490,48 +1655,195 @@ void MetaD::writeGaussian(const Gaussian& hill, OFile&file)
   file.printField();
 }
 
-void MetaD::addGaussian(const Gaussian& hill)
+void MetaD::exchangeMPIHills()
 {
-  if(grid_) {
-    size_t ncv=getNumberOfArguments();
-    std::vector<unsigned> nneighb=getGaussianSupport(hill);
-    std::vector<Grid::index_t> neighbors=BiasGrid_->getNeighbors(hill.center,nneighb);
-    std::vector<double> der(ncv);
-    std::vector<double> xx(ncv);
-    if(comm.Get_size()==1) {
-      // for performance reasons and thread safety
-      std::vector<double> dp(ncv);
-      for(size_t i=0; i<neighbors.size(); ++i) {
-        Grid::index_t ineigh=neighbors[i];
-        for(unsigned j=0; j<ncv; ++j) der[j]=0.0;
-        BiasGrid_->getPoint(ineigh,xx);
-        double bias=evaluateGaussianAndDerivatives(xx,hill,der,dp);
-        BiasGrid_->addValueAndDerivatives(ineigh,bias,der);
-      }
-    } else {
-      unsigned stride=comm.Get_size();
-      unsigned rank=comm.Get_rank();
-      std::vector<double> allder(ncv*neighbors.size(),0.0);
-      std::vector<double> n_der(ncv,0.0);
-      std::vector<double> allbias(neighbors.size(),0.0);
-      // for performance reasons and thread safety
-      std::vector<double> dp(ncv);
-      for(unsigned i=rank; i<neighbors.size(); i+=stride) {
-        Grid::index_t ineigh=neighbors[i];
-        for(unsigned j=0; j<ncv; ++j) n_der[j]=0.0;
-        BiasGrid_->getPoint(ineigh,xx);
-        allbias[i]=evaluateGaussianAndDerivatives(xx,hill,n_der,dp);
-        for(unsigned j=0; j<ncv; j++) allder[ncv*i+j]=n_der[j];
-      }
-      comm.Sum(allbias);
-      comm.Sum(allder);
-      for(unsigned i=0; i<neighbors.size(); ++i) {
-        Grid::index_t ineigh=neighbors[i];
-        for(unsigned j=0; j<ncv; ++j) der[j]=allder[ncv*i+j];
-        BiasGrid_->addValueAndDerivatives(ineigh,allbias[i],der);
+  const unsigned ncv=getNumberOfArguments();
+  const unsigned nhills=mpi_pending_.size();
+  const unsigned nsigma=mpi_pending_[0].sigma.size();
+  // each hill is packed as center, sigma, height and multivariate flag
+  const unsigned nrec=ncv+nsigma+2;
+  std::vector<double> mine(nhills*nrec);
+  for(unsigned k=0; k<nhills; k++) {
+    const Gaussian & hill(mpi_pending_[k]);
+    double* rec=&mine[k*nrec];
+    for(unsigned j=0; j<ncv; j++) rec[j]=hill.center[j];
+    for(unsigned j=0; j<nsigma; j++) rec[ncv+j]=hill.sigma[j];
+    // notice that if gamma=1 we store directly -F so this scaling is not necessary:
+    rec[ncv+nsigma]=hill.height*(biasf_>1.0?biasf_/(biasf_-1.0):1.0);
+    rec[ncv+nsigma+1]=(hill.multivariate?1.0:0.0);
+  }
+  mpi_pending_.clear();
+
+  // Allocate arrays to store all walkers hills
+  std::vector<double> all(mpi_nw_*nhills*nrec,0.0);
+  // Communicate (only root)
+  if(comm.Get_rank()==0) multi_sim_comm.Allgather(mine,all);
+  // Share info with group members
+  comm.Bcast(all,0);
+
+  // Flying Gaussian
+  if (flying_) {
+    hills_.clear();
+    comm.Barrier();
+  }
+
+  // hills are added in the order in which they were deposited and, for each deposition, by walker
+  std::vector<Gaussian> newhills;
+  newhills.reserve(mpi_nw_*nhills);
+  // notice that if gamma=1 we store directly -F so this scaling is not necessary:
+  double fact=(biasf_>1.0?(biasf_-1.0)/biasf_:1.0);
+  for(unsigned k=0; k<nhills; k++) {
+    for(unsigned i=0; i<mpi_nw_; i++) {
+      const double* rec=&all[(i*nhills+k)*nrec];
+      std::vector<double> cv_now(rec,rec+ncv);
+      std::vector<double> sigma_now(rec+ncv,rec+ncv+nsigma);
+      newhills.push_back(Gaussian(rec[ncv+nsigma+1]>0.5,rec[ncv+nsigma]*fact,cv_now,sigma_now));
+    }
+  }
+  if(mpi_shard_ && hybrid_==0) addGaussiansSharded(newhills);
+  else for(const auto & hill : newhills) addGaussian(hill);
+  if(!flying_) for(const auto & hill : newhills) writeGaussian(hill,hillsOfile_);
+}
+
+namespace {
+// concatenates the buffers of all the processes of comm, in order of rank, on all of them
+template <class T>
+void allgatherBuffers(Communicator& comm,const std::vector<T>& mine,std::vector<T>& all) {
+  const int n=comm.Get_size();
+  const int count=mine.size();
+  std::vector<int> counts(n),displs(n);
+  comm.Allgather(count,counts);
+  displs[0]=0;
+  for(int i=1; i<n; i++) displs[i]=displs[i-1]+counts[i-1];
+  all.resize(displs[n-1]+counts[n-1]);
+  if(all.empty()) return;
+  // a null pointer would be taken as MPI_IN_PLACE, so empty buffers point to a dummy element
+  T dummy=T();
+  comm.Allgatherv(mine.empty()?&dummy:mine.data(),count,all.data(),counts.data(),displs.data());
+}
+}
+
+void MetaD::addGaussiansSharded(const std::vector<Gaussian>& hills)
+{
+  const unsigned ncv=getNumberOfArguments();
+  // the hills are split among all the processes of all the walkers:
+  // each of them enumerates and evaluates only the grid points touched by its own hills
+  const unsigned stride=mpi_nw_*comm.Get_size();
+  const unsigned rank=mpi_id_*comm.Get_size()+comm.Get_rank();
+  // points touched by the local hills, each with the bias and its derivatives
+  std::vector<Grid::index_t> points;
+  std::vector<double> values;
+  std::unordered_map<Grid::index_t,unsigned> where;
+  std::vector<double> xx(ncv);
+  std::vector<double> n_der(ncv);
+  // for performance reasons and thread safety
+  std::vector<double> dp(ncv);
+  for(unsigned k=rank; k<hills.size(); k+=stride) {
+    const std::vector<Grid::index_t> neighbors=BiasGrid_->getNeighbors(hills[k].center,getGaussianSupport(hills[k]));
+    for(const auto & ineigh : neighbors) {
+      const auto w=where.insert(std::make_pair(ineigh,unsigned(points.size())));
+      if(w.second) {
+        points.push_back(ineigh);
+        values.resize(values.size()+ncv+1,0.0);
       }
+      double* v=&values[(ncv+1)*w.first->second];
+      for(unsigned j=0; j<ncv; ++j) n_der[j]=0.0;
+      BiasGrid_->getPoint(ineigh,xx);
+      v[0]+=evaluateGaussianAndDerivatives(xx,hills[k],n_der,dp);
+      for(unsigned j=0; j<ncv; j++) v[1+j]+=n_der[j];
     }
-  } else hills_.push_back(hill);
+  }
+
+  // only the touched points are communicated, first within each walker and then among the walkers
+  std::vector<Grid::index_t> allpoints;
+  std::vector<double> allvalues;
+  allgatherBuffers(comm,points,allpoints);
+  allgatherBuffers(comm,values,allvalues);
+  if(comm.Get_rank()==0) {
+    allgatherBuffers(multi_sim_comm,allpoints,points);
+    allgatherBuffers(multi_sim_comm,allvalues,values);
+    allpoints.swap(points);
+    allvalues.swap(values);
+  }
+  unsigned long npoints=allpoints.size();
+  comm.Bcast(npoints,0);
+  allpoints.resize(npoints);
+  allvalues.resize((ncv+1)*npoints);
+  if(npoints>0) {
+    comm.Bcast(allpoints,0);
+    comm.Bcast(allvalues,0);
+  }
+
+  // all the processes add the contributions in the same order, so that their grids stay identical
+  std::vector<double> der(ncv);
+  for(unsigned long i=0; i<npoints; ++i) {
+    const double* v=&allvalues[(ncv+1)*i];
+    for(unsigned j=0; j<ncv; ++j) der[j]=v[1+j];
+    if(stats_) markBiasChanged(allpoints[i],BiasGrid_->getValue(allpoints[i]),v[0]);
+    BiasGrid_->addValueAndDerivatives(allpoints[i],v[0],der);
+  }
+}
+
+void MetaD::addGaussian(const Gaussian& hill)
+{
+  if(grid_ && hybrid_==0) addGaussianToGrid(hill);
+  else {
+    hills_.push_back(hill);
+    if(hybrid_>0 && hills_.size()>=2*hybrid_) projectOldHills();
+  }
+}
+
+void MetaD::projectOldHills()
+{
+  // all the walkers have the same list of hills, so that they can share the projection
+  std::vector<Gaussian> old(hills_.begin(),hills_.begin()+hybrid_);
+  hills_.erase(hills_.begin(),hills_.begin()+hybrid_);
+  if(mpi_shard_) addGaussiansSharded(old);
+  else for(const auto & hill : old) addGaussianToGrid(hill);
+}
+
+void MetaD::addGaussianToGrid(const Gaussian& hill)
+{
+  size_t ncv=getNumberOfArguments();
+  std::vector<unsigned> nneighb=getGaussianSupport(hill);
+  std::vector<Grid::index_t> neighbors=BiasGrid_->getNeighbors(hill.center,nneighb);
+  std::vector<double> der(ncv);
+  std::vector<double> xx(ncv);
+  if(comm.Get_size()==1) {
+    // for performance reasons and thread safety
+    std::vector<double> dp(ncv);
+    for(size_t i=0; i<neighbors.size(); ++i) {
+      Grid::index_t ineigh=neighbors[i];
+      for(unsigned j=0; j<ncv; ++j) der[j]=0.0;
+      BiasGrid_->getPoint(ineigh,xx);
+      double bias=evaluateGaussianAndDerivatives(xx,hill,der,dp);
+      if(stats_) markBiasChanged(ineigh,BiasGrid_->getValue(ineigh),bias);
+      BiasGrid_->addValueAndDerivatives(ineigh,bias,der);
+    }
+  } else {
+    unsigned stride=comm.Get_size();
+    unsigned rank=comm.Get_rank();
+    std::vector<double> allder(ncv*neighbors.size(),0.0);
+    std::vector<double> n_der(ncv,0.0);
+    std::vector<double> allbias(neighbors.size(),0.0);
+    // for performance reasons and thread safety
+    std::vector<double> dp(ncv);
+    for(unsigned i=rank; i<neighbors.size(); i+=stride) {
+      Grid::index_t ineigh=neighbors[i];
+      for(unsigned j=0; j<ncv; ++j) n_der[j]=0.0;
+      BiasGrid_->getPoint(ineigh,xx);
+      allbias[i]=evaluateGaussianAndDerivatives(xx,hill,n_der,dp);
+      for(unsigned j=0; j<ncv; j++) allder[ncv*i+j]=n_der[j];
+    }
+    comm.Sum(allbias);
+    comm.Sum(allder);
+    for(unsigned i=0; i<neighbors.size(); ++i) {
+      Grid::index_t ineigh=neighbors[i];
+      for(unsigned j=0; j<ncv; ++j) der[j]=allder[ncv*i+j];
+      if(stats_) markBiasChanged(ineigh,BiasGrid_->getValue(ineigh),allbias[i]);
+      BiasGrid_->addValueAndDerivatives(ineigh,allbias[i],der);
+    }
+  }
 }
 
 std::vector<unsigned> MetaD::getGaussianSupport(const Gaussian& hill)
@@ -1591,8 +1903,7 @@ std::vector<unsigned> MetaD::getGaussianSupport(const Gaussian& hill)
 double MetaD::getBias(const std::vector<double>& cv)
 {
   double bias=0.0;
-  if(grid_) bias = BiasGrid_->getValue(cv);
-  else {
+  if(!grid_ || hybrid_>0) {
     unsigned nt=OpenMP::getNumThreads();
     unsigned stride=comm.Get_size();
     unsigned rank=comm.Get_rank();
@@ -1612,6 +1923,9 @@ double MetaD::getBias(const std::vector<double>& cv)
     }
     comm.Sum(bias);
   }
+  if(grid_) bias+=BiasGrid_->getValue(cv);
+  // hills of this walker that have not been exchanged with the other walkers yet
+  for(const auto & hill : mpi_pending_) bias+=evaluateGaussian(cv,hill);
 
   return bias;
 }
@@ -1620,61 +1934,47 @@ double MetaD::getBiasAndDerivatives(const std::vector<double>& cv, std::vector<d
 {
   unsigned ncv=getNumberOfArguments();
   double bias=0.0;
-  if(grid_) {
-    std::vector<double> vder(ncv);
-    bias=BiasGrid_->getValueAndDerivatives(cv,vder);
-    for(unsigned i=0; i<ncv; i++) der[i]=vder[i];
-  } else {
+  if(!grid_ || hybrid_>0) {
     unsigned nt=OpenMP::getNumThreads();
     unsigned stride=comm.Get_size();
     unsigned rank=comm.Get_rank();
 
-    if(!nlist_) {
-      if(hills_.size()<2*nt*stride||nt==1) {
-        // for performance reasons and thread safety
-        std::vector<double> dp(ncv);
-        for(unsigned i=rank; i<hills_.size(); i+=stride) {
-          bias+=evaluateGaussianAndDerivatives(cv,hills_[i],der,dp);
-        }
-      } else {
-        #pragma omp parallel num_threads(nt)
-        {
-          std::vector<double> omp_deriv(ncv,0.);
-          // for performance reasons and thread safety
-          std::vector<double> dp(ncv);
-          #pragma omp for reduction(+:bias) nowait
-          for(unsigned i=rank; i<hills_.size(); i+=stride) {
-            bias+=evaluateGaussianAndDerivatives(cv,hills_[i],omp_deriv,dp);
-          }
-          #pragma omp critical
-          for(unsigned i=0; i<ncv; i++) der[i]+=omp_deriv[i];
-        }
+    const std::vector<Gaussian> & hills(nlist_?nlist_hills_:hills_);
+    nt=tuner_.begin(hills.size()/stride,(hills_.size()<2*nt*stride||nt==1)?1:nt);
+    if(nt==1) {
+      // for performance reasons and thread safety
+      std::vector<double> dp(ncv);
+      for(unsigned i=rank; i<hills.size(); i+=stride) {
+        bias+=evaluateGaussianAndDerivatives(cv,hills[i],der,dp);
       }
     } else {
-      if(hills_.size()<2*nt*stride||nt==1) {
+      #pragma omp parallel num_threads(nt)
+      {
+        std::vector<double> omp_deriv(ncv,0.);
         // for performance reasons and thread safety
         std::vector<double> dp(ncv);
-        for(unsigned i=rank; i<nlist_hills_.size(); i+=stride) {
-          bias+=evaluateGaussianAndDerivatives(cv,nlist_hills_[i],der,dp);
-        }
-      } else {
-        #pragma omp parallel num_threads(nt)
-        {
-          std::vector<double> omp_deriv(ncv,0.);
-          // for performance reasons and thread safety
-          std::vector<double> dp(ncv);
-          #pragma omp for reduction(+:bias) nowait
-          for(unsigned i=rank; i<nlist_hills_.size(); i+=stride) {
-            bias+=evaluateGaussianAndDerivatives(cv,nlist_hills_[i],omp_deriv,dp);
-          }
-          #pragma omp critical
-          for(unsigned i=0; i<ncv; i++) der[i]+=omp_deriv[i];
+        #pragma omp for reduction(+:bias) nowait
+        for(unsigned i=rank; i<hills.size(); i+=stride) {
+          bias+=evaluateGaussianAndDerivatives(cv,hills[i],omp_deriv,dp);
         }
+        #pragma omp critical
+        for(unsigned i=0; i<ncv; i++) der[i]+=omp_deriv[i];
       }
     }
+    tuner_.end();
     comm.Sum(bias);
     comm.Sum(der);
   }
+  if(grid_) {
+    std::vector<double> vder(ncv);
+    bias+=BiasGrid_->getValueAndDerivatives(cv,vder);
+    for(unsigned i=0; i<ncv; i++) der[i]+=vder[i];
+  }
+  // hills of this walker that have not been exchanged with the other walkers yet
+  if(!mpi_pending_.empty()) {
+    std::vector<double> dp(ncv);
+    for(const auto & hill : mpi_pending_) bias+=evaluateGaussianAndDerivatives(cv,hill,der,dp);
+  }
 
   return bias;
 }
@@ -1848,7 +2148,7 @@ double MetaD::getHeight(const std::vector<double>& cv)
   }
   if(dampfactor_>0.0) {
     plumed_assert(BiasGrid_);
-    double m=BiasGrid_->getMaxValue();
+    double m=getMaxBias();
     height*=std::exp(-m/(kbt_*(dampfactor_)));
   }
   if (tt_specs_.is_active) {
@@ -1907,6 +2207,9 @@ void MetaD::calculate()
     acc_ += static_cast<double>(getStride()) * std::exp(ene/(kbt_));
     const double mean_acc = acc_/((double) getStep());
     getPntrToComponent("acc")->set(mean_acc);
+  } else if (acceleration_ && isFirstStep_ && acc_ > 0.0 && getStep() > 0) {
+    // acceleration restored from a binary checkpoint
+    getPntrToComponent("acc")->set(acc_/((double) getStep()));
   } else if (acceleration_ && isFirstStep_ && acc_restart_mean_ > 0.0) {
     acc_ = acc_restart_mean_ * static_cast<double>(getStep());
     if(freq_adaptive_) {
@@ -1950,44 +2253,10 @@ void MetaD::update()
     else thissigma=sigma0_;
 
     // In case we use walkers_mpi, it is now necessary to communicate with other replicas.
+    // The hill is felt immediately by this walker, and the hills are exchanged every mpi_stride_ depositions
     if(walkers_mpi_) {
-      // Allocate arrays to store all walkers hills
-      std::vector<double> all_cv(mpi_nw_*ncv,0.0);
-      std::vector<double> all_sigma(mpi_nw_*thissigma.size(),0.0);
-      std::vector<double> all_height(mpi_nw_,0.0);
-      std::vector<int>    all_multivariate(mpi_nw_,0);
-      if(comm.Get_rank()==0) {
-        // Communicate (only root)
-        multi_sim_comm.Allgather(cv,all_cv);
-        multi_sim_comm.Allgather(thissigma,all_sigma);
-        // notice that if gamma=1 we store directly -F so this scaling is not necessary:
-        multi_sim_comm.Allgather(height*(biasf_>1.0?biasf_/(biasf_-1.0):1.0),all_height);
-        multi_sim_comm.Allgather(int(multivariate),all_multivariate);
-      }
-      // Share info with group members
-      comm.Bcast(all_cv,0);
-      comm.Bcast(all_sigma,0);
-      comm.Bcast(all_height,0);
-      comm.Bcast(all_multivariate,0);
-
-      // Flying Gaussian
-      if (flying_) {
-        hills_.clear();
-        comm.Barrier();
-      }
-
-      for(unsigned i=0; i<mpi_nw_; i++) {
-        // actually add hills one by one
-        std::vector<double> cv_now(ncv);
-        std::vector<double> sigma_now(thissigma.size());
-        for(unsigned j=0; j<ncv; j++) cv_now[j]=all_cv[i*ncv+j];
-        for(unsigned j=0; j<thissigma.size(); j++) sigma_now[j]=all_sigma[i*thissigma.size()+j];
-        // notice that if gamma=1 we store directly -F so this scaling is not necessary:
-        double fact=(biasf_>1.0?(biasf_-1.0)/biasf_:1.0);
-        Gaussian newhill=Gaussian(all_multivariate[i],all_height[i]*fact,cv_now,sigma_now);
-        addGaussian(newhill);
-        if(!flying_) writeGaussian(newhill,hillsOfile_);
-      }
+      mpi_pending_.push_back(Gaussian(multivariate,height,cv,thissigma));
+      if(mpi_pending_.size()>=mpi_stride_) exchangeMPIHills();
     } else {
       Gaussian newhill=Gaussian(multivariate,height,cv,thissigma);
       addGaussian(newhill);
@@ -2058,15 +2327,21 @@ void MetaD::update()
 
   // Recalculate special bias quantities whenever the bias has been changed by the update.
   bool bias_has_changed = (nowAddAHill || (mw_n_ > 1 && getStep() % mw_rstride_ == 0));
+  if (stats_ && bias_has_changed) {
+    // every now and then forget the block statistics so that they are recomputed from scratch
+    stats_nupdates_++;
+    if(stats_nupdates_>=stats_refresh_) {
+      stats_nupdates_=0;
+      block_max_.clear();
+      trans_touched_min_=-std::numeric_limits<double>::max();
+    }
+  }
   if (calc_rct_ && bias_has_changed && getStep()%(stride_*rct_ustride_)==0) computeReweightingFactor();
   if (calc_max_bias_ && bias_has_changed) {
-    max_bias_ = BiasGrid_->getMaxValue();
+    max_bias_ = getMaxBias();
     getPntrToComponent("maxbias")->set(max_bias_);
   }
-  if (calc_transition_bias_ && bias_has_changed) {
-    transition_bias_ = getTransitionBarrierBias();
-    getPntrToComponent("transbias")->set(transition_bias_);
-  }
+  if (calc_transition_bias_ && bias_has_changed) updateTransitionBias();
 
   // Frequency adaptive metadynamics - update hill addition frequency
   if(freq_adaptive_ && getStep()%fa_update_frequency_==0) {
@@ -2074,6 +2349,112 @@ void MetaD::update()
   }
 }
 
+void MetaD::runFinalJobs()
+{
+  // hills still waiting to be exchanged at the end of the simulation would be lost otherwise
+  if(walkers_mpi_ && !mpi_pending_.empty()) {
+    exchangeMPIHills();
+    hillsOfile_.flush();
+  }
+}
+
+void MetaD::saveCheckpoint(Checkpoint& cpt)
+{
+  // hills still waiting to be exchanged are not stored: they are exchanged now,
+  // so that the checkpoint and the HILLS file contain the same hills
+  if(walkers_mpi_ && !mpi_pending_.empty()) {
+    exchangeMPIHills();
+    hillsOfile_.flush();
+    if(calc_max_bias_) {
+      max_bias_ = getMaxBias();
+      getPntrToComponent("maxbias")->set(max_bias_);
+    }
+    if(calc_transition_bias_) updateTransitionBias();
+  }
+  std::vector<int> multivariate(hills_.size());
+  std::vector<double> height(hills_.size());
+  std::vector<double> center;
+  std::vector<double> sigma;
+  for(unsigned i=0; i<hills_.size(); ++i) {
+    multivariate[i]=hills_[i].multivariate;
+    height[i]=hills_[i].height;
+    center.insert(center.end(),hills_[i].center.begin(),hills_[i].center.end());
+    sigma.insert(sigma.end(),hills_[i].sigma.begin(),hills_[i].sigma.end());
+  }
+  cpt.beginSection(getLabel());
+  cpt.put(getNumberOfArguments());
+  cpt.put(multivariate);
+  cpt.put(height);
+  cpt.put(center);
+  cpt.put(sigma);
+  cpt.put(grid_);
+  if(grid_) BiasGrid_->saveCheckpoint(cpt);
+  cpt.put(adaptive_);
+  if(adaptive_!=FlexibleBin::none) flexbin_->saveCheckpoint(cpt);
+  cpt.put(acc_);
+  cpt.put(work_);
+  cpt.put(reweight_factor_);
+  cpt.put(max_bias_);
+  cpt.put(transition_bias_);
+  cpt.put(current_stride_);
+  cpt.endSection();
+}
+
+void MetaD::restoreCheckpoint(Checkpoint& cpt)
+{
+  unsigned ncv=getNumberOfArguments();
+  unsigned cpt_ncv;
+  std::vector<int> multivariate;
+  std::vector<double> height;
+  std::vector<double> center;
+  std::vector<double> sigma;
+  bool cpt_grid;
+  int cpt_adaptive;
+  cpt.openSection(getLabel());
+  cpt.get(cpt_ncv);
+  if(cpt_ncv!=ncv) error("number of arguments in the binary checkpoint does not match input");
+  cpt.get(multivariate);
+  cpt.get(height);
+  cpt.get(center);
+  cpt.get(sigma);
+  cpt.get(cpt_grid);
+  if(cpt_grid!=grid_) error("binary checkpoint was written with a different GRID setting");
+  if(grid_) BiasGrid_->restoreCheckpoint(cpt);
+  cpt.get(cpt_adaptive);
+  if(cpt_adaptive!=adaptive_) error("binary checkpoint was written with a different ADAPTIVE setting");
+  if(adaptive_!=FlexibleBin::none) flexbin_->restoreCheckpoint(cpt);
+  cpt.get(acc_);
+  cpt.get(work_);
+  cpt.get(reweight_factor_);
+  cpt.get(max_bias_);
+  cpt.get(transition_bias_);
+  cpt.get(current_stride_);
+  cpt.closeSection();
+  // block statistics refer to the grid before the restart
+  block_max_.clear();
+
+  hills_.clear();
+  hills_.reserve(height.size());
+  unsigned ic=0, is=0;
+  for(unsigned i=0; i<height.size(); ++i) {
+    unsigned nsigma=(multivariate[i] ? ncv*(ncv+1)/2 : ncv);
+    if(ic+ncv>center.size() || is+nsigma>sigma.size()) error("corrupted hills in the binary checkpoint");
+    std::vector<double> c(center.begin()+ic,center.begin()+ic+ncv);
+    std::vector<double> s(sigma.begin()+is,sigma.begin()+is+nsigma);
+    hills_.push_back(Gaussian(multivariate[i],height[i],c,s));
+    ic+=ncv; is+=nsigma;
+  }
+  // the acceleration factor is restored directly, there is no need to reconstruct it at the first step
+  acc_restart_mean_=0.0;
+
+  if(calc_work_) getPntrToComponent("work")->set(work_);
+  if(calc_rct_) getPntrToComponent("rct")->set(reweight_factor_);
+  if(calc_max_bias_) getPntrToComponent("maxbias")->set(max_bias_);
+  if(calc_transition_bias_) getPntrToComponent("transbias")->set(transition_bias_);
+  if(freq_adaptive_) getPntrToComponent("pace")->set(current_stride_);
+  log.printf("  Restarting from binary checkpoint: %u Gaussians read\n",unsigned(hills_.size()));
+}
+
 /// takes a pointer to the file and a template std::string with values v and gives back the next center, sigma and height
 bool MetaD::scanOneHill(IFile* ifile, std::vector<Value>& tmpvalues, std::vector<double>& center, std::vector<double>& sigma, double& height, bool& multivariate)
 {
@@ -2153,26 +2534,169 @@ void MetaD::computeReweightingFactor()
 
   double Z_0=0; //proportional to the integral of exp(-beta*F)
   double Z_V=0; //proportional to the integral of exp(-beta*(F+V))
-  double minusBetaF=biasf_/(biasf_-1.)/kbt_;
-  double minusBetaFplusV=1./(biasf_-1.)/kbt_;
+  double minusBetaF,minusBetaFplusV;
+  getReweightingExponents(minusBetaF,minusBetaFplusV);
+  max_bias_=getMaxBias(); //to avoid exp overflow
+
+  // without block statistics (e.g. with sparse grids) the whole grid is scanned,
+  // the points that are not stored in a sparse grid have zero bias
+  if(!stats_) {
+    const unsigned rank=comm.Get_rank();
+    const unsigned stride=comm.Get_size();
+    const SparseGrid* sparse=dynamic_cast<const SparseGrid*>(BiasGrid_.get());
+    const Grid::index_t size=(sparse ? sparse->getMaxSize() : BiasGrid_->getSize());
+    for (Grid::index_t t=rank; t<size; t+=stride) {
+      const double val=BiasGrid_->getValue(t);
+      Z_0+=std::exp(minusBetaF*(val-max_bias_));
+      Z_V+=std::exp(minusBetaFplusV*(val-max_bias_));
+    }
+    comm.Sum(Z_0);
+    comm.Sum(Z_V);
+    reweight_factor_=kbt_*std::log(Z_0/Z_V)+max_bias_;
+    getPntrToComponent("rct")->set(reweight_factor_);
+    return;
+  }
+
+  // the partial sums of the blocks are stored shifted by block_zref_,
+  // if the maximum has changed they are just rescaled
+  if(max_bias_!=block_zref_) {
+    const double f0=std::exp(minusBetaF*(block_zref_-max_bias_));
+    const double fv=std::exp(minusBetaFplusV*(block_zref_-max_bias_));
+    for(unsigned k=0; k<block_z0_.size(); k++) {
+      block_z0_[k]*=f0;
+      block_zv_[k]*=fv;
+    }
+    block_zref_=max_bias_;
+  }
+  // then the blocks touched since the last call are recomputed
+  const Grid::index_t size=BiasGrid_->getSize();
+  const unsigned nt=OpenMP::getNumThreads();
+  #pragma omp parallel for num_threads(nt)
+  for(unsigned k=0; k<dirty_rct_.size(); k++) {
+    const Grid::index_t ib=dirty_rct_[k];
+    const Grid::index_t end=std::min(size,(ib+1)*stats_blocksize_);
+    double z0=0.0, zv=0.0;
+    for(Grid::index_t t=ib*stats_blocksize_; t<end; t++) {
+      const double val=BiasGrid_->getValue(t);
+      z0+=std::exp(minusBetaF*(val-max_bias_));
+      zv+=std::exp(minusBetaFplusV*(val-max_bias_));
+    }
+    block_z0_[ib]=z0;
+    block_zv_[ib]=zv;
+    block_dirty_rct_[ib]=0;
+  }
+  dirty_rct_.clear();
+
+  for(unsigned k=0; k<block_z0_.size(); k++) {
+    Z_0+=block_z0_[k];
+    Z_V+=block_zv_[k];
+  }
+
+  reweight_factor_=kbt_*std::log(Z_0/Z_V)+max_bias_;
+  getPntrToComponent("rct")->set(reweight_factor_);
+}
+
+void MetaD::getReweightingExponents(double& minusBetaF, double& minusBetaFplusV)
+{
+  minusBetaF=biasf_/(biasf_-1.)/kbt_;
+  minusBetaFplusV=1./(biasf_-1.)/kbt_;
   if (biasf_==-1.0) { //non well-tempered case
     minusBetaF=1./kbt_;
     minusBetaFplusV=0;
   }
-  max_bias_=BiasGrid_->getMaxValue(); //to avoid exp overflow
+}
+
+void MetaD::markBiasChanged(Grid::index_t index, double oldvalue, double added)
+{
+  if(added>0.0) trans_touched_min_=std::min(trans_touched_min_,oldvalue);
+  else if(added<0.0) trans_touched_lowered_=true;
+  if(block_max_.empty()) return;
+  const Grid::index_t ib=index/stats_blocksize_;
+  if(!block_dirty_max_[ib]) {
+    block_dirty_max_[ib]=1;
+    dirty_max_.push_back(ib);
+  }
+  if(!block_dirty_rct_[ib]) {
+    block_dirty_rct_[ib]=1;
+    dirty_rct_.push_back(ib);
+  }
+}
 
+void MetaD::refreshBlockStats()
+{
+  // scan the whole grid, the blocks are shared among the MPI processes
+  const Grid::index_t size=BiasGrid_->getSize();
+  const Grid::index_t nblocks=(size+stats_blocksize_-1)/stats_blocksize_;
   const unsigned rank=comm.Get_rank();
   const unsigned stride=comm.Get_size();
-  for (Grid::index_t t=rank; t<BiasGrid_->getSize(); t+=stride) {
-    const double val=BiasGrid_->getValue(t);
-    Z_0+=std::exp(minusBetaF*(val-max_bias_));
-    Z_V+=std::exp(minusBetaFplusV*(val-max_bias_));
+  block_max_.assign(nblocks,0.0);
+  for(Grid::index_t ib=rank; ib<nblocks; ib+=stride) {
+    const Grid::index_t end=std::min(size,(ib+1)*stats_blocksize_);
+    double m=-std::numeric_limits<double>::max();
+    for(Grid::index_t t=ib*stats_blocksize_; t<end; t++) m=std::max(m,BiasGrid_->getValue(t));
+    block_max_[ib]=m;
+  }
+  comm.Sum(block_max_);
+  double maxbias=-std::numeric_limits<double>::max();
+  for(const auto & m : block_max_) maxbias=std::max(maxbias,m);
+
+  block_z0_.assign(nblocks,0.0);
+  block_zv_.assign(nblocks,0.0);
+  block_zref_=maxbias;
+  if(calc_rct_ && biasf_!=1.0) {
+    double minusBetaF,minusBetaFplusV;
+    getReweightingExponents(minusBetaF,minusBetaFplusV);
+    for(Grid::index_t ib=rank; ib<nblocks; ib+=stride) {
+      const Grid::index_t end=std::min(size,(ib+1)*stats_blocksize_);
+      for(Grid::index_t t=ib*stats_blocksize_; t<end; t++) {
+        const double val=BiasGrid_->getValue(t);
+        block_z0_[ib]+=std::exp(minusBetaF*(val-maxbias));
+        block_zv_[ib]+=std::exp(minusBetaFplusV*(val-maxbias));
+      }
+    }
+    comm.Sum(block_z0_);
+    comm.Sum(block_zv_);
   }
-  comm.Sum(Z_0);
-  comm.Sum(Z_V);
+  block_dirty_max_.assign(nblocks,0);
+  block_dirty_rct_.assign(nblocks,0);
+  dirty_max_.clear();
+  dirty_rct_.clear();
+}
 
-  reweight_factor_=kbt_*std::log(Z_0/Z_V)+max_bias_;
-  getPntrToComponent("rct")->set(reweight_factor_);
+double MetaD::getMaxBias()
+{
+  if(!stats_) return BiasGrid_->getMaxValue();
+  if(block_max_.empty()) refreshBlockStats();
+  // recompute the maxima of the blocks touched since the last call
+  const Grid::index_t size=BiasGrid_->getSize();
+  const unsigned nt=OpenMP::getNumThreads();
+  #pragma omp parallel for num_threads(nt)
+  for(unsigned k=0; k<dirty_max_.size(); k++) {
+    const Grid::index_t ib=dirty_max_[k];
+    const Grid::index_t end=std::min(size,(ib+1)*stats_blocksize_);
+    double m=-std::numeric_limits<double>::max();
+    for(Grid::index_t t=ib*stats_blocksize_; t<end; t++) m=std::max(m,BiasGrid_->getValue(t));
+    block_max_[ib]=m;
+    block_dirty_max_[ib]=0;
+  }
+  dirty_max_.clear();
+  double maxbias=-std::numeric_limits<double>::max();
+  for(const auto & m : block_max_) maxbias=std::max(maxbias,m);
+  return maxbias;
+}
+
+void MetaD::updateTransitionBias()
+{
+  // if all the points that have been raised were already above the transition bias
+  // and no point has been lowered, the best path cannot have changed.
+  // Changes are only tracked with block statistics, so without them
+  // (e.g. with sparse grids) the transition bias is recomputed after every change
+  if(!stats_ || transitionwells_.size()==1 || trans_touched_lowered_ || !(trans_touched_min_>transition_bias_)) {
+    transition_bias_ = getTransitionBarrierBias();
+    getPntrToComponent("transbias")->set(transition_bias_);
+  }
+  trans_touched_min_=std::numeric_limits<double>::max();
+  trans_touched_lowered_=false;
 }
 
 double MetaD::getTransitionBarrierBias()
@@ -2232,6 +2756,20 @@ bool MetaD::checkNeedsGradients()const
   } else return false;
 }
 
+void MetaD::getMemoryUsage(std::vector<std::pair<std::string,std::size_t> >& usage)const
+{
+  auto hillsMemory=[](const std::vector<Gaussian>& hills) {
+    std::size_t mem=hills.capacity()*sizeof(Gaussian);
+    for(const auto & h : hills) mem+=(h.center.capacity()+h.sigma.capacity()+h.invsigma.capacity())*sizeof(double);
+    return mem;
+  };
+  usage.push_back(std::make_pair("hills",hillsMemory(hills_)));
+  if(nlist_) usage.push_back(std::make_pair("neighbor list of hills",hillsMemory(nlist_hills_)));
+  if(walkers_mpi_) usage.push_back(std::make_pair("pending hills",hillsMemory(mpi_pending_)));
+  if(BiasGrid_) usage.push_back(std::make_pair("bias grid",BiasGrid_->getMemoryUsage()));
+  if(TargetGrid_) usage.push_back(std::make_pair("target grid",TargetGrid_->getMemoryUsage()));
+}
+
 void MetaD::updateNlist()
 {
   // no need to check for neighbors
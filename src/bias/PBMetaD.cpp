@@ -31,6 +31,7 @@
 #include "tools/OpenMP.h"
 #include "tools/Random.h"
 #include "tools/File.h"
+#include "tools/Checkpoint.h"
 #include <ctime>
 #include <numeric>
 #if defined(__PLUMED_HAS_GETCWD)
@@ -143,6 +144,9 @@ boundaries. Note that:
 
 Multiple walkers  \cite multiplewalkers can also be used. See below the examples.
 
+When restarting, the hills (or the grids, if GRID is used) can be read from a binary checkpoint instead
+of the HILLS files, see \ref CHECKPOINT. This is not possible with WALKERS_N.
+
 \par Examples
 
 The following input is for PBMetaD calculation using as
@@ -281,6 +285,7 @@ private:
   double evaluateGaussian(unsigned iarg, const std::vector<double>&, const Gaussian&,double* der=NULL);
   std::vector<unsigned> getGaussianSupport(unsigned iarg, const Gaussian&);
   bool   scanOneHill(unsigned iarg, IFile *ifile,  std::vector<Value> &v, std::vector<double> &center, std::vector<double>  &sigma, double &height, bool &multivariate);
+  void   restoreCheckpoint(Checkpoint&);
 
 public:
   explicit PBMetaD(const ActionOptions&);
@@ -288,6 +293,7 @@ public:
   void update() override;
   static void registerKeywords(Keywords& keys);
   bool checkNeedsGradients()const override;
+  void saveCheckpoint(Checkpoint&) override;
 };
 
 PLUMED_REGISTER_ACTION(PBMetaD,"PBMETAD")
@@ -308,6 +314,7 @@ void PBMetaD::registerKeywords(Keywords& keys) {
   keys.add("optional","GRID_BIN","the number of bins for the grid");
   keys.add("optional","GRID_SPACING","the approximate grid spacing (to be used as an alternative or together with GRID_BIN)");
   keys.addFlag("GRID_SPARSE",false,"use a sparse grid to store hills");
+  keys.addFlag("GRID_BLOCK",false,"use a grid whose bins are allocated in blocks when hills are first deposited there, so that only the explored regions use memory");
   keys.addFlag("GRID_NOSPLINE",false,"don't use spline interpolation with grids");
   keys.add("optional","GRID_WSTRIDE", "frequency for dumping the grid");
   keys.add("optional","GRID_WFILES", "dump grid for the bias, default names are used if GRID_WSTRIDE is used without GRID_WFILES.");
@@ -514,6 +521,9 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
 
   bool sparsegrid=false;
   parseFlag("GRID_SPARSE",sparsegrid);
+  bool blockgrid=false;
+  parseFlag("GRID_BLOCK",blockgrid);
+  if(sparsegrid && blockgrid) error("GRID_SPARSE and GRID_BLOCK cannot be used together");
   bool nospline=false;
   parseFlag("GRID_NOSPLINE",nospline);
   bool spline=!nospline;
@@ -599,6 +609,7 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
     log.printf("\n");
     if(spline) {log.printf("  Grid uses spline interpolation\n");}
     if(sparsegrid) {log.printf("  Grid uses sparse grid\n");}
+    if(blockgrid) {log.printf("  Grid is allocated in blocks where hills are deposited\n");}
     if(wgridstride_>0) {
       for(unsigned i=0; i<gridfilenames_.size(); ++i) {
         log.printf("  Grid is written on file %s with stride %d\n",gridfilenames_[i].c_str(),wgridstride_);
@@ -652,7 +663,7 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
           error("The GRID file you want to read: " + gridreadfilenames_[i] + ", cannot be found!");
         }
         std::string funcl = getLabel() + ".bias";
-        BiasGrid_=GridBase::create(funcl, args, gridfile, gmin_t, gmax_t, gbin_t, sparsegrid, spline, true);
+        BiasGrid_=GridBase::create(funcl, args, gridfile, gmin_t, gmax_t, gbin_t, sparsegrid, spline, true, blockgrid);
         if(BiasGrid_->getDimension() != args.size()) {
           error("mismatch between dimensionality of input grid and number of arguments");
         }
@@ -662,8 +673,9 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
         log.printf("  Restarting from %s:\n",gridreadfilenames_[i].c_str());
         if(getRestart()) restartedFromGrid=true;
       } else {
-        if(!sparsegrid) {BiasGrid_=Tools::make_unique<Grid>(funcl,args,gmin_t,gmax_t,gbin_t,spline,true);}
-        else           {BiasGrid_=Tools::make_unique<SparseGrid>(funcl,args,gmin_t,gmax_t,gbin_t,spline,true);}
+        if(blockgrid)        {BiasGrid_=Tools::make_unique<BlockGrid>(funcl,args,gmin_t,gmax_t,gbin_t,spline,true);}
+        else if(!sparsegrid) {BiasGrid_=Tools::make_unique<Grid>(funcl,args,gmin_t,gmax_t,gbin_t,spline,true);}
+        else                 {BiasGrid_=Tools::make_unique<SparseGrid>(funcl,args,gmin_t,gmax_t,gbin_t,spline,true);}
         std::vector<std::string> actualmin=BiasGrid_->getMin();
         std::vector<std::string> actualmax=BiasGrid_->getMax();
         std::string is;
@@ -675,6 +687,18 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
     }
   }
 
+  // restore hills and grids from the binary checkpoint, if available
+  // this is not possible with file-based multiple walkers, since the other walkers files must be read anyway
+  bool restartedFromCheckpoint=false;
+  Checkpoint* cpt=(getRestart() ? plumed.getRestartCheckpoint(getLabel()) : NULL);
+  if(cpt) {
+    if(mw_n_>1) log.printf("  WARNING: binary checkpoint cannot be used with WALKERS_N, hills will be read from files\n");
+    else {
+      restoreCheckpoint(*cpt);
+      restartedFromCheckpoint=true;
+      log.printf("  Restarting from the binary checkpoint\n");
+    }
+  }
 
 // creating vector of ifile* for hills reading
 // open all files at the beginning and read Gaussians if restarting
@@ -706,7 +730,7 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
       ifilesnames_.push_back(fname);
       if(ifile->FileExist(fname)) {
         ifile->open(fname);
-        if(getRestart()&&!restartedFromGrid) {
+        if(getRestart()&&!restartedFromGrid&&!restartedFromCheckpoint) {
           log.printf("  Restarting from %s:",ifilesnames_[k].c_str());
           readGaussians(i,ifiles_[k].get());
         }
@@ -715,7 +739,7 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
         if(j==mw_id_) ifiles_[k]->close();
       } else {
         // in case a file does not exist and we are restarting, complain that the file was not found
-        if(getRestart()) log<<"  WARNING: restart file "<<fname<<" not found\n";
+        if(getRestart()&&!restartedFromCheckpoint) log<<"  WARNING: restart file "<<fname<<" not found\n";
       }
     }
   }
@@ -785,6 +809,73 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
   log<<"\n";
 }
 
+void PBMetaD::saveCheckpoint(Checkpoint& cpt)
+{
+  cpt.beginSection(getLabel());
+  cpt.put(getNumberOfArguments());
+  cpt.put(grid_);
+  for(unsigned i=0; i<getNumberOfArguments(); ++i) {
+    // with grids the hills are not stored, the grids are enough
+    if(grid_) {
+      BiasGrids_[i]->saveCheckpoint(cpt);
+      continue;
+    }
+    std::vector<int> multivariate(hills_[i].size());
+    std::vector<double> height(hills_[i].size());
+    std::vector<double> center(hills_[i].size());
+    std::vector<double> sigma(hills_[i].size());
+    for(unsigned j=0; j<hills_[i].size(); ++j) {
+      multivariate[j]=hills_[i][j].multivariate;
+      height[j]=hills_[i][j].height;
+      center[j]=hills_[i][j].center[0];
+      sigma[j]=hills_[i][j].sigma[0];
+    }
+    cpt.put(multivariate);
+    cpt.put(height);
+    cpt.put(center);
+    cpt.put(sigma);
+  }
+  cpt.put(adaptive_);
+  for(unsigned i=0; i<flexbin_.size(); ++i) flexbin_[i].saveCheckpoint(cpt);
+  cpt.endSection();
+}
+
+void PBMetaD::restoreCheckpoint(Checkpoint& cpt)
+{
+  unsigned cpt_ncv;
+  bool cpt_grid;
+  int cpt_adaptive;
+  cpt.openSection(getLabel());
+  cpt.get(cpt_ncv);
+  if(cpt_ncv!=getNumberOfArguments()) error("number of arguments in the binary checkpoint does not match input");
+  cpt.get(cpt_grid);
+  if(cpt_grid!=grid_) error("binary checkpoint was written with a different GRID setting");
+  for(unsigned i=0; i<getNumberOfArguments(); ++i) {
+    if(grid_) {
+      BiasGrids_[i]->restoreCheckpoint(cpt);
+      continue;
+    }
+    std::vector<int> multivariate;
+    std::vector<double> height;
+    std::vector<double> center;
+    std::vector<double> sigma;
+    cpt.get(multivariate);
+    cpt.get(height);
+    cpt.get(center);
+    cpt.get(sigma);
+    if(center.size()!=height.size() || sigma.size()!=height.size() || multivariate.size()!=height.size()) error("corrupted hills in the binary checkpoint");
+    hills_[i].clear();
+    hills_[i].reserve(height.size());
+    for(unsigned j=0; j<height.size(); ++j) {
+      hills_[i].push_back(Gaussian(std::vector<double>(1,center[j]),std::vector<double>(1,sigma[j]),height[j],multivariate[j]));
+    }
+  }
+  cpt.get(cpt_adaptive);
+  if(cpt_adaptive!=adaptive_) error("binary checkpoint was written with a different ADAPTIVE setting");
+  for(unsigned i=0; i<flexbin_.size(); ++i) flexbin_[i].restoreCheckpoint(cpt);
+  cpt.closeSection();
+}
+
 void PBMetaD::readGaussians(unsigned iarg, IFile *ifile)
 {
   std::vector<double> center(1);
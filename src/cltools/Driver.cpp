@@ -35,6 +35,7 @@
 #include "tools/PDB.h"
 #include "tools/FileBase.h"
 #include "tools/IFile.h"
+#include "tools/XdrTrajectory.h"
 
 // when using molfile plugin
 #ifdef __PLUMED_HAS_MOLFILE_PLUGINS
@@ -52,10 +53,6 @@ using namespace PLMD::molfile;
 #endif
 #endif
 
-#ifdef __PLUMED_HAS_XDRFILE
-#include <xdrfile/xdrfile_trr.h>
-#include <xdrfile/xdrfile_xtc.h>
-#endif
 
 namespace PLMD {
 namespace cltools {
@@ -164,13 +161,16 @@ plumed driver --plumed plumed.dat --imf_crd trajectory.crd --natoms 128
 
 Check the available molfile plugins and limitations at [this link](http://www.ks.uiuc.edu/Research/vmd/plugins/molfile/).
 
-Additionally, you can use the xdrfile implementation of xtc and trr. To this aim, just
-download and install properly the xdrfile library (see [this link](http://www.gromacs.org/Developer_Zone/Programming_Guide/XTC_Library)).
-If the xdrfile library is installed properly the PLUMED configure script should be able to
-detect it and enable it.
-Notice that the xdrfile implementation of xtc and trr
-is more robust than the molfile one, since it provides support for generic cell shapes.
-In addition, it allows \ref DUMPATOMS to write compressed xtc files.
+Additionally, xtc and trr files can be read with the `--ixtc` and `--itrr` options, that use
+the implementation of these formats contained in PLUMED:
+\verbatim
+plumed driver --plumed plumed.dat --ixtc traj.xtc --trajectory-stride 0 --timestep 0.001
+\endverbatim
+This implementation is more robust than the molfile one, since it provides support for generic cell shapes,
+and it is faster, since several frames are decompressed at the same time using OpenMP threads.
+In addition, with `--trajectory-stride 0` the step number is read from the trajectory.
+As for the other formats, a box given with `--box` replaces the one stored in the trajectory.
+The same implementation allows \ref DUMPATOMS to write xtc and trr files.
 
 
 */
@@ -212,11 +212,8 @@ void Driver<real>::registerKeywords( Keywords& keys ) {
   keys.add("compulsory","--plumed","plumed.dat","specify the name of the plumed input file");
   keys.add("compulsory","--timestep","1.0","the timestep that was used in the calculation that produced this trajectory in picoseconds");
   keys.add("compulsory","--trajectory-stride","1","the frequency with which frames were output to this trajectory during the simulation"
-#ifdef __PLUMED_HAS_XDRFILE
            " (0 means that the number of the step is read from the trajectory file,"
-           " currently working only for xtc/trr files read with --ixtc/--trr)"
-#endif
-          );
+           " currently working only for xtc/trr files read with --ixtc/--trr)");
   keys.add("compulsory","--multi","0","set number of replicas for multi environment (needs MPI)");
   keys.addFlag("--noatoms",false,"don't read in a trajectory.  Just use colvar files as specified in plumed.dat");
   keys.addFlag("--parse-only",false,"read the plumed input file and stop");
@@ -224,10 +221,8 @@ void Driver<real>::registerKeywords( Keywords& keys ) {
   keys.add("atoms","--ixyz","the trajectory in xyz format");
   keys.add("atoms","--igro","the trajectory in gro format");
   keys.add("atoms","--idlp4","the trajectory in DL_POLY_4 format");
-#ifdef __PLUMED_HAS_XDRFILE
-  keys.add("atoms","--ixtc","the trajectory in xtc format (xdrfile implementation)");
-  keys.add("atoms","--itrr","the trajectory in trr format (xdrfile implementation)");
-#endif
+  keys.add("atoms","--ixtc","the trajectory in xtc format");
+  keys.add("atoms","--itrr","the trajectory in trr format");
   keys.add("optional","--length-units","units for length, either as a string or a number");
   keys.add("optional","--mass-units","units for mass in pdb and mc file, either as a string or a number");
   keys.add("optional","--charge-units","units for charge in pdb and mc file, either as a string or a number");
@@ -405,10 +400,8 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
     std::string traj_dlp4; parse("--idlp4",traj_dlp4);
     std::string traj_xtc;
     std::string traj_trr;
-#ifdef __PLUMED_HAS_XDRFILE
     parse("--ixtc",traj_xtc);
     parse("--itrr",traj_trr);
-#endif
 #ifdef __PLUMED_HAS_MOLFILE_PLUGINS
     for(unsigned i=0; i<plugins.size(); i++) {
       std::string molfile_key="--mf_"+std::string(plugins[i]->name);
@@ -541,9 +534,8 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
 
 
   FILE* fp=NULL; FILE* fp_forces=NULL; OFile fp_dforces;
-#ifdef __PLUMED_HAS_XDRFILE
-  XDRFILE* xd=NULL;
-#endif
+  std::unique_ptr<XdrReader> xdr;
+  XdrFrame xdrFrame;
   if(!noatoms&&!parseOnly) {
     if (trajectoryFile=="-")
       fp=in;
@@ -566,16 +558,8 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
         ts_in.coords = ts_in_coords.get();
 #endif
       } else if(trajectory_fmt=="xdr-xtc" || trajectory_fmt=="xdr-trr") {
-#ifdef __PLUMED_HAS_XDRFILE
-        xd=xdrfile_open(trajectoryFile.c_str(),"r");
-        if(!xd) {
-          std::string msg="ERROR: Error opening trajectory file "+trajectoryFile;
-          fprintf(stderr,"%s\n",msg.c_str());
-          return 1;
-        }
-        if(trajectory_fmt=="xdr-xtc") read_xtc_natoms(&trajectoryFile[0],&natoms);
-        if(trajectory_fmt=="xdr-trr") read_trr_natoms(&trajectoryFile[0],&natoms);
-#endif
+        xdr=Tools::make_unique<XdrReader>(trajectoryFile,trajectory_fmt=="xdr-xtc"?"xtc":"trr");
+        natoms=xdr->getNumberOfAtoms();
       } else {
         fp=fopen(trajectoryFile.c_str(),"r");
         if(!fp) {
@@ -643,6 +627,9 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
           break;
         }
 #endif
+      } else if(trajectory_fmt=="xdr-xtc" || trajectory_fmt=="xdr-trr") {
+        if(!xdr->read(xdrFrame)) break;
+        natoms=xdrFrame.natoms;
       } else if(trajectory_fmt=="xyz" || trajectory_fmt=="gro" || trajectory_fmt=="dlp4") {
         if(!Tools::getline(fp,line)) break;
       }
@@ -802,22 +789,13 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
         }
 #endif
       } else if(trajectory_fmt=="xdr-xtc" || trajectory_fmt=="xdr-trr") {
-#ifdef __PLUMED_HAS_XDRFILE
-        int localstep;
-        float time;
-        matrix box;
-        auto pos=Tools::make_unique<rvec[]>(natoms);
-        float prec,lambda;
-        int ret=exdrOK;
-        if(trajectory_fmt=="xdr-xtc") ret=read_xtc(xd,natoms,&localstep,&time,box,pos.get(),&prec);
-        if(trajectory_fmt=="xdr-trr") ret=read_trr(xd,natoms,&localstep,&time,&lambda,box,pos.get(),NULL,NULL);
-        if(stride==0) step=localstep;
-        if(ret==exdrENDOFFILE) break;
-        if(ret!=exdrOK) break;
-        for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) cell[3*i+j]=box[i][j];
-        for(int i=0; i<natoms; i++) for(unsigned j=0; j<3; j++)
-            coordinates[3*i+j]=real(pos[i][j]);
-#endif
+        if(stride==0) step=xdrFrame.step;
+        if(pbc_cli_given==false) {
+          for(unsigned i=0; i<9; i++) cell[i]=real(xdrFrame.box[i]);
+        } else {
+          for(unsigned i=0; i<9; i++) cell[i]=pbc_cli_box[i];
+        }
+        for(int i=0; i<3*natoms; i++) coordinates[i]=real(xdrFrame.positions[i]);
       } else {
         if(trajectory_fmt=="xyz") {
           if(!Tools::getline(fp,line)) error("premature end of trajectory file");
@@ -1043,9 +1021,6 @@ int Driver<real>::main(FILE* in,FILE*out,Communicator& pc) {
   if(fp_forces) fclose(fp_forces);
   if(debugforces.length()>0) fp_dforces.close();
   if(fp && fp!=in)fclose(fp);
-#ifdef __PLUMED_HAS_XDRFILE
-  if(xd) xdrfile_close(xd);
-#endif
 #ifdef __PLUMED_HAS_MOLFILE_PLUGINS
   if(h_in) api->close_file_read(h_in);
 #endif
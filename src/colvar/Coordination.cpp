@@ -46,9 +46,15 @@ but it can be changed using the optional SWITCH option.
 
 To make your calculation faster you can use a neighbor list, which makes it that only a
 relevant subset of the pairwise distance are calculated at every step.
+Actions of this family that use neighbor lists on the same groups, with the same NL_CUTOFF
+and periodic boundary settings, share the pairs found in the list, which are then
+computed only once when their lists are updated on the same step.
 
 If GROUPB is empty, it will sum the \f$\frac{N(N-1)}{2}\f$ pairs in GROUPA. This avoids computing
 twice permuted indexes (e.g. pair (i,j) and (j,i)) thus running at twice the speed.
+In this case the pairs (or, with NLIST, the pairs checked when updating the list) are split
+among MPI processes and OpenMP threads in contiguous blocks of rows of the triangle,
+each block containing the same number of pairs.
 
 Notice that if there are common atoms between GROUPA and GROUPB the switching function should be
 equal to one. These "self contacts" are discarded by plumed (since version 2.1),
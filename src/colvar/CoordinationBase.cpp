@@ -23,6 +23,7 @@
 #include "tools/NeighborList.h"
 #include "tools/Communicator.h"
 #include "tools/OpenMP.h"
+#include "core/PlumedMain.h"
 
 namespace PLMD {
 namespace colvar {
@@ -43,10 +44,12 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
   pbc(true),
   serial(false),
   invalidateList(true),
-  firsttime(true)
+  firsttime(true),
+  triangular(false)
 {
 
   parseFlag("SERIAL",serial);
+  tuner.link(log,getLabel());
 
   std::vector<AtomNumber> ga_lista,gb_lista;
   parseAtomList("GROUPA",ga_lista);
@@ -80,6 +83,10 @@ CoordinationBase::CoordinationBase(const ActionOptions&ao):
     if(doneigh)  nl=Tools::make_unique<NeighborList>(ga_lista,serial,pbc,getPbc(),comm,nl_cut,nl_st);
     else         nl=Tools::make_unique<NeighborList>(ga_lista,serial,pbc,getPbc(),comm);
   }
+// neighbor lists on the same atoms with the same settings are built only once
+  if(doneigh) nl->setCache(plumed.getNeighborListCache(nl->getCacheKey()));
+// all the pairs of a single group are looped over directly, without the list of pairs
+  triangular=(gb_lista.size()==0 && !doneigh);
 
   requestAtoms(nl->getFullAtomList());
 
@@ -108,6 +115,11 @@ CoordinationBase::~CoordinationBase() {
 // destructor required to delete forward declared class
 }
 
+void CoordinationBase::runFinalJobs() {
+  if(nl->getStride()>0) log.printf("  neighbor list of %s: pairs computed %lu times, copied from another action %lu times\n",
+                                     getLabel().c_str(),nl->getNumberOfBuilds(),nl->getNumberOfCopies());
+}
+
 void CoordinationBase::prepare() {
   if(nl->getStride()>0) {
     if(firsttime || (getStep()%nl->getStride()==0)) {
@@ -129,7 +141,9 @@ void CoordinationBase::calculate()
 
   double ncoord=0.;
   Tensor virial;
-  std::vector<Vector> deriv(getNumberOfAtoms());
+// derivatives are skipped on steps where no action uses them
+  const bool doderiv=!doNotCalculateDerivatives();
+  std::vector<Vector> deriv(doderiv?getNumberOfAtoms():0);
 
   if(nl->getStride()>0 && invalidateList) {
     nl->update(getPositions());
@@ -148,21 +162,24 @@ void CoordinationBase::calculate()
   unsigned nt=OpenMP::getNumThreads();
   const unsigned nn=nl->size();
   if(nt*stride*10>nn) nt=1;
+  nt=tuner.begin(nn/stride,nt);
+
+  const unsigned natoms=getNumberOfAtoms();
+  if(triangular && triangularBlocks.size()!=stride*nt+1) OpenMP::getTriangularBlocks(natoms,stride*nt,triangularBlocks);
 
   #pragma omp parallel num_threads(nt)
   {
-    std::vector<Vector> omp_deriv(getPositions().size());
+    std::vector<Vector> omp_deriv(doderiv && nt>1?getPositions().size():0);
     Tensor omp_virial;
+    double omp_ncoord=0.0;
+// with a single thread derivatives are accumulated directly
+    std::vector<Vector> & myderiv(nt>1?omp_deriv:deriv);
+    Tensor & myvirial(nt>1?omp_virial:virial);
 
-    #pragma omp for reduction(+:ncoord) nowait
-    for(unsigned int i=rank; i<nn; i+=stride) {
+    auto addPair=[&](unsigned i0,unsigned i1) {
+      if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) return;
 
       Vector distance;
-      unsigned i0=nl->getClosePair(i).first;
-      unsigned i1=nl->getClosePair(i).second;
-
-      if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
-
       if(pbc) {
         distance=pbcDistance(getPosition(i0),getPosition(i1));
       } else {
@@ -170,37 +187,50 @@ void CoordinationBase::calculate()
       }
 
       double dfunc=0.;
-      ncoord += pairing(distance.modulo2(), dfunc,i0,i1);
+      omp_ncoord += pairing(distance.modulo2(), dfunc,i0,i1);
+      if(!doderiv) return;
 
       Vector dd(dfunc*distance);
       Tensor vv(dd,distance);
-      if(nt>1) {
-        omp_deriv[i0]-=dd;
-        omp_deriv[i1]+=dd;
-        omp_virial-=vv;
-      } else {
-        deriv[i0]-=dd;
-        deriv[i1]+=dd;
-        virial-=vv;
+      myderiv[i0]-=dd;
+      myderiv[i1]+=dd;
+      myvirial-=vv;
+    };
+
+    if(triangular) {
+// each thread of each process takes a block of rows of the upper triangle with the same number of pairs
+      #pragma omp for nowait
+      for(unsigned b=rank*nt; b<(rank+1)*nt; b++) {
+        for(unsigned i0=triangularBlocks[b]; i0<triangularBlocks[b+1]; i0++) {
+          for(unsigned i1=i0+1; i1<natoms; i1++) addPair(i0,i1);
+        }
+      }
+    } else {
+      #pragma omp for nowait
+      for(unsigned int i=rank; i<nn; i+=stride) {
+        addPair(nl->getClosePair(i).first,nl->getClosePair(i).second);
       }
-
     }
     #pragma omp critical
-    if(nt>1) {
-      for(unsigned i=0; i<getPositions().size(); i++) deriv[i]+=omp_deriv[i];
-      virial+=omp_virial;
+    {
+      ncoord+=omp_ncoord;
+      if(nt>1 && doderiv) {
+        for(unsigned i=0; i<getPositions().size(); i++) deriv[i]+=omp_deriv[i];
+        virial+=omp_virial;
+      }
     }
   }
+  tuner.end();
 
   if(!serial) {
     comm.Sum(ncoord);
     if(!deriv.empty()) comm.Sum(&deriv[0][0],3*deriv.size());
-    comm.Sum(virial);
+    if(doderiv) comm.Sum(virial);
   }
 
   for(unsigned i=0; i<deriv.size(); ++i) setAtomsDerivatives(i,deriv[i]);
   setValue           (ncoord);
-  setBoxDerivatives  (virial);
+  if(doderiv) setBoxDerivatives  (virial);
 
 }
 }
@@ -22,6 +22,7 @@
 #ifndef __PLUMED_colvar_CoordinationBase_h
 #define __PLUMED_colvar_CoordinationBase_h
 #include "Colvar.h"
+#include "tools/OpenMP.h"
 #include <memory>
 
 namespace PLMD {
@@ -36,6 +37,10 @@ class CoordinationBase : public Colvar {
   std::unique_ptr<NeighborList> nl;
   bool invalidateList;
   bool firsttime;
+  OpenMPTuner tuner;
+/// Single group without neighbor list: pairs are the upper triangle, split in blocks of rows
+  bool triangular;
+  std::vector<unsigned> triangularBlocks;
 
 public:
   explicit CoordinationBase(const ActionOptions&);
@@ -43,6 +48,7 @@ public:
 // active methods:
   void calculate() override;
   void prepare() override;
+  void runFinalJobs() override;
   virtual double pairing(double distance,double&dfunc,unsigned i,unsigned j)const=0;
   static void registerKeywords( Keywords& keys );
 };
@@ -132,6 +132,7 @@ ERMSD::ERMSD(const ActionOptions&ao):
   parse("REFERENCE",reference);
   double cutoff=2.4;
   parse("CUTOFF",cutoff);
+  if(cutoff<=0.0) error("CUTOFF should be positive");
 
 
   bool nopbc(false);
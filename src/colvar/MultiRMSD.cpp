@@ -37,6 +37,7 @@ class MultiRMSD : public Colvar {
   MultiValue myvals;
   ReferenceValuePack mypack;
   bool nopbc;
+  double epsilonClose;
 
 public:
   explicit MultiRMSD(const ActionOptions&);
@@ -147,10 +148,11 @@ void MultiRMSD::registerKeywords(Keywords& keys) {
   keys.add("compulsory","REFERENCE","a file in pdb format containing the reference structure and the atoms involved in the CV.");
   keys.add("compulsory","TYPE","MULTI-SIMPLE","the manner in which RMSD alignment is performed.  Should be MULTI-OPTIMAL, MULTI-OPTIMAL-FAST,  MULTI-SIMPLE or MULTI-DRMSD.");
   keys.addFlag("SQUARED",false," This should be set if you want the mean squared displacement instead of the root mean squared displacement");
+  keys.add("optional","EPSILON_CLOSE","on steps where derivatives are not needed, reuse the optimal rotation of the last full alignment of each domain as long as the atoms moved less than this RMSD from the corresponding structure (no cache if not set)");
 }
 
 MultiRMSD::MultiRMSD(const ActionOptions&ao):
-  PLUMED_COLVAR_INIT(ao),squared(false),myvals(1,0), mypack(0,0,myvals),nopbc(false)
+  PLUMED_COLVAR_INIT(ao),squared(false),myvals(1,0), mypack(0,0,myvals),nopbc(false),epsilonClose(-1.0)
 {
   std::string reference;
   parse("REFERENCE",reference);
@@ -159,6 +161,7 @@ MultiRMSD::MultiRMSD(const ActionOptions&ao):
   parse("TYPE",type);
   parseFlag("SQUARED",squared);
   parseFlag("NOPBC",nopbc);
+  parse("EPSILON_CLOSE",epsilonClose);
   checkRead();
 
   addValueWithDerivatives(); setNotPeriodic();
@@ -169,6 +172,7 @@ MultiRMSD::MultiRMSD(const ActionOptions&ao):
     error("missing input file " + reference );
 
   rmsd=metricRegister().create<MultiDomainRMSD>(type,pdb);
+  if(epsilonClose>0.0) rmsd->setRotationCache(epsilonClose);
   // Do not align molecule if we are doing DRMSD for domains and NOPBC has been specified in input
   if( pdb.hasFlag("NOPBC") ) nopbc=true;
 
@@ -189,11 +193,14 @@ MultiRMSD::MultiRMSD(const ActionOptions&ao):
   log.printf("\n");
   log.printf("  method for alignment : %s \n",type.c_str() );
   if(squared)log.printf("  chosen to use SQUARED option for MSD instead of RMSD\n");
+  if(epsilonClose>0.0) log.printf("  when derivatives are not needed, reusing the optimal rotation while atoms move less than %f from the last full alignment\n",epsilonClose);
 }
 
 // calculator
 void MultiRMSD::calculate() {
   if(!nopbc) makeWhole();
+  // the cached rotations only give an accurate value, so they are not used when derivatives are needed
+  if(epsilonClose>0.0) rmsd->setRotationCacheReuse(doNotCalculateDerivatives());
   double r=rmsd->calculate( getPositions(), getPbc(), mypack, squared );
 
   setValue(r);
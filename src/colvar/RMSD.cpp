@@ -37,6 +37,7 @@ class RMSD : public Colvar {
   std::unique_ptr<PLMD::RMSDBase> rmsd;
   bool squared;
   bool nopbc;
+  double epsilonClose;
 
 public:
   explicit RMSD(const ActionOptions&);
@@ -133,6 +134,18 @@ In case you want to recover the old behavior you should use the NOPBC flag.
 In that case you need to take care that atoms are in the correct
 periodic image.
 
+With TYPE=OPTIMAL the cost of the alignment can be reduced with the EPSILON_CLOSE keyword
+on the steps where the derivatives of the RMSD are not needed, e.g. when the RMSD is only printed
+and no bias acting on it is applied at that step.
+The optimal rotation is stored after every full alignment. On those steps it is reused
+as long as the atoms have moved (RMSD without realignment) less than EPSILON_CLOSE
+from the structure where it was computed, and a full alignment is done otherwise.
+Since the RMSD is minimal with respect to the rotation, the error introduced in the distance
+is second order in the error on the rotation, which vanishes with EPSILON_CLOSE.
+The derivatives would instead have a first order error, so a full alignment is always done
+when they are needed and the forces are not affected.
+The same keyword is available in \ref MULTI_RMSD.
+
 \par Examples
 
 The following tells plumed to calculate the RMSD distance between
@@ -156,6 +169,14 @@ END
 
 ...
 
+The following computes the same RMSD, which is only printed, and recomputes the optimal rotation
+only when the atoms moved more than 0.01 nm from the structure where it was last computed
+
+\plumedfile
+r: RMSD REFERENCE=file.pdb TYPE=OPTIMAL EPSILON_CLOSE=0.01
+PRINT ARG=r FILE=colvar
+\endplumedfile
+
 */
 //+ENDPLUMEDOC
 
@@ -166,6 +187,7 @@ void RMSD::registerKeywords(Keywords& keys) {
   keys.add("compulsory","REFERENCE","a file in pdb format containing the reference structure and the atoms involved in the CV.");
   keys.add("compulsory","TYPE","SIMPLE","the manner in which RMSD alignment is performed.  Should be OPTIMAL or SIMPLE.");
   keys.addFlag("SQUARED",false," This should be set if you want mean squared displacement instead of RMSD ");
+  keys.add("optional","EPSILON_CLOSE","on steps where derivatives are not needed, reuse the optimal rotation of the last full alignment as long as the atoms moved less than this RMSD from the corresponding structure (no cache if not set)");
 }
 
 RMSD::RMSD(const ActionOptions&ao):
@@ -173,7 +195,8 @@ RMSD::RMSD(const ActionOptions&ao):
   myvals(1,0),
   mypack(0,0,myvals),
   squared(false),
-  nopbc(false)
+  nopbc(false),
+  epsilonClose(-1.0)
 {
   std::string reference;
   parse("REFERENCE",reference);
@@ -182,6 +205,7 @@ RMSD::RMSD(const ActionOptions&ao):
   parse("TYPE",type);
   parseFlag("SQUARED",squared);
   parseFlag("NOPBC",nopbc);
+  parse("EPSILON_CLOSE",epsilonClose);
 
   checkRead();
 
@@ -194,6 +218,7 @@ RMSD::RMSD(const ActionOptions&ao):
     error("missing input file " + reference );
 
   rmsd=metricRegister().create<RMSDBase>(type,pdb);
+  if(epsilonClose>0.0) rmsd->setRotationCache(epsilonClose);
 
   std::vector<AtomNumber> atoms;
   rmsd->getAtomRequests( atoms );
@@ -214,6 +239,7 @@ RMSD::RMSD(const ActionOptions&ao):
   log.printf("\n");
   log.printf("  method for alignment : %s \n",type.c_str() );
   if(squared)log.printf("  chosen to use SQUARED option for MSD instead of RMSD\n");
+  if(epsilonClose>0.0) log.printf("  when derivatives are not needed, reusing the optimal rotation while atoms move less than %f from the last full alignment\n",epsilonClose);
   if(nopbc) log.printf("  without periodic boundary conditions\n");
   else      log.printf("  using periodic boundary conditions\n");
 }
@@ -222,6 +248,8 @@ RMSD::RMSD(const ActionOptions&ao):
 // calculator
 void RMSD::calculate() {
   if(!nopbc) makeWhole();
+  // the cached rotation only gives an accurate value, so it is not used when derivatives are needed
+  if(epsilonClose>0.0) rmsd->setRotationCacheReuse(doNotCalculateDerivatives());
   double r=rmsd->calculate( getPositions(), mypack, squared );
 
   setValue(r);
@@ -24,6 +24,8 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <utility>
+#include <cstddef>
 #include "tools/Keywords.h"
 #include "tools/Tools.h"
 #include "tools/Log.h"
@@ -34,6 +36,7 @@ class PDB;
 class PlumedMain;
 class Communicator;
 class ActionWithValue;
+class Checkpoint;
 
 /// This class is used to bring the relevant information to the Action constructor.
 /// Only Action and ActionRegister class can access to its content, which is
@@ -228,6 +231,13 @@ public:
 /// Tell to the Action to flush open files
   void fflush();
 
+/// Save the internal state of the Action in a binary checkpoint.
+/// Actions whose state cannot be cheaply reconstructed from their input
+/// should write it here in a section named after their label, and
+/// read it back in their constructor using PlumedMain::getRestartCheckpoint().
+/// By default (if not overridden) does nothing.
+  virtual void saveCheckpoint(Checkpoint&) {}
+
   virtual std::string getDocumentation()const;
 
 /// Returns the label
@@ -262,6 +272,12 @@ public:
 /// Check if the action needs gradient
   virtual bool checkNeedsGradients()const {return false;}
 
+/// Report the memory used by the largest data structures of this action.
+/// An entry is appended to usage for each of them, with a short description
+/// and the number of bytes. Sizes are estimated from the capacity of the
+/// containers, so they are approximate. By default nothing is reported.
+  virtual void getMemoryUsage(std::vector<std::pair<std::string,std::size_t> >& usage)const {}
+
 /// Perform calculation using numerical derivatives
 /// N.B. only pass an ActionWithValue to this routine if you know exactly what you
 /// are doing.
@@ -22,6 +22,9 @@
 #include "ActionWithValue.h"
 #include "tools/Exception.h"
 #include "tools/OpenMP.h"
+#include "PlumedMain.h"
+#include "ActionSet.h"
+#include <algorithm>
 
 namespace PLMD {
 
@@ -54,6 +57,10 @@ void ActionWithValue::useCustomisableComponents(Keywords& keys) {
 ActionWithValue::ActionWithValue(const ActionOptions&ao):
   Action(ao),
   noderiv(true),
+  derivativesOnStep(true),
+  derivativesAlways(false),
+  turningOnForUser(false),
+  derivativeUsersResolvedFor(0),
   numericalDerivatives(false)
 {
   if( keywords.exists("NUMERICAL_DERIVATIVES") ) parseFlag("NUMERICAL_DERIVATIVES",numericalDerivatives);
@@ -212,15 +219,52 @@ void ActionWithValue::setGradientsIfNeeded() {
 void ActionWithValue::turnOnDerivatives() {
   // Turn on the derivatives
   noderiv=false;
+  // We do not know who needs them, so we compute them at every step
+  if(!turningOnForUser) derivativesAlways=true;
   // Resize the derivatives
   for(unsigned i=0; i<values.size(); ++i) values[i]->resizeDerivatives( getNumberOfDerivatives() );
   // And turn on the derivatives in all actions on which we are dependent
   for(unsigned i=0; i<getDependencies().size(); ++i) {
     ActionWithValue* vv=dynamic_cast<ActionWithValue*>( getDependencies()[i] );
-    if(vv) vv->turnOnDerivatives();
+    if(vv) vv->turnOnDerivativesFor(this);
   }
 }
 
+void ActionWithValue::turnOnDerivativesFor(const Action* user) {
+  if(std::find(derivativeUsers.begin(),derivativeUsers.end(),user->getLabel())==derivativeUsers.end()) {
+    derivativeUsers.push_back(user->getLabel());
+    derivativeUsersResolvedFor=0;
+  }
+  const bool wasTurningOn=turningOnForUser;
+  turningOnForUser=true;
+  turnOnDerivatives();
+  turningOnForUser=wasTurningOn;
+}
+
+void ActionWithValue::setDerivativesOnStep() {
+  derivativesOnStep=true;
+  if(noderiv || derivativesAlways || !isActive() || isOptionOn("GRADIENTS")) return;
+  // users are stored by label, since an action failing in its constructor
+  // might have turned on the derivatives before being destroyed.
+  // They are looked up again only when actions are added to the action set
+  const ActionSet & actionSet(plumed.getActionSet());
+  if(derivativeUsersResolvedFor!=actionSet.size()) {
+    derivativeUserActions.clear();
+    for(const auto & l : derivativeUsers) {
+      const Action* u=actionSet.selectWithLabel<Action*>(l);
+      if(u) derivativeUserActions.push_back(u);
+    }
+    derivativeUsersResolvedFor=actionSet.size();
+  }
+  // derivatives are needed if an active user needs them
+  for(const auto & u : derivativeUserActions) {
+    if(!u->isActive()) continue;
+    const ActionWithValue* uv=dynamic_cast<const ActionWithValue*>(u);
+    if(!uv || uv->derivativesAreNeededOnStep()) return;
+  }
+  derivativesOnStep=false;
+}
+
 Value* ActionWithValue::getPntrToComponent( const std::string& name ) {
   int kk=getComponent(name);
   return values[kk].get();
@@ -71,6 +71,19 @@ private:
   std::vector<std::unique_ptr<Value>> values;
 /// Are we skipping the calculation of the derivatives
   bool noderiv;
+/// Are the derivatives needed on this step, see setDerivativesOnStep()
+  bool derivativesOnStep;
+/// The derivatives were turned on without saying which action uses them,
+/// so they are computed whenever this action is active
+  bool derivativesAlways;
+/// Set while turnOnDerivativesFor() is calling turnOnDerivatives()
+  bool turningOnForUser;
+/// The labels of the actions that use the derivatives of this action
+  std::vector<std::string> derivativeUsers;
+/// The actions with these labels, looked up in setDerivativesOnStep()
+  std::vector<const Action*> derivativeUserActions;
+/// Size of the action set when derivativeUserActions was filled
+  std::size_t derivativeUsersResolvedFor;
 /// Are we using numerical derivatives to differentiate
   bool numericalDerivatives;
 /// Return the index for the component named name
@@ -168,6 +181,20 @@ public:
   virtual unsigned getNumberOfDerivatives()=0;
 /// Activate the calculation of derivatives
   virtual void turnOnDerivatives();
+/// Activate the calculation of derivatives because they are used by action user.
+/// Derivatives requested in this way are only calculated on the steps where
+/// at least one of their users needs them.
+  void turnOnDerivativesFor(const Action* user);
+/// Decide if the derivatives are needed on this step.
+/// This is called by PlumedMain after all the actions that are on step
+/// have been activated, in reverse order, so that the users of the
+/// derivatives of this action have already been set up.
+  void setDerivativesOnStep();
+/// Check if derivatives will be computed on this step.
+/// Differently from doNotCalculateDerivatives(), this cannot be overridden.
+  bool derivativesAreNeededOnStep() const {
+    return !noderiv && derivativesOnStep;
+  }
 };
 
 inline
@@ -210,7 +237,7 @@ bool ActionWithValue::checkNumericalDerivatives() const {
 
 inline
 bool ActionWithValue::doNotCalculateDerivatives() const {
-  return noderiv;
+  return noderiv || !derivativesOnStep;
 }
 
 
@@ -25,6 +25,7 @@
 #include <iostream>
 #include <vector>
 #include "tools/Matrix.h"
+#include "tools/Checkpoint.h"
 
 namespace PLMD {
 
@@ -332,5 +333,21 @@ std::vector<double> FlexibleBin::getInverseMatrix(unsigned iarg) const {
 
   return uppervec;
 }
+void FlexibleBin::saveCheckpoint(Checkpoint& cpt) const {
+  cpt.put(variance);
+  cpt.put(average);
+}
+
+void FlexibleBin::restoreCheckpoint(Checkpoint& cpt) {
+  std::vector<double> v,a;
+  cpt.get(v);
+  cpt.get(a);
+  // averages and variances are allocated lazily at the first update
+  const unsigned ncv=paction->getNumberOfArguments();
+  plumed_massert(v.size()==0 || v.size()==ncv*(ncv+1)/2 || v.size()==1,"adaptive hills in checkpoint do not match input");
+  plumed_massert(a.size()==0 || a.size()==ncv || a.size()==1,"adaptive hills in checkpoint do not match input");
+  variance=v;
+  average=a;
+}
 
 }
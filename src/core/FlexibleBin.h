@@ -27,6 +27,7 @@
 namespace PLMD {
 
 class ActionWithArguments;
+class Checkpoint;
 
 class FlexibleBin {
 private:
@@ -54,6 +55,10 @@ public:
   std::vector<double> getMatrix() const;
   std::vector<double> getInverseMatrix() const;
   std::vector<double> getInverseMatrix(unsigned iarg) const;
+  /// save the accumulated averages and variances in a binary checkpoint
+  void saveCheckpoint(Checkpoint&) const;
+  /// restore the accumulated averages and variances from a binary checkpoint
+  void restoreCheckpoint(Checkpoint&);
   enum AdaptiveHillsType { none, diffusion, geometry };
 };
 
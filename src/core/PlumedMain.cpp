@@ -31,12 +31,14 @@
 #include "ExchangePatterns.h"
 #include "GREX.h"
 #include "config/Config.h"
+#include "tools/Checkpoint.h"
 #include "tools/Citations.h"
 #include "tools/Communicator.h"
 #include "tools/DLLoader.h"
 #include "tools/Exception.h"
 #include "tools/IFile.h"
 #include "tools/Log.h"
+#include "tools/NeighborList.h"
 #include "tools/OpenMP.h"
 #include "tools/Tools.h"
 #include "tools/Stopwatch.h"
@@ -135,10 +137,12 @@ PlumedMain::PlumedMain():
   exchangeStep(false),
   restart(false),
   doCheckPoint(false),
+  checkpointStride(0),
   stopFlag(NULL),
   stopNow(false),
   novirial(false),
-  detailedTimers(false)
+  detailedTimers(false),
+  memoryReport(false)
 {
   log.link(comm);
   log.setLinePrefix("PLUMED: ");
@@ -146,6 +150,10 @@ PlumedMain::PlumedMain():
 
 // destructor needed to delete forward declarated objects
 PlumedMain::~PlumedMain() {
+  if(memoryReport && initialized) {
+    log<<"Memory usage at the end of the simulation\n";
+    printMemoryUsage(log);
+  }
 }
 
 /////////////////////////////////////////////////////////////
@@ -524,6 +532,11 @@ void PlumedMain::cmd(const std::string & word,void*val) {
         CHECK_NOTNULL(val,word);
         atoms.double2MD(getBias()/(atoms.getMDUnits().getEnergy()/atoms.getUnits().getEnergy()),val);
         break;
+      case cmd_getMemoryUsage:
+        CHECK_INIT(initialized,word);
+        CHECK_NOTNULL(val,word);
+        *(static_cast<long*>(val))=getMemoryUsage();
+        break;
       case cmd_checkAction:
         CHECK_NOTNULL(val,word);
         plumed_assert(nw==2);
@@ -766,6 +779,14 @@ void PlumedMain::prepareDependencies() {
     }
   }
 
+// check which actions need derivatives on this step.
+// this is done in reverse order so that the actions using the derivatives
+// of an action are checked before it
+  for(auto pp=actionSet.rbegin(); pp!=actionSet.rend(); ++pp) {
+    ActionWithValue*av=dynamic_cast<ActionWithValue*>(pp->get());
+    if(av) av->setDerivativesOnStep();
+  }
+
 }
 
 void PlumedMain::shareData() {
@@ -831,7 +852,8 @@ void PlumedMain::justCalculate() {
         if(aa) aa->clearOutputForces();
         if(aa) if(aa->isActive()) aa->retrieveAtoms();
       }
-      if(p->checkNumericalDerivatives()) p->calculateNumericalDerivatives();
+// numerical derivatives are skipped if nobody needs them on this step
+      if(p->checkNumericalDerivatives() && !(av && av->doNotCalculateDerivatives())) p->calculateNumericalDerivatives();
       else p->calculate();
       // This retrieves components called bias
       if(av) bias+=av->getOutputQuantity("bias");
@@ -897,9 +919,24 @@ void PlumedMain::update() {
 
 // update step (for statistics, etc)
   updateFlags.push(true);
+  int iaction=0;
   for(const auto & p : actionSet) {
     p->beforeUpdate();
-    if(p->isActive() && p->checkUpdate() && updateFlagsTop()) p->update();
+    if(p->isActive() && p->checkUpdate() && updateFlagsTop()) {
+// Stopwatch is stopped when sw goes out of scope.
+      Stopwatch::Handler sw;
+      if(detailedTimers) {
+        std::string actionNumberLabel;
+        Tools::convert(iaction,actionNumberLabel);
+        const unsigned m=actionSet.size();
+        unsigned k=0; unsigned n=1; while(n<m) { n*=10; k++; }
+        const int pad=k-actionNumberLabel.length();
+        for(int i=0; i<pad; i++) actionNumberLabel=" "+actionNumberLabel;
+        sw=stopwatch.startStop("6A "+actionNumberLabel+" "+p->getLabel());
+      }
+      p->update();
+    }
+    iaction++;
   }
   while(!updateFlags.empty()) updateFlags.pop();
   if(!updateFlags.empty()) plumed_merror("non matching changes in the update flags");
@@ -917,6 +954,27 @@ void PlumedMain::update() {
     log.flush();
     for(const auto & p : actionSet) p->fflush();
   }
+
+// binary checkpoint of the actions state
+  if(checkpointFile.length()>0 && ((checkpointStride>0 && step%checkpointStride==0)||doCheckPoint)) writeCheckpoint();
+}
+
+void PlumedMain::setCheckpoint(const std::string&file,long int stride) {
+  checkpointFile=file;
+  checkpointStride=stride;
+}
+
+Checkpoint* PlumedMain::getRestartCheckpoint(const std::string&label) {
+  if(!checkpoint.hasSection(label)) return NULL;
+  return &checkpoint;
+}
+
+void PlumedMain::writeCheckpoint() {
+  plumed_massert(checkpointFile.length()>0,"checkpoint file has not been set");
+  checkpoint.clear();
+  checkpoint.setStep(step);
+  for(const auto & p : actionSet) p->saveCheckpoint(checkpoint);
+  if(comm.Get_rank()==0) checkpoint.write(checkpointFile);
 }
 
 void PlumedMain::load(const std::string& ss) {
@@ -961,6 +1019,42 @@ double PlumedMain::getWork() const {
   return work;
 }
 
+std::size_t PlumedMain::getMemoryUsage() const {
+  std::size_t total=0;
+  std::vector<std::pair<std::string,std::size_t> > usage;
+  for(const auto & p : actionSet) {
+    usage.clear();
+    p->getMemoryUsage(usage);
+    for(const auto & u : usage) total+=u.second;
+  }
+  return total;
+}
+
+void PlumedMain::printMemoryUsage(OFile& ofile) const {
+  std::size_t total=0;
+  std::vector<std::pair<std::string,std::size_t> > usage;
+  ofile.printf("Approximate memory usage at step %ld:\n",step);
+  for(const auto & p : actionSet) {
+    usage.clear();
+    p->getMemoryUsage(usage);
+    for(const auto & u : usage) {
+      ofile.printf("  %-20s %-30s %14.6f MB\n",p->getLabel().c_str(),u.first.c_str(),u.second/1048576.0);
+      total+=u.second;
+    }
+  }
+  ofile.printf("  %-51s %14.6f MB\n","Total",total/1048576.0);
+}
+
+std::shared_ptr<NeighborListCache> PlumedMain::getNeighborListCache(const std::string& key) {
+  auto & w=neighborListCaches[key];
+  auto cache=w.lock();
+  if(!cache) {
+    cache=std::make_shared<NeighborListCache>();
+    w=cache;
+  }
+  return cache;
+}
+
 FILE* PlumedMain::fopen(const char *path, const char *mode) {
   std::string mmode(mode);
   std::string ppath(path);
@@ -25,6 +25,7 @@
 #include "WithCmd.h"
 #include "tools/ForwardDecl.h"
 #include <cstdio>
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <set>
@@ -63,7 +64,10 @@ class Stopwatch;
 class Citations;
 class ExchangePatterns;
 class FileBase;
+class OFile;
 class DataFetchingObject;
+class Checkpoint;
+class NeighborListCache;
 
 /**
 Main plumed object.
@@ -190,6 +194,17 @@ private:
 /// Flag for checkpointig
   bool doCheckPoint;
 
+/// Forward declaration.
+  ForwardDecl<Checkpoint> checkpoint_fwd;
+/// Binary checkpoint with the internal state of the actions
+  Checkpoint& checkpoint=*checkpoint_fwd;
+
+/// Name of the binary checkpoint file
+  std::string checkpointFile;
+
+/// Stride for writing the binary checkpoint
+  long int checkpointStride;
+
 
 /// Stuff to make plumed stop the MD code cleanly
   int* stopFlag;
@@ -206,10 +221,19 @@ public:
 /// Flag to switch on detailed timers
   bool detailedTimers;
 
+/// Flag to write a summary of the memory usage in the log at the end of the run
+  bool memoryReport;
+
 /// Generic map string -> double
 /// intended to pass information across Actions
   std::map<std::string,double> passMap;
 
+private:
+/// Close pairs shared among neighbor lists, indexed by NeighborList::getCacheKey()
+  std::map<std::string,std::weak_ptr<NeighborListCache> > neighborListCaches;
+
+public:
+
 /// Add a citation, returning a string containing the reference number, something like "[10]"
   std::string cite(const std::string&);
 
@@ -356,6 +380,14 @@ public:
   double getBias()const;
 /// get the value of the work
   double getWork()const;
+/// Approximate number of bytes used by all the actions, see Action::getMemoryUsage()
+  std::size_t getMemoryUsage()const;
+/// Write the memory used by each action and the total
+  void printMemoryUsage(OFile&)const;
+/// Get the storage for the close pairs of the neighbor lists with a given key.
+/// Actions that build neighbor lists on the same atoms with the same settings
+/// receive the same object, so that the list is only built once per step.
+  std::shared_ptr<NeighborListCache> getNeighborListCache(const std::string& key);
 /// Opens a file.
 /// Similar to plain fopen, but, if it finds an error in opening the file, it also tries with
 /// path+suffix.  This trick is useful for multiple replica simulations.
@@ -374,6 +406,15 @@ public:
   void setRestart(bool f) {restart=f;}
 /// Check if checkpointing
   bool getCPT()const;
+/// Set file name and stride for binary checkpoints
+  void setCheckpoint(const std::string&file,long int stride);
+/// Get the binary checkpoint
+  Checkpoint& getCheckpoint() {return checkpoint;}
+/// Get the binary checkpoint read at restart if it contains the state of the action with this label, NULL otherwise.
+/// Should only be used while actions are being constructed.
+  Checkpoint* getRestartCheckpoint(const std::string&label);
+/// Save the state of all the actions in the binary checkpoint file
+  void writeCheckpoint();
 /// Set exchangeStep flag
   void setExchangeStep(bool f);
 /// Get exchangeStep flag
@@ -405,6 +405,20 @@ void DRRForceGrid::writeDivergence(const string &filename) const {
   fclose(pDiv);
 }
 
+void DRRForceGrid::getAccumulators(vector<double> &buf, size_t offset) const {
+  auto it = std::copy(begin(forces), end(forces), begin(buf) + offset);
+  // counts are stored as double, which is exact up to 2^53 samples
+  std::copy(begin(samples), end(samples), it);
+}
+
+void DRRForceGrid::setAccumulators(const vector<double> &buf, size_t offset) {
+  auto it = begin(buf) + offset;
+  std::copy(it, it + forces.size(), begin(forces));
+  it += forces.size();
+  std::transform(it, it + samples.size(), begin(samples),
+  [](double x) { return static_cast<unsigned long int>(std::llround(x)); });
+}
+
 bool ABF::store_getbias(const vector<double> &pos, const vector<double> &f,
                         vector<double> &fbias) {
   if (!isInBoundary(pos)) {
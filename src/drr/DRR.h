@@ -197,6 +197,13 @@ public:
   /// merge windows
   static vector<DRRAxis> merge(const vector<DRRAxis> &dA,
                                const vector<DRRAxis> &dB);
+  /// Number of values copied by getAccumulators (forces and counts)
+  size_t getAccumulatorsSize() const { return forces.size() + samples.size(); }
+  /// Copy the accumulated forces and counts to buf, starting at offset
+  /// This is used to share the accumulators among multiple walkers
+  void getAccumulators(vector<double> &buf, size_t offset) const;
+  /// Set the accumulated forces and counts from buf, starting at offset
+  void setAccumulators(const vector<double> &buf, size_t offset);
   /// Get suffix
   string getSuffix() const { return suffix; }
   /// Set unit for .grad output
@@ -84,6 +84,15 @@ It may be slow. I only change the Boltzmann constant and output
 precision in it. For new version and issues, please see:
 https://github.com/fhh2626/colvars
 
+Multiple walkers can share the accumulated forces and counts of the naive(ABF)
+and CZAR estimators on the fly by using the WALKERS_MPI flag together with the
+--multi option of the MD engine. Every WALKERS_MPI_STRIDE steps, the samples
+collected by each walker since the last exchange are summed among all the
+walkers with a single collective call, so that all the walkers bias the
+extended variables with the same estimate of the mean force. The samples of the
+UI estimator are not shared. Alternatively, the .drrstate files of independent
+walkers can be merged after the simulation with the --merge option of \ref drr_tool.
+
 After running eABF/DRR, the \ref drr_tool utility can be used to extract the gradients and counts files from .drrstate. Naive(ABF) estimator's result is in .abf.grad and .abf.count files and CZAR estimator's result is in .czar.grad and .czar.count files. To get PMF, the abf_integrate(https://github.com/Colvars/colvars/tree/master/colvartools) is useful.
 
 \par Examples
@@ -168,6 +177,27 @@ HISTORYFREQ=500000
 ... DRR
 
 PRINT STRIDE=10 ARG=phi,psi FILE=COLVAR
+\endplumedfile
+
+The following input, run with --multi 4, performs a multiple-walker eABF/DRR
+simulation where the walkers exchange their samples every 10 steps:
+\plumedfile
+phi: TORSION ATOMS=5,7,9,15
+psi: TORSION ATOMS=7,9,15,17
+
+DRR ...
+LABEL=eabf
+ARG=phi,psi
+FULLSAMPLES=500
+GRID_MIN=-pi,-pi
+GRID_MAX=pi,pi
+GRID_BIN=180,180
+FRICTION=8.0,8.0
+TAU=0.5,0.5
+OUTPUTFREQ=50000
+WALKERS_MPI
+WALKERS_MPI_STRIDE=10
+... DRR
 \endplumedfile
 
  */
@@ -225,6 +255,10 @@ private:
   CZAR CZARestimator;
   double fullsamples;
   vector<double> maxFactors;
+  bool walkers_mpi;
+  unsigned walkers_mpi_stride;
+  // accumulators of all the walkers at the last exchange
+  vector<double> walkersLastSync;
   UIestimator::UIestimator eabf_UI;
   Random rand;
 
@@ -237,6 +271,10 @@ public:
   void backupFile(const string &filename);
   static void registerKeywords(Keywords &keys);
   bool is_file_exist(const char *fileName);
+  size_t getAccumulatorsSize() const;
+  void getAccumulators(vector<double> &buf) const;
+  void setAccumulators(const vector<double> &buf);
+  void syncWalkers();
 };
 
 PLUMED_REGISTER_ACTION(DynamicReferenceRestraining, "DRR")
@@ -299,6 +337,11 @@ void DynamicReferenceRestraining::registerKeywords(Keywords &keys) {
   keys.add("optional", "DRR_RFILE",
            "specifies the restart file (.drrstate file)");
   keys.addFlag("NOBIAS", false, "DO NOT apply bias forces.");
+  keys.addFlag("WALKERS_MPI", false, "share the accumulated forces and counts "
+               "among multiple walkers running with --multi");
+  keys.add("compulsory", "WALKERS_MPI_STRIDE", "1",
+           "the number of steps between two exchanges of the accumulated "
+           "forces and counts among the walkers (used with WALKERS_MPI)");
   keys.addFlag("TEXTOUTPUT", false, "use text output for grad and count files "
                "instead of boost::serialization binary "
                "output");
@@ -351,7 +394,8 @@ DynamicReferenceRestraining::DynamicReferenceRestraining(
     useCZARestimator(true), useUIestimator(false), textoutput(false),
     withExternalForce(false), withExternalFict(false),
     reflectingWall(getNumberOfArguments(), 0),
-    maxFactors(getNumberOfArguments(), 1.0)
+    maxFactors(getNumberOfArguments(), 1.0),
+    walkers_mpi(false), walkers_mpi_stride(1)
 {
   log << "eABF/DRR: You now are using the extended adaptive biasing "
       "force(eABF) method."
@@ -386,6 +430,11 @@ DynamicReferenceRestraining::DynamicReferenceRestraining(
   parseFlag("NOCZAR", noCZAR);
 //   noCZAR == false ? useCZARestimator = true : useCZARestimator = false;
   parseFlag("TEXTOUTPUT", textoutput);
+  parseFlag("WALKERS_MPI", walkers_mpi);
+  parse("WALKERS_MPI_STRIDE", walkers_mpi_stride);
+  if (walkers_mpi_stride == 0) {
+    error("eABF/DRR: WALKERS_MPI_STRIDE should be positive!");
+  }
   parseVector("TAU", tau);
   parseVector("FRICTION", friction);
   parseVector("EXTTEMP", etemp);
@@ -697,6 +746,14 @@ DynamicReferenceRestraining::DynamicReferenceRestraining(
                 lowerboundary, upperboundary, width, kappa, outputprefix, int(outputfreq),
                 uirestart, input_filename, kbt / plumed.getAtoms().getKBoltzmann());
   }
+  if (walkers_mpi) {
+    log << "eABF/DRR: Sharing the accumulated forces and counts among "
+        << multi_sim_comm.Get_size() << " walkers every "
+        << walkers_mpi_stride << " steps." << '\n';
+    // Samples loaded from a restart file are not exchanged again
+    walkersLastSync.resize(getAccumulatorsSize());
+    getAccumulators(walkersLastSync);
+  }
 }
 
 void DynamicReferenceRestraining::calculate() {
@@ -788,6 +845,9 @@ void DynamicReferenceRestraining::calculate() {
 }
 
 void DynamicReferenceRestraining::update() {
+  if (walkers_mpi && (getStep() % walkers_mpi_stride) == 0) {
+    syncWalkers();
+  }
   if (withExternalForce == false) {
     for (size_t i = 0; i < ndims; ++i) {
       // consider additional forces on the fictitious particle
@@ -823,6 +883,38 @@ void DynamicReferenceRestraining::update() {
   }
 }
 
+size_t DynamicReferenceRestraining::getAccumulatorsSize() const {
+  return ABFGrid.getAccumulatorsSize() + CZARestimator.getAccumulatorsSize();
+}
+
+void DynamicReferenceRestraining::getAccumulators(vector<double> &buf) const {
+  ABFGrid.getAccumulators(buf, 0);
+  CZARestimator.getAccumulators(buf, ABFGrid.getAccumulatorsSize());
+}
+
+void DynamicReferenceRestraining::setAccumulators(const vector<double> &buf) {
+  ABFGrid.setAccumulators(buf, 0);
+  CZARestimator.setAccumulators(buf, ABFGrid.getAccumulatorsSize());
+}
+
+void DynamicReferenceRestraining::syncWalkers() {
+  // Only the samples collected since the last exchange are summed, so that
+  // the ones already shared are not counted twice
+  vector<double> delta(walkersLastSync.size());
+  getAccumulators(delta);
+  for (size_t i = 0; i < delta.size(); ++i) {
+    delta[i] -= walkersLastSync[i];
+  }
+  if (comm.Get_rank() == 0) {
+    multi_sim_comm.Sum(delta);
+  }
+  comm.Bcast(delta, 0);
+  for (size_t i = 0; i < delta.size(); ++i) {
+    walkersLastSync[i] += delta[i];
+  }
+  setAccumulators(walkersLastSync);
+}
+
 void DynamicReferenceRestraining::save(const string &filename,
                                        long long int step) {
   std::ofstream out;
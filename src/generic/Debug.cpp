@@ -42,6 +42,14 @@ DEBUG DETAILED_TIMERS
 DEBUG logRequestedAtoms STRIDE=2
 \endplumedfile
 
+The approximate memory used by the largest data structures of each action (grids, hills, kernels,
+buffers, stored frames) can be written every STRIDE steps. A summary is also written in the log at the end
+of the simulation. The total can be retrieved by the MD code with cmd("getMemoryUsage").
+
+\plumedfile
+DEBUG logMemoryUsage STRIDE=1000 FILE=memory.log
+\endplumedfile
+
 */
 //+ENDPLUMEDOC
 class Debug:
@@ -50,6 +58,7 @@ class Debug:
   OFile ofile;
   bool logActivity;
   bool logRequestedAtoms;
+  bool logMemoryUsage;
   bool novirial;
   bool detailedTimers;
 public:
@@ -68,6 +77,7 @@ void Debug::registerKeywords( Keywords& keys ) {
   keys.add("compulsory","STRIDE","1","the frequency with which this action is to be performed");
   keys.addFlag("logActivity",false,"write in the log which actions are inactive and which are inactive");
   keys.addFlag("logRequestedAtoms",false,"write in the log which atoms have been requested at a given time");
+  keys.addFlag("logMemoryUsage",false,"write the approximate memory used by each action, and a summary at the end of the simulation");
   keys.addFlag("NOVIRIAL",false,"switch off the virial contribution for the entirety of the simulation");
   keys.addFlag("DETAILED_TIMERS",false,"switch on detailed timers");
   keys.add("optional","FILE","the name of the file on which to output these quantities");
@@ -78,11 +88,17 @@ Debug::Debug(const ActionOptions&ao):
   ActionPilot(ao),
   logActivity(false),
   logRequestedAtoms(false),
+  logMemoryUsage(false),
   novirial(false) {
   parseFlag("logActivity",logActivity);
   if(logActivity) log.printf("  logging activity\n");
   parseFlag("logRequestedAtoms",logRequestedAtoms);
   if(logRequestedAtoms) log.printf("  logging requested atoms\n");
+  parseFlag("logMemoryUsage",logMemoryUsage);
+  if(logMemoryUsage) {
+    log.printf("  logging memory usage\n");
+    plumed.memoryReport=true;
+  }
   parseFlag("NOVIRIAL",novirial);
   if(novirial) log.printf("  Switching off virial contribution\n");
   if(novirial) plumed.novirial=true;
@@ -132,6 +148,7 @@ void Debug::apply() {
     ofile.printf("\n");
     plumed.cmd("clearFullList");
   }
+  if(logMemoryUsage) plumed.printMemoryUsage(ofile);
 
 }
 
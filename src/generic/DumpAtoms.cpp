@@ -27,16 +27,12 @@
 #include "core/PlumedMain.h"
 #include "core/Atoms.h"
 #include "tools/Units.h"
+#include "tools/XdrTrajectory.h"
 #include <cstdio>
 #include <memory>
 #include "core/GenericMolInfo.h"
 #include "core/ActionSet.h"
 
-#if defined(__PLUMED_HAS_XDRFILE)
-#include <xdrfile/xdrfile_xtc.h>
-#include <xdrfile/xdrfile_trr.h>
-#endif
-
 
 namespace PLMD
 {
@@ -47,11 +43,7 @@ namespace generic {
 Dump selected atoms on a file.
 
 This command can be used to output the positions of a particular set of atoms.
-The atoms required are output in a xyz or gro formatted file.
-If PLUMED has been compiled with xdrfile support, then also xtc and trr files can be written.
-To this aim one should install xdrfile library (http://www.gromacs.org/Developer_Zone/Programming_Guide/XTC_Library).
-If the xdrfile library is installed properly the PLUMED configure script should be able to
-detect it and enable it.
+The atoms required are output in a xyz, gro, xtc, or trr formatted file.
 The type of file is automatically detected from the file extension, but can be also
 enforced with TYPE.
 Importantly, if your
@@ -99,7 +91,7 @@ DUMPATOMS STRIDE=10 FILE=file.gro ATOMS=1-10,c1
 
 The `file.gro` will contain coordinates expressed in nm, since this is the convention for gro files.
 
-In case you have compiled PLUMED with `xdrfile` library, you might even write xtc or trr files as follows
+You might even write xtc or trr files as follows
 \plumedfile
 COM ATOMS=11-20 LABEL=c1
 DUMPATOMS STRIDE=10 FILE=file.xtc ATOMS=1-10,c1
@@ -133,9 +125,7 @@ class DumpAtoms:
   std::string fmt_gro_pos;
   std::string fmt_gro_box;
   std::string fmt_xyz;
-#if defined(__PLUMED_HAS_XDRFILE)
-  XDRFILE* xd;
-#endif
+  std::unique_ptr<XdrWriter> xd;
 public:
   explicit DumpAtoms(const ActionOptions&);
   ~DumpAtoms();
@@ -156,11 +146,7 @@ void DumpAtoms::registerKeywords( Keywords& keys ) {
   keys.add("compulsory", "FILE", "file on which to output coordinates; extension is automatically detected");
   keys.add("compulsory", "UNITS","PLUMED","the units in which to print out the coordinates. PLUMED means internal PLUMED units");
   keys.add("optional", "PRECISION","The number of digits in trajectory file");
-#if defined(__PLUMED_HAS_XDRFILE)
   keys.add("optional", "TYPE","file type, either xyz, gro, xtc, or trr, can override an automatically detected file extension");
-#else
-  keys.add("optional", "TYPE","file type, either xyz or gro, can override an automatically detected file extension");
-#endif
   keys.use("RESTART");
   keys.use("UPDATE_FROM");
   keys.use("UPDATE_UNTIL");
@@ -192,9 +178,6 @@ DumpAtoms::DumpAtoms(const ActionOptions&ao):
     log<<"  file type enforced to be "<<ntype<<"\n";
     type=ntype;
   }
-#ifndef __PLUMED_HAS_XDRFILE
-  if(type=="xtc" || type=="trr") error("types xtc and trr require PLUMED to be linked with the xdrfile library. Please install it and recompile PLUMED.");
-#endif
 
   fmt_gro_pos="%8.3f";
   fmt_gro_box="%12.7f";
@@ -230,16 +213,11 @@ DumpAtoms::DumpAtoms(const ActionOptions&ao):
   of.open(file);
   std::string path=of.getPath();
   log<<"  Writing on file "<<path<<"\n";
-#ifdef __PLUMED_HAS_XDRFILE
-  std::string mode=of.getMode();
-  if(type=="xtc") {
-    of.close();
-    xd=xdrfile_open(path.c_str(),mode.c_str());
-  } else if(type=="trr") {
+  if(type=="xtc" || type=="trr") {
+    std::string mode=of.getMode();
     of.close();
-    xd=xdrfile_open(path.c_str(),mode.c_str());
+    xd=Tools::make_unique<XdrWriter>(path,type,mode);
   }
-#endif
   log.printf("  printing the following atoms in %s :", unitname.c_str() );
   for(unsigned i=0; i<atoms.size(); ++i) log.printf(" %d",atoms[i].serial() );
   log.printf("\n");
@@ -295,34 +273,20 @@ void DumpAtoms::update() {
               lenunit*t(0,0),lenunit*t(1,1),lenunit*t(2,2),
               lenunit*t(0,1),lenunit*t(0,2),lenunit*t(1,0),
               lenunit*t(1,2),lenunit*t(2,0),lenunit*t(2,1));
-#if defined(__PLUMED_HAS_XDRFILE)
   } else if(type=="xtc" || type=="trr") {
-    matrix box;
+    std::array<float,9> box;
     const Tensor & t(getPbc().getBox());
     int natoms=getNumberOfAtoms();
-    int step=getStep();
     float time=getTime()/plumed.getAtoms().getUnits().getTime();
     float precision=Tools::fastpow(10.0,iprecision);
-    for(int i=0; i<3; i++) for(int j=0; j<3; j++) box[i][j]=lenunit*t(i,j);
-    auto pos = Tools::make_unique<rvec[]>(natoms);
-    for(int i=0; i<natoms; i++) for(int j=0; j<3; j++) pos[i][j]=lenunit*getPosition(i)(j);
-    if(type=="xtc") {
-      write_xtc(xd,natoms,step,time,box,&pos[0],precision);
-    } else if(type=="trr") {
-      write_trr(xd,natoms,step,time,0.0,box,&pos[0],NULL,NULL);
-    }
-#endif
+    for(int i=0; i<3; i++) for(int j=0; j<3; j++) box[3*i+j]=lenunit*t(i,j);
+    std::vector<float> pos(3*natoms);
+    for(int i=0; i<natoms; i++) for(int j=0; j<3; j++) pos[3*i+j]=lenunit*getPosition(i)(j);
+    xd->write(getStep(),time,box,pos,precision);
   } else plumed_merror("unknown file type "+type);
 }
 
 DumpAtoms::~DumpAtoms() {
-#ifdef __PLUMED_HAS_XDRFILE
-  if(type=="xtc") {
-    xdrfile_close(xd);
-  } else if(type=="trr") {
-    xdrfile_close(xd);
-  }
-#endif
 }
 
 
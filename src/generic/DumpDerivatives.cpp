@@ -99,11 +99,11 @@ DumpDerivatives::DumpDerivatives(const ActionOptions&ao):
   log.printf("  with format %s\n",fmt.c_str());
   unsigned nargs=getNumberOfArguments();
   if( nargs==0 ) error("no arguments specified");
-  (getPntrToArgument(0)->getPntrToAction())->turnOnDerivatives();
+  (getPntrToArgument(0)->getPntrToAction())->turnOnDerivativesFor(this);
   unsigned npar=getPntrToArgument(0)->getNumberOfDerivatives();
   if( npar==0 ) error("one or more arguments has no derivatives");
   for(unsigned i=1; i<nargs; i++) {
-    (getPntrToArgument(i)->getPntrToAction())->turnOnDerivatives();
+    (getPntrToArgument(i)->getPntrToAction())->turnOnDerivativesFor(this);
     if( npar!=getPntrToArgument(i)->getNumberOfDerivatives() ) error("the number of derivatives must be the same in all values being dumped");
   }
   checkRead();
@@ -95,7 +95,7 @@ DumpProjections::DumpProjections(const ActionOptions&ao):
   checkRead();
 
   for(unsigned i=0; i<getNumberOfArguments(); ++i) {
-    (getPntrToArgument(i)->getPntrToAction())->turnOnDerivatives();
+    (getPntrToArgument(i)->getPntrToAction())->turnOnDerivativesFor(this);
   }
 }
 
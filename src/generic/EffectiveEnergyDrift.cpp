@@ -65,6 +65,11 @@ RESTRAINT ARG=d KAPPA=100000 AT=0.6
 EFFECTIVE_ENERGY_DRIFT PRINT_STRIDE=100 FILE=eff
 \endplumedfile
 
+When the MD code uses domain decomposition, the positions and forces of the previous step
+are needed also for the atoms that moved to a different processor.
+Only the data of these atoms is communicated, so that the cost of this action
+scales with the number of atoms that migrate and not with the total number of atoms.
+
 */
 //+ENDPLUMEDOC
 
@@ -100,6 +105,7 @@ class EffectiveEnergyDrift:
   std::vector<int> indexR;
   std::vector<double> dataS;
   std::vector<double> dataR;
+/// local index of each atom in the data being mapped, -1 if absent
   std::vector<int> backmap;
 
   double initialBias;
@@ -182,10 +188,7 @@ EffectiveEnergyDrift::EffectiveEnergyDrift(const ActionOptions&ao):
   indexDsp.resize(nProc);
   dataCnt.resize(nProc);
   dataDsp.resize(nProc);
-  //resize the received buffers
-  indexR.resize(atoms.getNatoms());
-  dataR.resize(atoms.getNatoms()*6);
-  backmap.resize(atoms.getNatoms());
+  backmap.assign(atoms.getNatoms(),-1);
 }
 
 EffectiveEnergyDrift::~EffectiveEnergyDrift() {
@@ -228,22 +231,36 @@ void EffectiveEnergyDrift::update() {
 
   //if the dd has changed we have to reshare the stored data
   if(pDdStep<atoms.getDdStep() && nLocalAtoms<atoms.getNatoms()) {
-    //prepare the data to be sent
-    indexS.resize(pNLocalAtoms);
-    dataS.resize(pNLocalAtoms*6);
-
-    for(int i=0; i<pNLocalAtoms; i++) {
-      indexS[i] = pGatindex[i];
-      dataS[i*6] = pPositions[i][0];
-      dataS[i*6+1] = pPositions[i][1];
-      dataS[i*6+2] = pPositions[i][2];
-      dataS[i*6+3] = pForces[i][0];
-      dataS[i*6+4] = pForces[i][1];
-      dataS[i*6+5] = pForces[i][2];
+    //map the atoms that were local at the previous step
+    for(int j=0; j<pNLocalAtoms; j++) backmap[pGatindex[j]]=j;
+
+    //atoms that are still local are copied, the ones that arrived on this rank are missing
+    std::vector<Vector> newPositions(nLocalAtoms);
+    std::vector<Vector> newForces(nLocalAtoms);
+    std::vector<char> kept(pNLocalAtoms,0);
+    std::vector<int> missing;
+    for(int i=0; i<nLocalAtoms; i++) {
+      int j=backmap[gatindex[i]];
+      if(j>=0) {
+        newPositions[i]=pPositions[j];
+        newForces[i]=pForces[j];
+        kept[j]=1;
+      } else missing.push_back(i);
     }
+    for(int j=0; j<pNLocalAtoms; j++) backmap[pGatindex[j]]=-1;
+
+    //prepare the data of the atoms that left this rank
+    indexS.clear();
+    dataS.clear();
+    for(int j=0; j<pNLocalAtoms; j++) if(!kept[j]) {
+        indexS.push_back(pGatindex[j]);
+        for(unsigned k=0; k<3; k++) dataS.push_back(pPositions[j][k]);
+        for(unsigned k=0; k<3; k++) dataS.push_back(pForces[j][k]);
+      }
+    int nS=indexS.size();
 
     //setup the counters and displacements for the communication
-    plumed.comm.Allgather(&pNLocalAtoms,1,&indexCnt[0],1);
+    plumed.comm.Allgather(&nS,1,&indexCnt[0],1);
     indexDsp[0] = 0;
     for(int i=0; i<nProc; i++) {
       dataCnt[i] = indexCnt[i]*6;
@@ -251,30 +268,35 @@ void EffectiveEnergyDrift::update() {
       if(i+1<nProc) indexDsp[i+1] = indexDsp[i]+indexCnt[i];
       dataDsp[i] = indexDsp[i]*6;
     }
-
-    //share stored data
-    plumed.comm.Allgatherv((!indexS.empty()?&indexS[0]:NULL), pNLocalAtoms, &indexR[0], &indexCnt[0], &indexDsp[0]);
-    plumed.comm.Allgatherv((!dataS.empty()?&dataS[0]:NULL), pNLocalAtoms*6, &dataR[0], &dataCnt[0], &dataDsp[0]);
-
-    //resize vectors to store the proper amount of data
-    pGatindex.resize(nLocalAtoms);
-    pPositions.resize(nLocalAtoms);
-    pForces.resize(nLocalAtoms);
-
-    //compute backmap
-    for(unsigned j=0; j<indexR.size(); j++) backmap[indexR[j]]=j;
-
-    //fill the vectors pGatindex, pPositions and pForces
-    for(int i=0; i<nLocalAtoms; i++) {
-      int glb=backmap[gatindex[i]];
-      pGatindex[i] = indexR[glb];
-      pPositions[i][0] = dataR[glb*6];
-      pPositions[i][1] = dataR[glb*6+1];
-      pPositions[i][2] = dataR[glb*6+2];
-      pForces[i][0] = dataR[glb*6+3];
-      pForces[i][1] = dataR[glb*6+4];
-      pForces[i][2] = dataR[glb*6+5];
+    int nR=indexDsp[nProc-1]+indexCnt[nProc-1];
+
+    //share the data of the migrated atoms only
+    if(nR>0) {
+      indexR.resize(nR);
+      dataR.resize(nR*6);
+      plumed.comm.Allgatherv((!indexS.empty()?&indexS[0]:NULL), nS, &indexR[0], &indexCnt[0], &indexDsp[0]);
+      plumed.comm.Allgatherv((!dataS.empty()?&dataS[0]:NULL), nS*6, &dataR[0], &dataCnt[0], &dataDsp[0]);
+
+      //pick the atoms that arrived on this rank
+      for(int j=0; j<nR; j++) backmap[indexR[j]]=j;
+      for(const auto & i : missing) {
+        int glb=backmap[gatindex[i]];
+        plumed_massert(glb>=0,"EFFECTIVE_ENERGY_DRIFT: previous data of an atom was not found on any rank");
+        newPositions[i][0] = dataR[glb*6];
+        newPositions[i][1] = dataR[glb*6+1];
+        newPositions[i][2] = dataR[glb*6+2];
+        newForces[i][0] = dataR[glb*6+3];
+        newForces[i][1] = dataR[glb*6+4];
+        newForces[i][2] = dataR[glb*6+5];
+      }
+      for(int j=0; j<nR; j++) backmap[indexR[j]]=-1;
+    } else {
+      plumed_massert(missing.empty(),"EFFECTIVE_ENERGY_DRIFT: previous data of an atom was not found on any rank");
     }
+
+    pGatindex = gatindex;
+    pPositions.swap(newPositions);
+    pForces.swap(newForces);
   }
 
   //compute the effective energy drift on local atoms
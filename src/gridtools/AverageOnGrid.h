@@ -28,6 +28,8 @@ namespace PLMD {
 namespace gridtools {
 
 class AverageOnGrid : public HistogramOnGrid {
+protected:
+  bool storesUnweightedKernels() const override { return true; }
 public:
   static void registerKeywords( Keywords& keys );
   explicit AverageOnGrid( const vesselbase::VesselOptions& da );
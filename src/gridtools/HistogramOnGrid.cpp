@@ -21,6 +21,9 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "HistogramOnGrid.h"
 #include "tools/KernelFunctions.h"
+#include "tools/Communicator.h"
+#include "tools/OpenMP.h"
+#include "vesselbase/ActionWithVessel.h"
 
 namespace PLMD {
 namespace gridtools {
@@ -201,6 +204,93 @@ void HistogramOnGrid::getFinalForces( const std::vector<double>& buffer, std::ve
   }
 }
 
+bool HistogramOnGrid::hasSeparableKernels() const {
+  if( getType()!="flat" || discrete || noderiv || addOneKernelAtATime || wasForced() ) return false;
+  return kerneltype=="gaussian" || kerneltype=="GAUSSIAN" || kerneltype=="truncated-gaussian" || kerneltype=="TRUNCATED-GAUSSIAN";
+}
+
+void HistogramOnGrid::addSeparableKernels( const std::vector<double>& centers, const std::vector<double>& weights, const bool& serial ) {
+  plumed_dbg_assert( hasSeparableKernels() && centers.size()==dimension*weights.size() );
+  // The normalized height is the same for every kernel so get it by evaluating one kernel at its center
+  std::vector<double> zero( dimension, 0.0 ), der( dimension );
+  KernelFunctions kernel( zero, bandwidths, kerneltype, "DIAGONAL", 1.0 );
+  std::vector<std::unique_ptr<Value>> vv( getVectorOfValues() ); kernel.normalize( Tools::unique2raw(vv) );
+  for(unsigned i=0; i<dimension; ++i) vv[i]->set( 0.0 );
+  double height = kernel.evaluate( Tools::unique2raw(vv), der, false );
+
+  // Get the shape of the grid.  Points are flattened so that the first index runs fastest
+  std::vector<unsigned> nbin( getNbin() ), gstride( dimension );
+  std::vector<double> gmin( dimension ), period( dimension, 0.0 ), iperiod( dimension, 0.0 );
+  unsigned np=1;
+  for(unsigned i=0; i<dimension; ++i) {
+    Tools::convert( str_min[i], gmin[i] );
+    if( pbc[i] ) { double gmax; Tools::convert( str_max[i], gmax ); period[i]=gmax-gmin[i]; iperiod[i]=1.0/period[i]; }
+    else nbin[i]++;
+    gstride[i]=np; np*=nbin[i];
+  }
+  plumed_dbg_assert( np==getNumberOfPoints() );
+  unsigned nw=dimension+1; bool unweighted=storesUnweightedKernels();
+  plumed_dbg_assert( nper==(unweighted ? 2*nw : nw) );
+  separable_buffer.assign( nper*np, 0.0 );
+
+  // Kernels are divided between the MPI processes while each thread owns a slab of the grid
+  // along the last direction.  Every grid point is thus only updated by one thread and the kernels
+  // are added in the same order whatever the number of threads.
+  unsigned rank=getAction()->comm.Get_rank(), size=getAction()->comm.Get_size();
+  if( serial ) { rank=0; size=1; }
+  unsigned last=dimension-1, nslab=nbin[last];
+  unsigned nt=OpenMP::getNumThreads();
+  if( nt*1000>weights.size()*neigh_tot ) nt=1;
+  if( nt>nslab ) nt=nslab;
+  #pragma omp parallel num_threads(nt)
+  {
+    unsigned tid=OpenMP::getThreadNum();
+    int lo=(tid*nslab)/nt, hi=((tid+1)*nslab)/nt;
+    std::vector<std::vector<unsigned> > sind( dimension );
+    std::vector<std::vector<double> > sval( dimension ), sder( dimension );
+    std::vector<unsigned> spos( dimension );
+    for(unsigned k=rank; k<weights.size(); k+=size) {
+      // Build the one dimensional stencils starting from the direction that is split between threads
+      bool empty=false;
+      for(unsigned ii=0; ii<dimension; ++ii) {
+        unsigned i=last-ii; double c=centers[k*dimension+i]; int n=nbin[i];
+        sind[i].resize(0); sval[i].resize(0); sder[i].resize(0);
+        int ic=std::floor( (c-gmin[i])/dx[i] ), nn=nneigh[i];
+        for(int j=ic-nn; j<=ic+nn; ++j) {
+          int i0=j;
+          if( pbc[i] ) { i0%=n; if( i0<0 ) i0+=n; }
+          else if( i0<0 || i0>=n ) continue;
+          if( i==last && (i0<lo || i0>=hi) ) continue;
+          double diff = c - ( gmin[i] + dx[i]*i0 );
+          if( pbc[i] ) diff = Tools::pbc( diff*iperiod[i] )*period[i];
+          double u = diff / bandwidths[i];
+          sind[i].push_back( gstride[i]*i0 ); sval[i].push_back( std::exp(-0.5*u*u) ); sder[i].push_back( u / bandwidths[i] );
+        }
+        if( sind[i].empty() ) { empty=true; break; }
+      }
+      if( empty ) continue;
+      // And add the products of the stencils to the grid
+      unsigned npts=1; for(unsigned i=0; i<dimension; ++i) npts*=sind[i].size();
+      for(unsigned p=0; p<npts; ++p) {
+        unsigned rem=p, ip=0; double kval=height;
+        for(unsigned i=0; i<dimension; ++i) {
+          unsigned m=rem%sind[i].size(); rem/=sind[i].size();
+          spos[i]=m; ip+=sind[i][m]; kval*=sval[i][m];
+        }
+        if( inactive( ip ) ) continue;
+        double* bb=separable_buffer.data() + nper*ip; double wval=weights[k]*kval;
+        bb[0]+=wval; for(unsigned i=0; i<dimension; ++i) bb[1+i]+=wval*sder[i][spos[i]];
+        if( unweighted ) {
+          bb+=nper-nw; bb[0]+=kval;
+          for(unsigned i=0; i<dimension; ++i) bb[1+i]+=kval*sder[i][spos[i]];
+        }
+      }
+    }
+  }
+  if( size>1 ) getAction()->comm.Sum( separable_buffer );
+  for(unsigned i=0; i<separable_buffer.size(); ++i) addDataElement( i, separable_buffer[i] );
+}
+
 void HistogramOnGrid::finish( const std::vector<double>& buffer ) {
   if( addOneKernelAtATime ) {
     for(unsigned i=0; i<getAction()->getCurrentNumberOfActiveTasks(); ++i) {
@@ -38,8 +38,12 @@ private:
   std::string kerneltype;
   std::vector<double> bandwidths;
   std::vector<unsigned> nneigh;
+/// Scratch space used when kernels are added as products of one dimensional stencils
+  std::vector<double> separable_buffer;
 protected:
   bool discrete;
+/// Does accumulate also store the sum of the kernels without the weights
+  virtual bool storesUnweightedKernels() const { return false; }
 public:
   double  von_misses_norm;
   double von_misses_concentration;
@@ -58,6 +62,12 @@ public:
   void getFinalForces( const std::vector<double>& buffer, std::vector<double>& finalForces ) override;
   bool noDiscreteKernels() const ;
   double getFibonacciCutoff() const override;
+/// Can the kernels be added to the grid as products of one dimensional stencils
+  bool hasSeparableKernels() const ;
+/// Add a set of kernels to the grid using one dimensional stencils.  centers contains the dimension coordinates
+/// of each kernel one after the other and weights the weight of each kernel.  Unless serial is set the kernels
+/// are divided between the MPI processes of the action
+  void addSeparableKernels( const std::vector<double>& centers, const std::vector<double>& weights, const bool& serial );
 };
 
 inline
@@ -22,6 +22,7 @@
 #include "Mapping.h"
 #include "TrigonometricPathVessel.h"
 #include "PathReparameterization.h"
+#include "tools/OpenMP.h"
 #include "reference/Direction.h"
 #include "core/ActionRegister.h"
 #include "core/PlumedMain.h"
@@ -225,6 +226,8 @@ void AdaptivePath::update() {
   // This does the update of the path if it is time to
   if( (getStep()>0) && (getStep()%update_str==0) ) {
     wsum[fixedn[0]]=wsum[fixedn[1]]=0.;
+    unsigned nt=OpenMP::getNumThreads(); if( getNumberOfReferencePoints()<2*nt ) nt=1;
+    #pragma omp parallel for num_threads(nt)
     for(unsigned inode=0; inode<getNumberOfReferencePoints(); ++inode) {
       if( wsum[inode]>0 ) {
         // First displace the node by the weighted direction
@@ -234,7 +237,7 @@ void AdaptivePath::update() {
       }
     }
     // Now ensure all the nodes of the path are equally spaced
-    PathReparameterization myspacings( getPbc(), getArguments(), getAllReferenceConfigurations() );
+    PathReparameterization myspacings( getPbc(), getArguments(), getAllReferenceConfigurations(), comm );
     myspacings.reparameterize( fixedn[0], fixedn[1], tolerance );
   }
   if( (getStep()>0) && (getStep()%wstride==0) ) {
@@ -20,17 +20,18 @@
    along with plumed.  If not, see <http://www.gnu.org/licenses/>.
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "PathReparameterization.h"
+#include "tools/OpenMP.h"
+#include "tools/Tools.h"
+#include <algorithm>
 
 namespace PLMD {
 namespace mapping {
 
-PathReparameterization::PathReparameterization( const Pbc& ipbc, const std::vector<Value*>& iargs, std::vector<std::unique_ptr<ReferenceConfiguration>>& pp ):
-  mydpack( 1, pp[0]->getNumberOfReferenceArguments() + 3*pp[0]->getNumberOfReferencePositions() + 9 ),
-  mypack( pp[0]->getNumberOfReferenceArguments(), pp[0]->getNumberOfReferencePositions(), mydpack ),
-  mydir(ReferenceConfigurationOptions("DIRECTION")),
+PathReparameterization::PathReparameterization( const Pbc& ipbc, const std::vector<Value*>& iargs, std::vector<std::unique_ptr<ReferenceConfiguration>>& pp, Communicator& cc ):
   pbc(ipbc),
   args(iargs),
   mypath(pp),
+  comm(cc),
   len(pp.size()),
   sumlen(pp.size()),
   sfrac(pp.size()),
@@ -38,7 +39,15 @@ PathReparameterization::PathReparameterization( const Pbc& ipbc, const std::vect
 {
   mypdb.setAtomNumbers(  pp[0]->getAbsoluteIndexes() ); mypdb.addBlockEnd( pp[0]->getAbsoluteIndexes().size() );
   if( pp[0]->getArgumentNames().size()>0 ) mypdb.setArgumentNames( pp[0]->getArgumentNames() );
-  mydir.read( mypdb ); mydir.zeroDirection(); pp[0]->setupPCAStorage( mypack );
+  unsigned nargs=pp[0]->getNumberOfReferenceArguments(), natoms=pp[0]->getNumberOfReferencePositions();
+  for(unsigned t=0; t<OpenMP::getNumThreads(); ++t) {
+    mydpacks.emplace_back( Tools::make_unique<MultiValue>( 1, nargs + 3*natoms + 9 ) );
+    mypacks.emplace_back( Tools::make_unique<ReferenceValuePack>( nargs, natoms, *mydpacks[t] ) );
+    pp[0]->setupPCAStorage( *mypacks[t] );
+  }
+  for(unsigned i=0; i<pp.size(); ++i) {
+    displacements.push_back( Direction(ReferenceConfigurationOptions("DIRECTION")) ); displacements[i].read( mypdb );
+  }
 }
 
 bool PathReparameterization::loopEnd( const int& index, const int& end, const int& inc ) const {
@@ -50,16 +59,50 @@ bool PathReparameterization::loopEnd( const int& index, const int& end, const in
 void PathReparameterization::calcCurrentPathSpacings( const int& istart, const int& iend ) {
   plumed_dbg_assert( istart<len.size() && iend<len.size() );
   len[istart] = sumlen[istart]=0;
-  //printf("HELLO PATH SPACINGS ARE CURRENTLY \n");
 
   // Get the spacings given we can go forward and backwards
   int incr=1; if( istart>iend ) { incr=-1; }
+  std::vector<int> frames;
+  for(int i=istart+incr; loopEnd(i,iend+incr,incr)==false; i+=incr) frames.push_back(i);
+
+  // The alignments between consecutive frames are divided between ranks and threads
+  unsigned stride=comm.Get_size(), rank=comm.Get_rank();
+  unsigned nt=std::min( static_cast<unsigned>(mypacks.size()), OpenMP::getNumThreads() );
+  if( frames.size()<2*stride ) nt=1;
+  #pragma omp parallel num_threads(nt)
+  {
+    ReferenceValuePack& mypack( *mypacks[OpenMP::getThreadNum()] );
+    #pragma omp for schedule(dynamic,1)
+    for(unsigned j=rank; j<frames.size(); j+=stride) {
+      int i=frames[j];
+      len[i] = mypath[i-incr]->calc( mypath[i]->getReferencePositions(), pbc, args, mypath[i]->getReferenceArguments(), mypack, false );
+      mypath[i-incr]->extractDisplacementVector( mypath[i]->getReferencePositions(), args, mypath[i]->getReferenceArguments(), false, displacements[i] );
+    }
+  }
 
-  for(int i=istart+incr; loopEnd(i,iend+incr,incr)==false; i+=incr) {
-    len[i] = mypath[i-incr]->calc( mypath[i]->getReferencePositions(), pbc, args, mypath[i]->getReferenceArguments(), mypack, false );
-    sumlen[i] = sumlen[i-incr] + len[i];
-    //printf("FRAME %d TO FRAME %d EQUALS %f : %f \n",i-incr,i,len[i],sumlen[i] );
+  if( stride>1 ) {
+    // Share the displacements between all the ranks
+    unsigned natoms=displacements[0].getReferencePositions().size(), nargs=displacements[0].getReferenceArguments().size();
+    unsigned nvals=3*natoms+nargs; buffer.assign( frames.size()*nvals, 0.0 );
+    for(unsigned j=rank; j<frames.size(); j+=stride) {
+      const Direction& mydir( displacements[frames[j]] );
+      for(unsigned n=0; n<natoms; ++n) for(unsigned k=0; k<3; ++k) buffer[j*nvals+3*n+k]=mydir.getReferencePositions()[n][k];
+      for(unsigned n=0; n<nargs; ++n) buffer[j*nvals+3*natoms+n]=mydir.getReferenceArguments()[n];
+    }
+    std::vector<double> flen( frames.size(), 0.0 );
+    for(unsigned j=rank; j<frames.size(); j+=stride) flen[j]=len[frames[j]];
+    comm.Sum( flen ); comm.Sum( buffer );
+    for(unsigned j=0; j<frames.size(); ++j) len[frames[j]]=flen[j];
+    std::vector<Vector> pos( natoms ); std::vector<double> dargs( nargs );
+    for(unsigned j=0; j<frames.size(); ++j) {
+      if( j%stride==rank ) continue;
+      for(unsigned n=0; n<natoms; ++n) for(unsigned k=0; k<3; ++k) pos[n][k]=buffer[j*nvals+3*n+k];
+      for(unsigned n=0; n<nargs; ++n) dargs[n]=buffer[j*nvals+3*natoms+n];
+      displacements[frames[j]].setDirection( pos, dargs );
+    }
   }
+
+  for(unsigned j=0; j<frames.size(); ++j) sumlen[frames[j]] = sumlen[frames[j]-incr] + len[frames[j]];
 }
 
 void PathReparameterization::reparameterizePart( const int& istart, const int& iend, const double& target, const double& TOL ) {
@@ -95,25 +138,29 @@ void PathReparameterization::reparameterizePart( const int& istart, const int& i
     }
 
     // Now compute positions of new nodes in path
-    for(int i=istart+incr; loopEnd(i,cfin,incr)==false; i+=incr) {
-      int k = istart;
+    std::vector<int> nodes;
+    for(int i=istart+incr; loopEnd(i,cfin,incr)==false; i+=incr) nodes.push_back(i);
+    std::vector<int> kprev( nodes.size() );
+    for(unsigned j=0; j<nodes.size(); ++j) {
+      int i=nodes[j], k = istart;
       while( !((sumlen[k] < sfrac[i]) && (sumlen[k+incr]>=sfrac[i])) ) {
         k+=incr;
         if( cfin==iend && k>= iend+1 ) plumed_merror("path reparameterization error");
         else if( cfin==(iend+1) && k>=iend ) { k=iend-1; break; }
         else if( cfin==(iend-1) && k<=iend ) { k=iend+1; break; }
       }
+      kprev[j]=k;
+    }
+    // The displacements between frames were computed with the spacings so each node is moved independently
+    unsigned nt=OpenMP::getNumThreads(); if( nodes.size()<2 ) nt=1;
+    #pragma omp parallel for num_threads(nt)
+    for(unsigned j=0; j<nodes.size(); ++j) {
+      int i=nodes[j], k=kprev[j];
       double dr = (sfrac[i]-sumlen[k])/len[k+incr];
-      // Calculate the displacement between the appropriate points
-      // double dd = mypath[k]->calc( mypath[k+incr]->getReferencePositions(), pbc, args, mypath[k+incr]->getReferenceArguments(), mypack, true );
       // Copy the reference configuration from the configuration to a tempory direction
       newpath[i].setDirection( mypath[k]->getReferencePositions(), mypath[k]->getReferenceArguments() );
-      // Get the displacement of the path
-      mypath[k]->extractDisplacementVector( mypath[k+incr]->getReferencePositions(), args, mypath[k+incr]->getReferenceArguments(), false, mydir );
-      // Set our direction equal to the displacement
-      // mydir.setDirection( mypack );
-      // Shift the reference configuration by this amount
-      newpath[i].displaceReferenceConfiguration( dr, mydir );
+      // Shift the reference configuration by the displacement between frame k and the next one
+      newpath[i].displaceReferenceConfiguration( dr, displacements[k+incr] );
     }
 
     // Copy the positions of the new path to the new paths
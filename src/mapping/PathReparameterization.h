@@ -25,6 +25,7 @@
 #include "reference/ReferenceConfiguration.h"
 #include "reference/Direction.h"
 #include "tools/PDB.h"
+#include "tools/Communicator.h"
 #include <memory>
 
 
@@ -38,29 +39,33 @@ class PathReparameterization {
 private:
 /// This is used when setting up frames
   PDB mypdb;
-/// Packs that we use to store the vectors connecting frames
-  MultiValue mydpack;
-  ReferenceValuePack mypack;
-/// Direction that is used to reparameterize configurations
-  Direction mydir;
+/// Packs that each thread uses to calculate the distances between frames
+  std::vector<std::unique_ptr<MultiValue> > mydpacks;
+  std::vector<std::unique_ptr<ReferenceValuePack> > mypacks;
+/// The displacement from the previous frame in the loop to each frame
+  std::vector<Direction> displacements;
 /// The PBC object that you would like to use to calculate distances
   const Pbc& pbc;
 /// The underlying value object for the arguments
   const std::vector<Value*>& args;
 /// Reference to path that we are reparameterizing
   const std::vector<std::unique_ptr<ReferenceConfiguration>>& mypath;
+/// The communicator used to divide the frames between ranks
+  Communicator& comm;
 /// These are the current separations and the total length of the path
   std::vector<double> len, sumlen, sfrac;
+/// Buffer used to share the displacements between ranks
+  std::vector<double> buffer;
 /// Maximum number of cycles in path reparameterization
   unsigned MAXCYCLES;
 /// This function is used to work out when we are at loop ends as we go through them in positive and negative order
   bool loopEnd( const int& index, const int& end, const int& inc ) const ;
-/// Calculate the current spacings for the frames between istart and iend and return the average spacing
+/// Calculate the current spacings and displacements for the frames between istart and iend
   void calcCurrentPathSpacings( const int& istart, const int& iend );
 /// Reparameterize the frames of the path between istart and iend and make the spacing equal to target
   void reparameterizePart( const int& istart, const int& iend, const double& target, const double& TOL );
 public:
-  PathReparameterization( const Pbc& ipbc, const std::vector<Value*>& iargs, std::vector<std::unique_ptr<ReferenceConfiguration>>& pp );
+  PathReparameterization( const Pbc& ipbc, const std::vector<Value*>& iargs, std::vector<std::unique_ptr<ReferenceConfiguration>>& pp, Communicator& cc );
 /// Reparameterize the frames of the path between istart and iend so as to make the spacing constant
   void reparameterize( const int& istart, const int& iend, const double& TOL );
 };
@@ -180,7 +180,7 @@ int PathTools::main(FILE* in, FILE*out,Communicator& pc) {
 
     auto vals_ptr=Tools::unique2raw(vals);
     // And reparameterize
-    PathReparameterization myparam( fake_pbc, vals_ptr, frames );
+    PathReparameterization myparam( fake_pbc, vals_ptr, frames, pc );
     // And make all points equally spaced
     double tol; parse("--tolerance",tol); myparam.reparameterize( fixed[0], fixed[1], tol );
 
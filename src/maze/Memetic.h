@@ -337,9 +337,16 @@ void Memetic::initialize_members() {
 }
 
 void Memetic::score_members() {
+  std::vector<Vector> translations(members_.size());
   for (size_t i = 0; i < members_.size(); ++i) {
-    double s = score_member(members_[i].translation);
-    members_[i].score=s;
+    translations[i] = members_[i].translation;
+  }
+
+  std::vector<double> scores;
+  score(translations, scores);
+
+  for (size_t i = 0; i < members_.size(); ++i) {
+    members_[i].score=scores[i];
   }
 }
 
@@ -551,9 +558,12 @@ void Memetic::adaptive_random_search(
       tmp[i] = 2.0 * (xk[i] - chi[i]);
     }
 
-    double score_chi = score_member(chi);
-    double score_xk = score_member(xk);
-    double score_tmp = score_member(tmp);
+    std::vector<double> scores;
+    score({chi, xk, tmp}, scores);
+
+    double score_chi = scores[0];
+    double score_xk = scores[1];
+    double score_tmp = scores[2];
 
     if (score_chi < score_xk) {
       ns++;
@@ -659,34 +669,10 @@ bool Memetic::out_of_bounds(double v) {
 }
 
 double Memetic::score_member(const Vector& coding) {
-  double action = 0;
-  Vector distance;
-  const unsigned nl_size = neighbor_list_->size();
-  Vector dev = coding;
-
-  #pragma omp parallel num_threads(get_n_threads_openmp())
-  {
-    #pragma omp for reduction(+:action)
-    for (unsigned int i = 0; i < nl_size; i++) {
-      unsigned i0 = neighbor_list_->getClosePair(i).first;
-      unsigned i1 = neighbor_list_->getClosePair(i).second;
-
-      if (getAbsoluteIndex(i0) == getAbsoluteIndex(i1)) {
-        continue;
-      }
-
-      if (pbc_) {
-        distance = pbcDistance(getPosition(i0) + dev, getPosition(i1));
-      }
-      else {
-        distance = delta(getPosition(i0) + dev, getPosition(i1));
-      }
-
-      action += pairing(distance.modulo());
-    }
-  }
+  std::vector<double> scores;
+  score(std::vector<Vector>(1, coding), scores);
 
-  return action;
+  return scores[0];
 }
 
 void Memetic::print_status() const {
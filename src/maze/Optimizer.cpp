@@ -414,14 +414,29 @@ void Optimizer::prepare() {
 }
 
 double Optimizer::score() {
+  std::vector<Vector> translations(1, Vector(0, 0, 0));
+  std::vector<double> scores;
+  score(translations, scores);
+
+  return scores[0];
+}
+
+void Optimizer::score(
+  const std::vector<Vector>& translations,
+  std::vector<double>& scores)
+{
   const unsigned nl_size = neighbor_list_->size();
-  Vector distance;
-  double function = 0;
+  const unsigned n_trans = translations.size();
+  scores.assign(n_trans, 0.0);
 
   #pragma omp parallel num_threads(n_threads_)
   {
-    #pragma omp for reduction(+:function)
-    for(unsigned int i = 0; i < nl_size; i++) {
+    // Scores accumulated by this thread.
+    std::vector<double> omp_scores(n_trans, 0.0);
+    std::vector<double> distances(n_trans, 0.0);
+
+    #pragma omp for nowait
+    for (unsigned int i = 0; i < nl_size; i++) {
       unsigned i0 = neighbor_list_->getClosePair(i).first;
       unsigned i1 = neighbor_list_->getClosePair(i).second;
 
@@ -429,18 +444,30 @@ double Optimizer::score() {
         continue;
       }
 
+      const Vector p0 = getPosition(i0);
+      const Vector p1 = getPosition(i1);
+
       if (pbc_) {
-        distance = pbcDistance(getPosition(i0), getPosition(i1));
+        for (unsigned int k = 0; k < n_trans; k++) {
+          distances[k] = pbcDistance(p0 + translations[k], p1).modulo();
+        }
       }
       else {
-        distance = delta(getPosition(i0), getPosition(i1));
+        for (unsigned int k = 0; k < n_trans; k++) {
+          distances[k] = delta(p0 + translations[k], p1).modulo();
+        }
       }
 
-      function += pairing(distance.modulo());
+      for (unsigned int k = 0; k < n_trans; k++) {
+        omp_scores[k] += pairing(distances[k]);
+      }
     }
-  }
 
-  return function;
+    #pragma omp critical
+    for (unsigned int k = 0; k < n_trans; k++) {
+      scores[k] += omp_scores[k];
+    }
+  }
 }
 
 void Optimizer::update_nl() {
@@ -102,6 +102,17 @@ public:
    */
   double score();
 
+  /**
+   * Score a population of ligand translations in a single pass over the
+   * ligand-protein pairs in the neighbor list. Pairs are distributed among
+   * OpenMP threads and, for each pair, the inner loop runs over the candidate
+   * translations, so that the positions of a pair are loaded only once.
+   *
+   * @param[in] translations translations of the ligand to be scored
+   * @param[out] scores score of each translation
+   */
+  void score(const std::vector<Vector>& translations, std::vector<double>& scores);
+
   /**
    * Calculate sampling radius as the minimal distance between two groups in
    * neighbors list.
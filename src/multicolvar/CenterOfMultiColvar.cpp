@@ -123,7 +123,7 @@ CenterOfMultiColvar::CenterOfMultiColvar(const ActionOptions&ao):
     requestAtoms( mycolv->getAbsoluteIndexes () );
   }
   // We need the derivatives
-  mycolv->turnOnDerivatives(); addDependency(mycolv);
+  mycolv->turnOnDerivativesFor(this); addDependency(mycolv);
   mystash = mycolv->buildDataStashes( NULL );
   log.printf("  building center of mass based on weights calculated in multicolvar action named %s \n",mycolv->getLabel().c_str() );
 }
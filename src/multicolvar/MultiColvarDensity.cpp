@@ -80,6 +80,12 @@ because the CLEAR=1 keyword is set on the MULTICOLVARDENS line each Gaussian cub
 model for a particular trajectory frame. The average value accumulated thus far is cleared at the start of every single
 timestep and there is no averaging over trajectory frames in this case.
 
+When Gaussian or truncated Gaussian kernels are used the kernels are added to the grid by multiplying together
+one dimensional stencils for each of the grid directions.  This is much faster than evaluating each kernel
+separately at every grid point within its support.  The grid is divided into slabs along its last direction
+when multiple OpenMP threads are used so the result does not depend on the number of threads.  The NOSTENCILS
+flag can be used to revert to the slower method.
+
 */
 //+ENDPLUMEDOC
 
@@ -93,6 +99,12 @@ class MultiColvarDensity : public gridtools::ActionWithGrid {
   vesselbase::StoreDataVessel* stash;
   Vector origin;
   std::vector<unsigned> directions;
+/// The grid if the kernels can be added using one dimensional stencils
+  gridtools::HistogramOnGrid* stencilgrid;
+/// The centers and weights of the kernels that are added to the grid
+  std::vector<double> kcenters, kweights;
+/// Get the position of atom current in the coordinates of the grid
+  Vector getGridPosition( const unsigned& current ) const ;
 public:
   explicit MultiColvarDensity(const ActionOptions&);
   static void registerKeywords( Keywords& keys );
@@ -100,6 +112,7 @@ public:
   bool isPeriodic() override { return false; }
   void clearAverage() override;
   void prepareForAveraging() override;
+  void performOperations( const bool& from_update ) override;
   void compute( const unsigned&, MultiValue& ) const override;
   void apply() override {}
 };
@@ -114,6 +127,7 @@ void MultiColvarDensity::registerKeywords( Keywords& keys ) {
   keys.add("optional","NBINS","the number of bins to use to represent the density profile");
   keys.add("optional","SPACING","the approximate grid spacing (to be used as an alternative or together with NBINS)");
   keys.addFlag("FRACTIONAL",false,"use fractional coordinates for the various axes");
+  keys.addFlag("NOSTENCILS",false,"do not add Gaussian kernels to the grid using products of one dimensional stencils");
   keys.addFlag("XREDUCED",false,"limit the calculation of the density/average to a portion of the z-axis only");
   keys.add("optional","XLOWER","this is required if you are using XREDUCED. It specifies the lower bound for the region of the x-axis that for "
            "which you are calculating the density/average");
@@ -133,7 +147,8 @@ void MultiColvarDensity::registerKeywords( Keywords& keys ) {
 
 MultiColvarDensity::MultiColvarDensity(const ActionOptions&ao):
   Action(ao),
-  ActionWithGrid(ao)
+  ActionWithGrid(ao),
+  stencilgrid(NULL)
 {
   std::vector<AtomNumber> atom;
   parseAtomList("ORIGIN",atom);
@@ -229,8 +244,14 @@ MultiColvarDensity::MultiColvarDensity(const ActionOptions&ao):
   if( mycolv->isDensity() ) grid=createGrid( "histogram", vstring );
   else grid=createGrid( "average", vstring );
   mygrid=grid.get();
+  // Check if we can use one dimensional stencils to add the kernels
+  bool nostencils; parseFlag("NOSTENCILS",nostencils);
+  gridtools::HistogramOnGrid* hgrid=dynamic_cast<gridtools::HistogramOnGrid*>( mygrid );
+  if( !nostencils && hgrid && hgrid->hasSeparableKernels() ) {
+    stencilgrid=hgrid; log.printf("  adding kernels to grid using products of one dimensional stencils\n");
+  }
   // And finish the grid setup
-  setAveragingAction( std::move(grid), true );
+  setAveragingAction( std::move(grid), !stencilgrid );
 
   // Enusre units for cube files are set correctly
   if( !fractional ) {
@@ -284,10 +305,30 @@ void MultiColvarDensity::prepareForAveraging() {
   origin = getPosition(0);
 }
 
+Vector MultiColvarDensity::getGridPosition( const unsigned& current ) const {
+  Vector apos = pbcDistance( origin, mycolv->getCentralAtomPos( mycolv->getPositionInFullTaskList(current) ) );
+  if( fractional ) return getPbc().realToScaled( apos );
+  return apos;
+}
+
+void MultiColvarDensity::performOperations( const bool& from_update ) {
+  // Fall back on the task list if the grid is forced
+  if( !stencilgrid->hasSeparableKernels() ) { runAllTasks(); return; }
+  unsigned nk=getCurrentNumberOfActiveTasks(), ndir=directions.size();
+  kcenters.resize( ndir*nk ); kweights.resize( nk );
+  std::vector<double> cvals( mycolv->getNumberOfQuantities() );
+  for(unsigned i=0; i<nk; ++i) {
+    unsigned current=getActiveTask(i); stash->retrieveSequentialValue( current, false, cvals );
+    Vector fpos=getGridPosition( current );
+    for(unsigned j=0; j<ndir; ++j) kcenters[i*ndir+j]=fpos[ directions[j] ];
+    kweights[i]=cweight*cvals[0]*cvals[1];
+  }
+  stencilgrid->addSeparableKernels( kcenters, kweights, serialCalculation() );
+}
+
 void MultiColvarDensity::compute( const unsigned& current, MultiValue& myvals ) const {
   std::vector<double> cvals( mycolv->getNumberOfQuantities() ); stash->retrieveSequentialValue( current, false, cvals );
-  Vector fpos, apos = pbcDistance( origin, mycolv->getCentralAtomPos( mycolv->getPositionInFullTaskList(current) ) );
-  if( fractional ) { fpos = getPbc().realToScaled( apos ); } else { fpos=apos; }
+  Vector fpos=getGridPosition( current );
 
   myvals.setValue( 0, cweight*cvals[0] ); for(unsigned j=0; j<directions.size(); ++j) myvals.setValue( 1+j, fpos[ directions[j] ] );
   myvals.setValue( 1+directions.size(), cvals[1] );
@@ -184,12 +184,11 @@ ECVmultiCanonical::ECVmultiCanonical(const ActionOptions&ao)
 
 void ECVmultiCanonical::calculateECVs(const double * ene)
 {
-  for(unsigned k=0; k<beta_.size(); k++)
-  {
-    const double diff_k=(beta_[k]-beta0_);
-    ECVs_[k]=diff_k*ene[0];
-    derECVs_[k]=diff_k;
-  }
+//the derivatives do not depend on the energy, and are set once in initECVs()
+  const unsigned size=ECVs_.size();
+  #pragma omp simd
+  for(unsigned k=0; k<size; k++)
+    ECVs_[k]=derECVs_[k]*ene[0];
 }
 
 const double * ECVmultiCanonical::getPntrToECVs(unsigned j)
@@ -227,6 +226,8 @@ void ECVmultiCanonical::initECVs()
   totNumECVs_=beta_.size();
   ECVs_.resize(beta_.size());
   derECVs_.resize(beta_.size());
+  for(unsigned k=0; k<beta_.size(); k++)
+    derECVs_[k]=(beta_[k]-beta0_);
   isReady_=true;
   log.printf("  *%4lu temperatures for %s\n",beta_.size(),getName().c_str());
 }
@@ -285,24 +285,15 @@ ECVmultiThermalBaric::ECVmultiThermalBaric(const ActionOptions&ao)
 
 void ECVmultiThermalBaric::calculateECVs(const double * ene_vol)
 {
-  unsigned i=0;
-  for(unsigned k=0; k<beta_.size(); k++)
-  {
-    const double diff_k=(beta_[k]-beta0_);
-    ECVs_beta_[k]=diff_k*ene_vol[0];
-    derECVs_beta_[k]=diff_k;
-    const double line_k=coeff_*(1./beta_[k]-low_temp_Kb_)+low_pres_;
-    for(unsigned kk=0; kk<pres_.size(); kk++)
-    {
-      if(coeff_==0 || pres_[kk]>=line_k)
-      {
-        const double diff_i=(beta_[k]*pres_[kk]-beta0_*pres0_); //this is not great, each beta-pres combination must be stored separately
-        ECVs_pres_[i]=diff_i*ene_vol[1];
-        derECVs_pres_[i]=diff_i;
-        i++;
-      }
-    }
-  }
+//the derivatives do not depend on energy and volume, and are set once in initECVs()
+  const unsigned size_beta=ECVs_beta_.size();
+  #pragma omp simd
+  for(unsigned k=0; k<size_beta; k++)
+    ECVs_beta_[k]=derECVs_beta_[k]*ene_vol[0];
+  const unsigned size_pres=ECVs_pres_.size();
+  #pragma omp simd
+  for(unsigned i=0; i<size_pres; i++)
+    ECVs_pres_[i]=derECVs_pres_[i]*ene_vol[1];
 }
 
 const double * ECVmultiThermalBaric::getPntrToECVs(unsigned j)
@@ -377,6 +368,20 @@ void ECVmultiThermalBaric::initECVs()
   derECVs_beta_.resize(beta_.size());
   ECVs_pres_.resize(totNumECVs_); //pres is mixed with temp (beta*p*V), thus we need to store all possible
   derECVs_pres_.resize(totNumECVs_);
+  unsigned i=0;
+  for(unsigned k=0; k<beta_.size(); k++)
+  {
+    derECVs_beta_[k]=(beta_[k]-beta0_);
+    const double line_k=coeff_*(1./beta_[k]-low_temp_Kb_)+low_pres_;
+    for(unsigned kk=0; kk<pres_.size(); kk++)
+    {
+      if(coeff_==0 || pres_[kk]>=line_k)
+      {
+        derECVs_pres_[i]=(beta_[k]*pres_[kk]-beta0_*pres0_); //this is not great, each beta-pres combination must be stored separately
+        i++;
+      }
+    }
+  }
   isReady_=true;
   log.printf("  *%4lu temperatures for %s\n",beta_.size(),getName().c_str());
   log.printf("  *%4lu pressures for %s\n",pres_.size(),getName().c_str());
@@ -120,7 +120,7 @@ private:
   std::vector<const double *> ECVs_;
   std::vector<const double *> derECVs_;
   std::vector<opes::ExpansionCVs*> pntrToECVsClass_;
-  std::vector< std::vector<unsigned> > index_k_;
+  std::vector<unsigned> index_k_; //stored as index_k_[i*ncv_+j]
 // A note on indexes usage:
 //  j -> underlying CVs
 //  i -> DeltaFs
@@ -133,7 +133,10 @@ private:
   unsigned stride_;
   unsigned deltaF_size_; //different from deltaF_.size() if NumParallel_>1
   std::vector<double> deltaF_;
+  std::vector<double> expansion_;
   std::vector<double> diff_;
+  std::vector<double> add_; //exp(diff_-diffMax_), reused by update()
+  double diffMax_;
   double rct_;
   double current_bias_;
 
@@ -163,7 +166,8 @@ private:
   void printDeltaF();
   void dumpStateToFile();
   void updateDeltaF(double);
-  double getExpansion(const unsigned) const;
+  void updateDeltaF_fromCalculate(double);
+  void calculateExpansions();
 
 public:
   explicit OPESexpanded(const ActionOptions&);
@@ -209,6 +213,7 @@ OPESexpanded::OPESexpanded(const ActionOptions&ao)
   , counter_(0)
   , ncv_(getNumberOfArguments())
   , deltaF_size_(0)
+  , diffMax_(0)
   , rct_(0)
   , work_(0)
 {
@@ -525,52 +530,44 @@ void OPESexpanded::calculate()
     return;
 
 //get diffMax, to avoid over/underflow without long double
+  calculateExpansions();
   double diffMax=-std::numeric_limits<double>::max();
   #pragma omp parallel num_threads(NumOMP_)
   {
-    #pragma omp for reduction(max:diffMax)
+    #pragma omp for simd reduction(max:diffMax)
     for(unsigned i=0; i<deltaF_.size(); i++)
     {
-      diff_[i]=(-getExpansion(i)+deltaF_[i]/kbt_);
-      if(diff_[i]>diffMax)
-        diffMax=diff_[i];
+      diff_[i]=(-expansion_[i]+deltaF_[i]/kbt_);
+      diffMax=std::max(diffMax,diff_[i]);
     }
   }
   if(NumParallel_>1)
     comm.Max(diffMax);
+  diffMax_=diffMax;
 
 //calculate the bias and the forces
+//the exponentials are stored in a contiguous array, so that they can be vectorized
   double sum=0;
   std::vector<double> der_sum_cv(ncv_,0);
-  if(NumOMP_==1)
+  #pragma omp parallel num_threads(NumOMP_)
   {
+    #pragma omp for simd reduction(+:sum)
     for(unsigned i=0; i<deltaF_.size(); i++)
     {
-      double add_i=std::exp(diff_[i]-diffMax);
-      sum+=add_i;
-      //set derivatives
-      for(unsigned j=0; j<ncv_; j++)
-        der_sum_cv[j]-=derECVs_[j][index_k_[i][j]]*add_i;
+      add_[i]=std::exp(diff_[i]-diffMax);
+      sum+=add_[i];
     }
-  }
-  else
-  {
-    #pragma omp parallel num_threads(NumOMP_)
+    //set derivatives
+    std::vector<double> omp_der_sum_cv(ncv_,0);
+    #pragma omp for nowait
+    for(unsigned i=0; i<deltaF_.size(); i++)
     {
-      std::vector<double> omp_der_sum_cv(ncv_,0);
-      #pragma omp for reduction(+:sum) nowait
-      for(unsigned i=0; i<deltaF_.size(); i++)
-      {
-        double add_i=std::exp(diff_[i]-diffMax);
-        sum+=add_i;
-        //set derivatives
-        for(unsigned j=0; j<ncv_; j++)
-          omp_der_sum_cv[j]-=derECVs_[j][index_k_[i][j]]*add_i;
-      }
-      #pragma omp critical
       for(unsigned j=0; j<ncv_; j++)
-        der_sum_cv[j]+=omp_der_sum_cv[j];
+        omp_der_sum_cv[j]-=derECVs_[j][index_k_[i*ncv_+j]]*add_[i];
     }
+    #pragma omp critical
+    for(unsigned j=0; j<ncv_; j++)
+      der_sum_cv[j]+=omp_der_sum_cv[j];
   }
   if(NumParallel_>1)
   { //each MPI process has part of the full deltaF_ vector, so must Sum
@@ -641,7 +638,7 @@ void OPESexpanded::update()
     plumed_massert(afterCalculate_,"OPESexpanded::update() must be called after OPESexpanded::calculate() to work properly");
     afterCalculate_=false;
     if(NumWalkers_==1)
-      updateDeltaF(current_bias_);
+      updateDeltaF_fromCalculate(current_bias_);
     else
     {
       std::vector<double> cvs(ncv_);
@@ -665,6 +662,7 @@ void OPESexpanded::update()
           pntrToECVsClass_[k]->calculateECVs(&all_cvs[index_wj]);
           index_wj+=pntrToECVsClass_[k]->getNumberOfArguments();
         }
+        calculateExpansions();
         updateDeltaF(all_bias[w]);
       }
     }
@@ -733,10 +731,12 @@ void OPESexpanded::init_linkECVs()
       disp_[r+1]=disp_[r]+all_size_[r];
     }
   }
+  expansion_.resize(deltaF_.size());
   diff_.resize(deltaF_.size());
+  add_.resize(deltaF_.size());
   ECVs_.resize(ncv_);
   derECVs_.resize(ncv_);
-  index_k_.resize(deltaF_.size(),std::vector<unsigned>(ncv_));
+  index_k_.resize(deltaF_.size()*ncv_);
   unsigned index_j=0;
   unsigned sizeSkip=deltaF_size_;
   for(unsigned l=0; l<pntrToECVsClass_.size(); l++)
@@ -752,14 +752,14 @@ void OPESexpanded::init_linkECVs()
       if(NumParallel_==1)
       {
         for(unsigned i=0; i<deltaF_size_; i++)
-          index_k_[i][index_j+h]=l_index_k[(i/sizeSkip)%l_index_k.size()][h];
+          index_k_[i*ncv_+index_j+h]=l_index_k[(i/sizeSkip)%l_index_k.size()][h];
       }
       else
       {
         const unsigned start=(deltaF_size_/NumParallel_)*rank_+std::min(rank_,deltaF_size_%NumParallel_);
         unsigned iter=0;
         for(unsigned i=start; i<start+deltaF_.size(); i++)
-          index_k_[iter++][index_j+h]=l_index_k[(i/sizeSkip)%l_index_k.size()][h];
+          index_k_[(iter++)*ncv_+index_j+h]=l_index_k[(i/sizeSkip)%l_index_k.size()][h];
       }
     }
     index_j+=pntrToECVsClass_[l]->getNumberOfArguments();
@@ -798,7 +798,7 @@ void OPESexpanded::init_fromObs() //This could probably be faster and/or require
   index_j=0;
   for(unsigned i=0; i<deltaF_.size(); i++)
     for(unsigned j=0; j<ncv_; j++)
-      deltaF_[i]+=kbt_*ECVs_[j][index_k_[i][j]];
+      deltaF_[i]+=kbt_*ECVs_[j][index_k_[i*ncv_+j]];
   for(unsigned t=1; t<obs_steps_; t++) //starts from t=1
   {
     unsigned index_j=0;
@@ -807,9 +807,10 @@ void OPESexpanded::init_fromObs() //This could probably be faster and/or require
       pntrToECVsClass_[l]->calculateECVs(&obs_cvs_[t*ncv_+index_j]);
       index_j+=pntrToECVsClass_[l]->getNumberOfArguments();
     }
+    calculateExpansions();
     for(unsigned i=0; i<deltaF_.size(); i++)
     {
-      const double diff_i=(-getExpansion(i)+deltaF_[i]/kbt_);
+      const double diff_i=(-expansion_[i]+deltaF_[i]/kbt_);
       deltaF_[i]-=kbt_*(std::log1p(std::exp(diff_i)/t)+std::log1p(-1./(1.+t)));
     }
   }
@@ -900,19 +901,41 @@ void OPESexpanded::updateDeltaF(double bias)
     #pragma omp for
     for(unsigned i=0; i<deltaF_.size(); i++)
     {
-      const double diff_i=(-getExpansion(i)+(bias-rct_+deltaF_[i])/kbt_);
+      const double diff_i=(-expansion_[i]+(bias-rct_+deltaF_[i])/kbt_);
       deltaF_[i]+=increment-kbt_*std::log1p(std::exp(diff_i)/(counter_-1.));
     }
   }
   rct_+=increment+kbt_*std::log1p(-1./counter_);
 }
 
-double OPESexpanded::getExpansion(unsigned i) const
+void OPESexpanded::updateDeltaF_fromCalculate(double bias)
 {
-  double expansion=0;
-  for(unsigned j=0; j<ncv_; j++)
-    expansion+=ECVs_[j][index_k_[i][j]]; //the index_k could be trivially guessed for most ECVs, but unfourtunately not all
-  return expansion;
+//same as updateDeltaF(), but the exponentials of the diff_i are obtained from the ones of calculate(),
+//which used the same ECVs and deltaF_. Only the constant shift exp(diff_i-diff_[i]) is missing
+  plumed_dbg_massert(counter_>0,"deltaF_ must be initialized");
+  counter_++;
+  const double increment=kbt_*std::log1p(std::exp((bias-rct_)/kbt_)/(counter_-1.));
+  const double shift=std::exp(diffMax_+(bias-rct_)/kbt_)/(counter_-1.);
+  #pragma omp parallel num_threads(NumOMP_)
+  {
+    #pragma omp for simd
+    for(unsigned i=0; i<deltaF_.size(); i++)
+      deltaF_[i]+=increment-kbt_*std::log1p(add_[i]*shift);
+  }
+  rct_+=increment+kbt_*std::log1p(-1./counter_);
+}
+
+void OPESexpanded::calculateExpansions()
+{
+//the index_k could be trivially guessed for most ECVs, but unfourtunately not all
+  #pragma omp parallel for num_threads(NumOMP_)
+  for(unsigned i=0; i<deltaF_.size(); i++)
+  {
+    double expansion=0;
+    for(unsigned j=0; j<ncv_; j++)
+      expansion+=ECVs_[j][index_k_[i*ncv_+j]];
+    expansion_[i]=expansion;
+  }
 }
 
 }
@@ -21,6 +21,7 @@ along with plumed.  If not, see <http://www.gnu.org/licenses/>.
 #include "tools/Communicator.h"
 #include "tools/File.h"
 #include "tools/OpenMP.h"
+#include "tools/Checkpoint.h"
 
 namespace PLMD {
 namespace opes {
@@ -69,6 +70,7 @@ Restart can be done from a KERNELS file, but it might not be perfect (due to lim
 For an exact restart you must use STATE_RFILE to read a checkpoint with all the needed info.
 To save such checkpoints, define a STATE_WFILE and choose how often to print them with STATE_WSTRIDE.
 By default this file is overwritten, but you can instead append to it using the flag STORE_STATES.
+The same state can also be stored in a binary checkpoint (see \ref CHECKPOINT), which is used instead of the restart file if available.
 
 Multiple walkers are supported only with MPI communication, via the keyword WALKERS_MPI.
 
@@ -115,8 +117,10 @@ class OPESmetad : public bias::Bias {
 
 private:
   bool isFirstStep_;
+  bool checkpointRestart_;
   bool afterCalculate_;
   unsigned NumOMP_;
+  OpenMPTuner tuner_;
   unsigned NumParallel_;
   unsigned rank_;
   unsigned NumWalkers_;
@@ -178,6 +182,7 @@ private:
   double old_KDEnorm_;
   double old_Zed_;
   std::vector<kernel> delta_kernels_;
+  double old_work_; //last value of the work component, stored in the binary checkpoint
 
   OFile stateOfile_;
   int wStateStride_;
@@ -189,11 +194,14 @@ private:
   unsigned getMergeableKernel(const std::vector<double>&,const unsigned);
   void updateNlist(const std::vector<double>&);
   void dumpStateToFile();
+  void restoreCheckpoint(Checkpoint&);
 
 public:
   explicit OPESmetad(const ActionOptions&);
   void calculate() override;
   void update() override;
+  void getMemoryUsage(std::vector<std::pair<std::string,std::size_t> >&) const override;
+  void saveCheckpoint(Checkpoint&) override;
   static void registerKeywords(Keywords& keys);
 };
 
@@ -297,11 +305,13 @@ template <class mode>
 OPESmetad<mode>::OPESmetad(const ActionOptions& ao)
   : PLUMED_BIAS_INIT(ao)
   , isFirstStep_(true)
+  , checkpointRestart_(false)
   , afterCalculate_(false)
   , counter_(1)
   , ncv_(getNumberOfArguments())
   , Zed_(1)
   , work_(0)
+  , old_work_(0)
 {
   std::string error_in_input1("Error in input in action "+getName()+" with label "+getLabel()+": the keyword ");
   std::string error_in_input2(" could not be read correctly");
@@ -503,6 +513,7 @@ OPESmetad<mode>::OPESmetad(const ActionOptions& ao)
     NumParallel_=1;
     rank_=0;
   }
+  tuner_.link(log,getLabel());
 
   checkRead();
 
@@ -518,7 +529,15 @@ OPESmetad<mode>::OPESmetad(const ActionOptions& ao)
     }
     IFile ifile;
     ifile.link(*this);
-    if(ifile.FileExist(restartFileName))
+    Checkpoint* cpt=plumed.getRestartCheckpoint(getLabel());
+    if(cpt)
+    {
+      restoreCheckpoint(*cpt);
+      checkpointRestart_=true;
+      log.printf("  RESTART - make sure all used options are compatible\n");
+      log.printf("    restarting from the binary checkpoint, a total of %lu kernels where read\n",kernels_.size());
+    }
+    else if(ifile.FileExist(restartFileName))
     {
       bool tmp_nlist=nlist_;
       nlist_=false; // NLIST is not needed while restarting
@@ -747,8 +766,11 @@ OPESmetad<mode>::OPESmetad(const ActionOptions& ao)
 
 //set initial old values
   KDEnorm_=mode::explore?counter_:sum_weights_;
-  old_KDEnorm_=KDEnorm_;
-  old_Zed_=Zed_;
+  if(!checkpointRestart_)
+  {
+    old_KDEnorm_=KDEnorm_;
+    old_Zed_=Zed_;
+  }
 
 //add and set output components
   addComponent("rct");
@@ -767,6 +789,8 @@ OPESmetad<mode>::OPESmetad(const ActionOptions& ao)
   {
     addComponent("work");
     componentIsNotPeriodic("work");
+    if(checkpointRestart_)
+      getPntrToComponent("work")->set(old_work_);
   }
   if(nlist_)
   {
@@ -891,8 +915,8 @@ void OPESmetad<mode>::calculate()
   for(unsigned i=0; i<ncv_; i++)
     setOutputForce(i,-kbt_*bias_prefactor_/(prob/Zed_+epsilon_)*der_prob[i]/Zed_);
 
-//calculate work
-  if(calc_work_)
+//calculate work, but not on the step of the binary checkpoint, which was already accounted for
+  if(calc_work_ && !(isFirstStep_ && checkpointRestart_))
   {
     double tot_delta=0;
     for(unsigned d=0; d<delta_kernels_.size(); d++)
@@ -1192,7 +1216,9 @@ double OPESmetad<mode>::getProbAndDerivatives(const std::vector<double>& cv,std:
   double prob=0.0;
   if(!nlist_)
   {
-    if(NumOMP_==1 || (unsigned)kernels_.size()<2*NumOMP_*NumParallel_)
+    // with SERIAL the number of threads is not tuned
+    const unsigned nt=(NumOMP_==1 ? 1 : tuner_.begin(kernels_.size()/NumParallel_,((unsigned)kernels_.size()<2*NumOMP_*NumParallel_) ? 1 : NumOMP_));
+    if(nt==1)
     {
       // for performances and thread safety
       std::vector<double> dist(ncv_);
@@ -1201,7 +1227,7 @@ double OPESmetad<mode>::getProbAndDerivatives(const std::vector<double>& cv,std:
     }
     else
     {
-      #pragma omp parallel num_threads(NumOMP_)
+      #pragma omp parallel num_threads(nt)
       {
         std::vector<double> omp_deriv(der_prob.size(),0.);
         // for performances and thread safety
@@ -1214,10 +1240,12 @@ double OPESmetad<mode>::getProbAndDerivatives(const std::vector<double>& cv,std:
           der_prob[i]+=omp_deriv[i];
       }
     }
+    tuner_.end();
   }
   else
   {
-    if(NumOMP_==1 || (unsigned)nlist_index_.size()<2*NumOMP_*NumParallel_)
+    const unsigned nt=(NumOMP_==1 ? 1 : tuner_.begin(nlist_index_.size()/NumParallel_,((unsigned)nlist_index_.size()<2*NumOMP_*NumParallel_) ? 1 : NumOMP_));
+    if(nt==1)
     {
       // for performances and thread safety
       std::vector<double> dist(ncv_);
@@ -1226,7 +1254,7 @@ double OPESmetad<mode>::getProbAndDerivatives(const std::vector<double>& cv,std:
     }
     else
     {
-      #pragma omp parallel num_threads(NumOMP_)
+      #pragma omp parallel num_threads(nt)
       {
         std::vector<double> omp_deriv(der_prob.size(),0.);
         // for performances and thread safety
@@ -1239,6 +1267,7 @@ double OPESmetad<mode>::getProbAndDerivatives(const std::vector<double>& cv,std:
           der_prob[i]+=omp_deriv[i];
       }
     }
+    tuner_.end();
   }
   if(NumParallel_>1)
   {
@@ -1414,6 +1443,22 @@ unsigned OPESmetad<mode>::getMergeableKernel(const std::vector<double>& giver_ce
   return min_k;
 }
 
+template <class mode>
+void OPESmetad<mode>::getMemoryUsage(std::vector<std::pair<std::string,std::size_t> >& usage) const
+{
+  auto kernelsMemory=[](const std::vector<kernel>& kernels)
+  {
+    std::size_t mem=kernels.capacity()*sizeof(kernel);
+    for(const auto& k : kernels)
+      mem+=(k.center.capacity()+k.sigma.capacity())*sizeof(double);
+    return mem;
+  };
+  usage.push_back(std::make_pair("compressed kernels",kernelsMemory(kernels_)));
+  usage.push_back(std::make_pair("delta kernels",kernelsMemory(delta_kernels_)));
+  if(nlist_)
+    usage.push_back(std::make_pair("neighbor list",nlist_index_.capacity()*sizeof(unsigned)+(nlist_center_.capacity()+nlist_dev2_.capacity())*sizeof(double)));
+}
+
 template <class mode>
 void OPESmetad<mode>::updateNlist(const std::vector<double>& new_center)
 {
@@ -1505,6 +1550,94 @@ void OPESmetad<mode>::updateNlist(const std::vector<double>& new_center)
   nlist_update_=false;
 }
 
+template <class mode>
+void OPESmetad<mode>::saveCheckpoint(Checkpoint& cpt)
+{
+  auto putKernels=[&](const std::vector<kernel>& kernels)
+  {
+    std::vector<double> height(kernels.size());
+    std::vector<double> center;
+    std::vector<double> sigma;
+    center.reserve(kernels.size()*ncv_);
+    sigma.reserve(kernels.size()*ncv_);
+    for(unsigned k=0; k<kernels.size(); k++)
+    {
+      height[k]=kernels[k].height;
+      center.insert(center.end(),kernels[k].center.begin(),kernels[k].center.end());
+      sigma.insert(sigma.end(),kernels[k].sigma.begin(),kernels[k].sigma.end());
+    }
+    cpt.put(height);
+    cpt.put(center);
+    cpt.put(sigma);
+  };
+  cpt.beginSection(getLabel());
+  cpt.put(getName());
+  cpt.put(ncv_);
+  cpt.put(Zed_);
+  cpt.put(sum_weights_);
+  cpt.put(sum_weights2_);
+  cpt.put(counter_);
+  cpt.put(adaptive_counter_);
+  cpt.put(sigma0_);
+  cpt.put(sigma_min_);
+  cpt.put(av_cv_);
+  cpt.put(av_M2_);
+//what is needed to continue the work estimate
+  cpt.put(old_Zed_);
+  cpt.put(old_KDEnorm_);
+  cpt.put(work_);
+  cpt.put(calc_work_?getPntrToComponent("work")->get():0.);
+  putKernels(kernels_);
+  putKernels(delta_kernels_);
+  cpt.endSection();
+}
+
+template <class mode>
+void OPESmetad<mode>::restoreCheckpoint(Checkpoint& cpt)
+{
+  auto getKernels=[&](std::vector<kernel>& kernels)
+  {
+    std::vector<double> height;
+    std::vector<double> center;
+    std::vector<double> sigma;
+    cpt.get(height);
+    cpt.get(center);
+    cpt.get(sigma);
+    plumed_massert(center.size()==height.size()*ncv_ && sigma.size()==height.size()*ncv_,"RESTART - corrupted kernels in the binary checkpoint");
+    kernels.clear();
+    kernels.reserve(height.size());
+    for(unsigned k=0; k<height.size(); k++)
+    {
+      std::vector<double> center_k(center.begin()+k*ncv_,center.begin()+(k+1)*ncv_);
+      std::vector<double> sigma_k(sigma.begin()+k*ncv_,sigma.begin()+(k+1)*ncv_);
+      kernels.emplace_back(height[k],center_k,sigma_k);
+    }
+  };
+  std::string old_action_name;
+  std::size_t old_ncv;
+  cpt.openSection(getLabel());
+  cpt.get(old_action_name);
+  plumed_massert(old_action_name==getName(),"RESTART - mismatch between old and new action name. Expected '"+getName()+"', but found '"+old_action_name+"'");
+  cpt.get(old_ncv);
+  plumed_massert(old_ncv==ncv_,"RESTART - number of arguments in the binary checkpoint does not match input");
+  cpt.get(Zed_);
+  cpt.get(sum_weights_);
+  cpt.get(sum_weights2_);
+  cpt.get(counter_);
+  cpt.get(adaptive_counter_);
+  cpt.get(sigma0_);
+  cpt.get(sigma_min_);
+  cpt.get(av_cv_);
+  cpt.get(av_M2_);
+  cpt.get(old_Zed_);
+  cpt.get(old_KDEnorm_);
+  cpt.get(work_);
+  cpt.get(old_work_);
+  getKernels(kernels_);
+  getKernels(delta_kernels_);
+  cpt.closeSection();
+}
+
 template <class mode>
 void OPESmetad<mode>::dumpStateToFile()
 {
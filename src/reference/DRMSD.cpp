@@ -22,6 +22,9 @@
 #include "DRMSD.h"
 #include "MetricRegister.h"
 #include "tools/Pbc.h"
+#include "tools/OpenMP.h"
+#include <algorithm>
+#include <numeric>
 
 namespace PLMD {
 
@@ -59,46 +62,120 @@ void DRMSD::setReferenceAtoms( const std::vector<Vector>& conf, const std::vecto
   setup_targets();
 }
 
+void DRMSD::clearTargets() {
+  pair_i.clear(); pair_j.clear(); pair_target.clear(); pair_atoms.clear();
+}
+
+void DRMSD::addTarget( const unsigned& i, const unsigned& j, const double& distance ) {
+  pair_i.push_back(i); pair_j.push_back(j); pair_target.push_back(distance);
+}
+
+void DRMSD::sortTargets() {
+  std::vector<unsigned> order(pair_target.size());
+  std::iota(order.begin(),order.end(),0);
+  std::sort(order.begin(),order.end(),[this](unsigned a,unsigned b) {
+    if(pair_i[a]!=pair_i[b]) return pair_i[a]<pair_i[b];
+    return pair_j[a]<pair_j[b];
+  });
+  std::vector<unsigned> si(order.size()), sj(order.size());
+  std::vector<double> st(order.size());
+  for(unsigned k=0; k<order.size(); ++k) {
+    si[k]=pair_i[order[k]]; sj[k]=pair_j[order[k]]; st[k]=pair_target[order[k]];
+  }
+  pair_i.swap(si); pair_j.swap(sj); pair_target.swap(st);
+
+  std::vector<bool> used(getNumberOfReferencePositions(),false);
+  for(unsigned k=0; k<pair_i.size(); ++k) used[pair_i[k]]=used[pair_j[k]]=true;
+  pair_atoms.clear();
+  for(unsigned k=0; k<used.size(); ++k) if(used[k]) pair_atoms.push_back(k);
+}
+
 void DRMSD::setup_targets() {
   plumed_massert( bounds_were_set, "I am missing a call to DRMSD::setBoundsOnDistances");
 
+  clearTargets();
   unsigned natoms = getNumberOfReferencePositions();
   for(unsigned i=0; i<natoms-1; ++i) {
     for(unsigned j=i+1; j<natoms; ++j) {
       double distance = delta( getReferencePosition(i), getReferencePosition(j) ).modulo();
-      if(distance < upper && distance > lower ) {
-        targets[std::make_pair(i,j)] = distance;
-      }
+      if(distance < upper && distance > lower ) addTarget(i,j,distance);
     }
   }
-  if( targets.empty() ) error("drmsd will compare no distances - check upper and lower bounds are sensible");
+  sortTargets();
+  if( pair_target.empty() ) error("drmsd will compare no distances - check upper and lower bounds are sensible");
 }
 
 double DRMSD::calc( const std::vector<Vector>& pos, const Pbc& pbc, ReferenceValuePack& myder, const bool& squared ) const {
-  plumed_dbg_assert(!targets.empty());
+  plumed_dbg_assert(!pair_target.empty());
 
-  Vector distance;
+  const unsigned npairs=pair_target.size();
   myder.clear();
   double drmsd=0.;
-  for(const auto & it : targets) {
-
-    const unsigned i=getAtomIndex( it.first.first );
-    const unsigned j=getAtomIndex( it.first.second );
-
-    if(nopbc) distance=delta( pos[i], pos[j] );
-    else      distance=pbc.distance( pos[i], pos[j] );
-
-    const double len = distance.modulo();
-    const double diff = len - it.second;
-    const double der = diff / len;
-
-    drmsd += diff * diff;
-    myder.addAtomDerivatives( i, -der * distance );
-    myder.addAtomDerivatives( j,  der * distance );
-    myder.addBoxDerivatives( - der * Tensor(distance,distance) );
+  unsigned nt=OpenMP::getNumThreads();
+  if(npairs<1000) nt=1;
+  if(nt==1) {
+    for(unsigned k=0; k<npairs; ++k) {
+      const unsigned i=getAtomIndex( pair_i[k] );
+      const unsigned j=getAtomIndex( pair_j[k] );
+
+      Vector distance;
+      if(nopbc) distance=delta( pos[i], pos[j] );
+      else      distance=pbc.distance( pos[i], pos[j] );
+
+      const double len = distance.modulo();
+      const double diff = len - pair_target[k];
+      const double der = diff / len;
+
+      drmsd += diff * diff;
+      myder.addAtomDerivatives( i, -der * distance );
+      myder.addAtomDerivatives( j,  der * distance );
+      myder.addBoxDerivatives( - der * Tensor(distance,distance) );
+    }
+  } else {
+// each thread accumulates forces on its own copy, these are summed at the end
+    std::vector<Vector> deriv(pos.size());
+    Tensor virial;
+    #pragma omp parallel num_threads(nt)
+    {
+      std::vector<Vector> omp_deriv(pos.size());
+      Tensor omp_virial;
+      double omp_drmsd=0.;
+      #pragma omp for nowait
+      for(unsigned k=0; k<npairs; ++k) {
+        const unsigned i=getAtomIndex( pair_i[k] );
+        const unsigned j=getAtomIndex( pair_j[k] );
+
+        Vector distance;
+        if(nopbc) distance=delta( pos[i], pos[j] );
+        else      distance=pbc.distance( pos[i], pos[j] );
+
+        const double len = distance.modulo();
+        const double diff = len - pair_target[k];
+        const double der = diff / len;
+
+        omp_drmsd += diff * diff;
+        omp_deriv[i] -= der * distance;
+        omp_deriv[j] += der * distance;
+        omp_virial -= der * Tensor(distance,distance);
+      }
+      #pragma omp critical
+      {
+        drmsd += omp_drmsd;
+        for(unsigned k=0; k<pair_atoms.size(); ++k) {
+          const unsigned i=getAtomIndex( pair_atoms[k] );
+          deriv[i] += omp_deriv[i];
+        }
+        virial += omp_virial;
+      }
+    }
+    for(unsigned k=0; k<pair_atoms.size(); ++k) {
+      const unsigned i=getAtomIndex( pair_atoms[k] );
+      myder.addAtomDerivatives( i, deriv[i] );
+    }
+    myder.addBoxDerivatives( virial );
   }
 
-  const double inpairs = 1./static_cast<double>(targets.size());
+  const double inpairs = 1./static_cast<double>(npairs);
   double idrmsd;
 
   if(squared) {
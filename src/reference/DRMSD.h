@@ -24,7 +24,6 @@
 
 #include <vector>
 #include <string>
-#include <map>
 #include "SingleDomainRMSD.h"
 
 namespace PLMD {
@@ -35,9 +34,20 @@ private:
 protected:
   bool bounds_were_set;
   double lower, upper;
-  std::map< std::pair <unsigned,unsigned>, double> targets;
+/// The pairs of atoms whose distances are compared and the reference distances.
+/// These are stored in contiguous arrays sorted by atom indices
+  std::vector<unsigned> pair_i, pair_j;
+  std::vector<double> pair_target;
+/// The atoms that appear in at least one pair
+  std::vector<unsigned> pair_atoms;
 /// Read in NOPBC, LOWER_CUTOFF and UPPER_CUTOFF
   void readBounds( const PDB& );
+/// Remove all the pairs
+  void clearTargets();
+/// Add a pair of atoms with its reference distance
+  void addTarget( const unsigned& i, const unsigned& j, const double& distance );
+/// Sort the pairs once they have all been added
+  void sortTargets();
 public:
   explicit DRMSD( const ReferenceConfigurationOptions& ro );
 /// This sets upper and lower bounds on distances to be used in DRMSD
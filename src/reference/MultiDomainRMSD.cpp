@@ -83,6 +83,14 @@ void MultiDomainRMSD::read( const PDB& pdb ) {
   // setAtomNumbers( pdb.getAtomNumbers() );
 }
 
+void MultiDomainRMSD::setRotationCache( const double& epsilon ) {
+  for(unsigned i=0; i<domains.size(); ++i) domains[i]->setRotationCache( epsilon );
+}
+
+void MultiDomainRMSD::setRotationCacheReuse( const bool& reuse ) {
+  for(unsigned i=0; i<domains.size(); ++i) domains[i]->setRotationCacheReuse( reuse );
+}
+
 void MultiDomainRMSD::setReferenceAtoms( const std::vector<Vector>& conf, const std::vector<double>& align_in, const std::vector<double>& displace_in ) {
   plumed_error();
 }
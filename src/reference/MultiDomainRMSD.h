@@ -52,6 +52,10 @@ public:
   void extractAtomicDisplacement( const std::vector<Vector>& pos, std::vector<Vector>& direction ) const override;
   double projectAtomicDisplacementOnVector( const bool& normalized, const std::vector<Vector>& vecs, ReferenceValuePack& mypack ) const override;
   void setupPCAStorage( ReferenceValuePack& mypack ) override;
+/// Enable the rotation cache in all the domains
+  void setRotationCache( const double& epsilon );
+/// Allow all the domains to reuse their cached rotation
+  void setRotationCacheReuse( const bool& reuse );
 };
 
 }
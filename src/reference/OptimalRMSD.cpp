@@ -36,6 +36,8 @@ public:
   double calc( const std::vector<Vector>& pos, ReferenceValuePack& myder, const bool& squared ) const override;
   bool pcaIsEnabledForThisReference() override { return true; }
   void setupRMSDObject() override { myrmsd.clear(); myrmsd.set(getAlign(),getDisplace(),getReferencePositions(),"OPTIMAL"); }
+  void setRotationCache( const double& epsilon ) override { myrmsd.setRotationCache(epsilon); }
+  void setRotationCacheReuse( const bool& reuse ) override { myrmsd.setRotationCacheReuse(reuse); }
   void setupPCAStorage( ReferenceValuePack& mypack ) override {
     mypack.switchOnPCAOption();
     mypack.centeredpos.resize( getNumberOfAtoms() );
@@ -44,6 +44,10 @@ public:
   virtual void setBoundsOnDistances( bool dopbc, double lbound=0.0, double ubound=std::numeric_limits<double>::max( ) ) {};
 /// This is used by MultiDomainRMSD to setup the RMSD object in Optimal RMSD type
   virtual void setupRMSDObject() {};
+/// This enables the rotation cache of the RMSD object in Optimal RMSD type (here it does nothing)
+  virtual void setRotationCache( const double& epsilon ) {};
+/// This allows the cached rotation to be reused when only the distance is needed (here it does nothing)
+  virtual void setRotationCacheReuse( const bool& reuse ) {};
 };
 
 }
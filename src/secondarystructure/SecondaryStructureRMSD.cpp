@@ -25,8 +25,10 @@
 #include "core/GenericMolInfo.h"
 #include "core/Atoms.h"
 #include "vesselbase/Vessel.h"
+#include "vesselbase/LessThan.h"
 #include "reference/MetricRegister.h"
 #include "reference/SingleDomainRMSD.h"
+#include <limits>
 
 namespace PLMD {
 namespace secondarystructure {
@@ -50,6 +52,11 @@ void SecondaryStructureRMSD::registerKeywords( Keywords& keys ) {
   keys.add("compulsory","D_0","0.0","The d_0 parameter of the switching function");
   keys.add("compulsory","NN","8","The n parameter of the switching function");
   keys.add("compulsory","MM","12","The m parameter of the switching function");
+  keys.add("optional","D_MAX","The d_max parameter of the switching function. When this is set the segments that are "
+           "certainly further than D_MAX from all the reference structures are not computed");
+  keys.add("compulsory","SCREEN_SKIN","0.1","When the quantities computed vanish beyond a cutoff (i.e. LESS_THAN with D_MAX) the segments "
+           "that are too far from the reference structures are skipped. The list of segments is rebuilt whenever one of the atoms "
+           "moves by more than half this distance");
   keys.reserve("optional","STRANDS_CUTOFF","If in a segment of protein the two strands are further apart then the calculation "
                "of the actual RMSD is skipped as the structure is very far from being beta-sheet like. "
                "This keyword speeds up the calculation enormously when you are using the LESS_THAN option. "
@@ -79,13 +86,18 @@ SecondaryStructureRMSD::SecondaryStructureRMSD(const ActionOptions&ao):
   align_strands(false),
   s_cutoff2(0),
   align_atom_1(0),
-  align_atom_2(0)
+  align_atom_2(0),
+  do_screen(false),
+  screen_cutoff(0),
+  screen_skin(0),
+  screen_natoms(0)
 {
   parse("TYPE",alignType); parseFlag("NOPBC",nopbc);
   log.printf("  distances from secondary structure elements are calculated using %s algorithm\n",alignType.c_str() );
   log<<"  Bibliography "<<plumed.cite("Pietrucci and Laio, J. Chem. Theory Comput. 5, 2197 (2009)"); log<<"\n";
 
   parseFlag("VERBOSE",verbose_output);
+  parse("SCREEN_SKIN",screen_skin);
 
   if( keywords.exists("STRANDS_CUTOFF") ) {
     double s_cutoff = 0;
@@ -165,6 +177,8 @@ void SecondaryStructureRMSD::setSecondaryStructure( std::vector<Vector>& structu
       int nn; parse("NN",nn); int mm; parse("MM",mm);
       std::ostringstream ostr;
       ostr<<"RATIONAL R_0="<<r0<<" D_0="<<d0<<" NN="<<nn<<" MM="<<mm;
+      double dmax=-1; parse("D_MAX",dmax);
+      if( dmax>0 ) ostr<<" D_MAX="<<dmax;
       std::string input=ostr.str(); addVessel( "LESS_THAN", input, -1 ); // -1 here means that this value will be named getLabel()
       readVesselKeywords();  // This makes sure resizing is done
     }
@@ -177,6 +191,7 @@ void SecondaryStructureRMSD::setSecondaryStructure( std::vector<Vector>& structu
   references[nn]->setBoundsOnDistances( true, bondlength );   // We always use pbc
   references[nn]->setReferenceAtoms( structure, align, displace );
 //  references[nn]->setNumberOfAtoms( structure.size() );
+  setupScreen( structure, bondlength );
 
   // And prepare the task list
   deactivateAllTasks();
@@ -184,7 +199,97 @@ void SecondaryStructureRMSD::setSecondaryStructure( std::vector<Vector>& structu
   lockContributors();
 }
 
+void SecondaryStructureRMSD::setupScreen( const std::vector<Vector>& structure, double bondlength ) {
+  const unsigned n=structure.size();
+  if( references.size()==1 ) {
+    // Screening is exact only if all the quantities are sums of switching functions that are zero beyond a cutoff
+    do_screen=(getNumberOfVessels()>0);
+    for(unsigned i=0; i<getNumberOfVessels(); ++i) {
+      vesselbase::LessThan* lt=dynamic_cast<vesselbase::LessThan*>( getPntrToVessel(i) );
+      if( !lt ) { do_screen=false; break; }
+      if( lt->getCutoff()>screen_cutoff ) screen_cutoff=lt->getCutoff();
+    }
+    if( screen_cutoff>=std::numeric_limits<double>::max() ) do_screen=false;
+    // The lower bounds are computed from the distances between the CA atoms (N CA CB C O for each residue)
+    std::vector<unsigned> ca;
+    if( n%5==0 ) for(unsigned i=1; i<n; i+=5) ca.push_back(i);
+    else { ca.push_back(0); ca.push_back(n/2); ca.push_back(n-1); }
+    for(unsigned i=0; i<ca.size(); ++i) {
+      for(unsigned j=i+1; j<ca.size(); ++j) screen_pairs.push_back( std::pair<unsigned,unsigned>( ca[i], ca[j] ) );
+    }
+    screen_natoms=ca.size();
+  }
+
+  // If the distances between m atoms differ by delta_ij from the reference then
+  // sum_ij delta_ij^2 <= 2(m-1) N RMSD^2, while for DRMSD sum_ij delta_ij^2 <= npairs DRMSD^2
+  // as long as the distances are among the npairs that are compared
+  std::vector<double> refdist( screen_pairs.size() );
+  for(unsigned i=0; i<screen_pairs.size(); ++i) refdist[i]=delta( structure[screen_pairs[i].first], structure[screen_pairs[i].second] ).modulo();
+  double norm=0;
+  if( alignType=="DRMSD" ) {
+    unsigned npairs=0;
+    for(unsigned i=0; i<n-1; ++i) {
+      for(unsigned j=i+1; j<n; ++j) {
+        if( delta( structure[i], structure[j] ).modulo()>bondlength ) npairs++;
+      }
+    }
+    for(unsigned i=0; i<screen_pairs.size(); ++i) {
+      if( refdist[i]<=bondlength ) refdist[i]=-1;
+    }
+    norm=std::sqrt( static_cast<double>(npairs) );
+  } else if( alignType=="SIMPLE" || alignType.find("OPTIMAL")==0 ) {
+    norm=std::sqrt( 2.0*(screen_natoms-1)*n );
+  } else do_screen=false;
+  screen_refdist.push_back( refdist );
+  screen_norm.push_back( norm );
+
+  if( do_screen && references.size()==1 ) {
+    log.printf("  skipping segments whose RMSD from the reference structures is certainly larger than %f\n",screen_cutoff);
+    log.printf("  list of segments is updated whenever an atom moves by more than %f\n",0.5*screen_skin);
+  }
+}
+
+void SecondaryStructureRMSD::screenSegments() {
+  // Nothing to do unless an atom moved by more than half the skin since the last update
+  if( screen_lastpos.size()==getNumberOfAtoms() ) {
+    const double maxdisp2=0.25*screen_skin*screen_skin;
+    bool moved=false;
+    for(unsigned i=0; i<getNumberOfAtoms(); ++i) {
+      Vector disp;
+      if( nopbc ) disp=delta( screen_lastpos[i], getPosition(i) );
+      else disp=pbcDistance( screen_lastpos[i], getPosition(i) );
+      if( disp.modulo2()>maxdisp2 ) { moved=true; break; }
+    }
+    if( !moved ) return;
+  }
+  screen_lastpos=getPositions();
+
+  // Before the next update each distance changes by less than the skin, so a segment whose lower bound is
+  // larger than the cutoff (plus the skin) for all the references gives zero until the next update
+  deactivateAllTasks();
+  std::vector<double> dist( screen_pairs.size() );
+  for(unsigned i=0; i<colvar_atoms.size(); ++i) {
+    for(unsigned j=0; j<screen_pairs.size(); ++j) {
+      const Vector & p1( getPosition( getAtomIndex(i,screen_pairs[j].first) ) );
+      const Vector & p2( getPosition( getAtomIndex(i,screen_pairs[j].second) ) );
+      if( nopbc ) dist[j]=delta( p1, p2 ).modulo();
+      else dist[j]=pbcDistance( p1, p2 ).modulo();
+    }
+    for(unsigned k=0; k<screen_norm.size(); ++k) {
+      double dev2=0; unsigned np=0;
+      for(unsigned j=0; j<screen_pairs.size(); ++j) {
+        if( screen_refdist[k][j]<0 ) continue;
+        const double dev=dist[j]-screen_refdist[k][j];
+        dev2+=dev*dev; np++;
+      }
+      if( std::sqrt(dev2) - screen_cutoff*screen_norm[k] <= std::sqrt(static_cast<double>(np))*screen_skin ) { taskFlags[i]=1; break; }
+    }
+  }
+  lockContributors();
+}
+
 void SecondaryStructureRMSD::calculate() {
+  if( do_screen ) screenSegments();
   runAllTasks();
 }
 
@@ -56,10 +56,22 @@ private:
   double s_cutoff2;
   unsigned align_atom_1, align_atom_2;
   bool verbose_output;
+/// Variables for skipping the segments that are too far from all the reference structures
+  bool do_screen;
+  double screen_cutoff, screen_skin;
+  unsigned screen_natoms;
+  std::vector<std::pair<unsigned,unsigned> > screen_pairs;
+  std::vector< std::vector<double> > screen_refdist;
+  std::vector<double> screen_norm;
+  std::vector<Vector> screen_lastpos;
 /// Tempory variables for getting positions of atoms and applying forces
   std::vector<double> forcesToApply;
 /// Get the index of an atom
   unsigned getAtomIndex( const unsigned& current, const unsigned& iatom ) const ;
+/// Set up the lower bounds used to screen the segments for a new reference structure
+  void setupScreen( const std::vector<Vector>& structure, double bondlength );
+/// Deactivate the segments that certainly cannot contribute
+  void screenSegments();
 protected:
 /// Get the atoms in the backbone
   void readBackboneAtoms( const std::string& backnames, std::vector<unsigned>& chain_lengths );
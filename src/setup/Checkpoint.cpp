@@ -0,0 +1,122 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2020 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "core/ActionSetup.h"
+#include "core/ActionRegister.h"
+#include "core/PlumedMain.h"
+#include "tools/Checkpoint.h"
+#include "tools/FileBase.h"
+#include "tools/Exception.h"
+#include <cstdio>
+
+namespace PLMD {
+namespace setup {
+
+//+PLUMEDOC GENERIC CHECKPOINT
+/*
+Periodically save the internal state of the actions in a binary checkpoint file and use it to restart.
+
+When restarting, actions such as \ref METAD usually rebuild their internal state
+by reading back their whole history (e.g. by replaying all the hills stored in the HILLS file).
+For long simulations this can take a significant amount of time.
+This directive makes PLUMED write a single binary file containing the internal
+state of all the actions that support it, so that upon restart the state
+can be restored at a cost that only depends on its size.
+
+The file is written every STRIDE steps and whenever the MD code signals a checkpoint step.
+Writing is atomic: the file is first written with a `.tmp` suffix and then renamed,
+so that a crash while writing never leaves a corrupted checkpoint behind.
+
+When the simulation is restarting (see \ref RESTART) and the checkpoint file exists,
+it is read and the actions that find their state in it restore it instead of
+reading their history. Actions that are not in the checkpoint behave as usual.
+Text output files (e.g. HILLS) are still appended, so that they remain complete.
+
+Currently, \ref METAD, \ref PBMETAD, OPES_METAD and OPES_METAD_EXPLORE store their state in the checkpoint.
+All the other actions, including stateful ones such as OPES_EXPANDED,
+the VES biases, the analysis and averaging actions or DRR,
+are not saved and restart from their own files exactly as they would without this directive.
+
+This is a Setup directive and, as such, should appear
+at the beginning of the input file. If \ref RESTART is used, it should be placed
+before this directive.
+
+\par Examples
+
+In the following input the state of METAD is saved every 1000 steps in the file state.cpt
+\plumedfile
+RESTART
+CHECKPOINT FILE=state.cpt STRIDE=1000
+d: DISTANCE ATOMS=1,2
+METAD ARG=d SIGMA=0.1 HEIGHT=1.0 PACE=100 GRID_MIN=0 GRID_MAX=5 GRID_BIN=500
+\endplumedfile
+
+*/
+//+ENDPLUMEDOC
+
+class Checkpoint :
+  public virtual ActionSetup
+{
+public:
+  static void registerKeywords( Keywords& keys );
+  explicit Checkpoint(const ActionOptions&ao);
+};
+
+PLUMED_REGISTER_ACTION(Checkpoint,"CHECKPOINT")
+
+void Checkpoint::registerKeywords( Keywords& keys ) {
+  ActionSetup::registerKeywords(keys);
+  keys.add("compulsory","FILE","state.cpt","the binary file where the state of the actions is stored");
+  keys.add("compulsory","STRIDE","0","the frequency with which the checkpoint is written. If 0, it is only written when the MD code signals a checkpoint step");
+}
+
+Checkpoint::Checkpoint(const ActionOptions&ao):
+  Action(ao),
+  ActionSetup(ao)
+{
+  std::string file;
+  parse("FILE",file);
+  long int stride=0;
+  parse("STRIDE",stride);
+  checkRead();
+  if(stride<0) error("STRIDE should be non negative");
+
+  file=FileBase::appendSuffix(file,plumed.getSuffix());
+  plumed.setCheckpoint(file,stride);
+  log<<"  writing binary checkpoint on file "<<file;
+  if(stride>0) log<<" every "<<stride<<" steps";
+  log<<" and at checkpoint steps\n";
+
+  if(!getRestart()) return;
+  FILE* fp=std::fopen(file.c_str(),"rb");
+  if(!fp) {
+    log<<"  checkpoint file not found, actions will restart from their own files\n";
+    return;
+  }
+  std::fclose(fp);
+  PLMD::Checkpoint & cpt(plumed.getCheckpoint());
+  cpt.read(file);
+  log.printf("  restarting from checkpoint taken at step %ld\n",cpt.getStep());
+  log.printf("  checkpoint contains the state of %u actions (%zu bytes)\n",cpt.getNumberOfSections(),cpt.getSize());
+}
+
+}
+}
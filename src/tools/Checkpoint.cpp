@@ -0,0 +1,158 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2020 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Checkpoint.h"
+#include <cstdio>
+
+namespace PLMD {
+
+/// Tag identifying a checkpoint file, including the format version
+static const char checkpointTag[8]= {'P','L','M','D','C','P','T','1'};
+
+Checkpoint::Checkpoint():
+  step(0),
+  pos(0),
+  buffer(NULL)
+{
+}
+
+void Checkpoint::clear() {
+  plumed_massert(!buffer,"cannot clear a checkpoint while section " + current + " is open");
+  sections.clear();
+  step=0;
+}
+
+bool Checkpoint::hasSection(const std::string&label)const {
+  return sections.count(label)>0;
+}
+
+std::size_t Checkpoint::getSize()const {
+  std::size_t size=0;
+  for(const auto & s : sections) size+=s.second.size();
+  return size;
+}
+
+void Checkpoint::beginSection(const std::string&label) {
+  plumed_massert(!buffer,"cannot begin section " + label + " while section " + current + " is open");
+  plumed_massert(!hasSection(label),"section " + label + " is already present in checkpoint");
+  current=label;
+  buffer=&sections[label];
+}
+
+void Checkpoint::endSection() {
+  plumed_massert(buffer,"no section is being written");
+  buffer=NULL;
+  current.clear();
+}
+
+void Checkpoint::openSection(const std::string&label) {
+  plumed_massert(!buffer,"cannot open section " + label + " while section " + current + " is open");
+  auto it=sections.find(label);
+  plumed_massert(it!=sections.end(),"section " + label + " is not present in checkpoint");
+  current=label;
+  buffer=&it->second;
+  pos=0;
+}
+
+void Checkpoint::closeSection() {
+  plumed_massert(buffer,"no section is being read");
+  plumed_massert(pos==buffer->size(),"section " + current + " of checkpoint was not completely read");
+  buffer=NULL;
+  current.clear();
+}
+
+void Checkpoint::putBytes(const void*p,std::size_t n) {
+  plumed_massert(buffer,"no section is being written");
+  const char* c=static_cast<const char*>(p);
+  buffer->insert(buffer->end(),c,c+n);
+}
+
+void Checkpoint::getBytes(void*p,std::size_t n) {
+  plumed_massert(buffer,"no section is being read");
+  plumed_massert(pos+n<=buffer->size(),"trying to read past the end of section " + current + " of checkpoint");
+  std::memcpy(p,buffer->data()+pos,n);
+  pos+=n;
+}
+
+void Checkpoint::put(const std::string&s) {
+  put(static_cast<unsigned long long>(s.size()));
+  putBytes(s.data(),s.size());
+}
+
+void Checkpoint::get(std::string&s) {
+  unsigned long long n;
+  get(n);
+  plumed_massert(pos+n<=buffer->size(),"trying to read past the end of section " + current + " of checkpoint");
+  s.assign(buffer->data()+pos,n);
+  pos+=n;
+}
+
+void Checkpoint::write(const std::string&fname)const {
+  plumed_massert(!buffer,"cannot write a checkpoint while section " + current + " is open");
+  const std::string tmpname=fname+".tmp";
+  FILE* fp=std::fopen(tmpname.c_str(),"wb");
+  plumed_massert(fp,"cannot open checkpoint file " + tmpname + " for writing");
+  bool ok=(std::fwrite(checkpointTag,sizeof(checkpointTag),1,fp)==1);
+  long long s=step;
+  unsigned long long n=sections.size();
+  ok=ok && std::fwrite(&s,sizeof(s),1,fp)==1;
+  ok=ok && std::fwrite(&n,sizeof(n),1,fp)==1;
+  for(const auto & sec : sections) {
+    unsigned long long nl=sec.first.size();
+    unsigned long long nd=sec.second.size();
+    ok=ok && std::fwrite(&nl,sizeof(nl),1,fp)==1;
+    ok=ok && std::fwrite(sec.first.data(),1,nl,fp)==nl;
+    ok=ok && std::fwrite(&nd,sizeof(nd),1,fp)==1;
+    ok=ok && std::fwrite(sec.second.data(),1,nd,fp)==nd;
+  }
+  ok=(std::fclose(fp)==0) && ok;
+  plumed_massert(ok,"error while writing checkpoint file " + tmpname);
+  plumed_massert(std::rename(tmpname.c_str(),fname.c_str())==0,"cannot rename " + tmpname + " to " + fname);
+}
+
+void Checkpoint::read(const std::string&fname) {
+  plumed_massert(!buffer,"cannot read a checkpoint while section " + current + " is open");
+  sections.clear();
+  FILE* fp=std::fopen(fname.c_str(),"rb");
+  plumed_massert(fp,"cannot open checkpoint file " + fname);
+  char tag[sizeof(checkpointTag)];
+  bool ok=(std::fread(tag,sizeof(tag),1,fp)==1) && std::memcmp(tag,checkpointTag,sizeof(tag))==0;
+  long long s=0;
+  unsigned long long n=0;
+  ok=ok && std::fread(&s,sizeof(s),1,fp)==1;
+  ok=ok && std::fread(&n,sizeof(n),1,fp)==1;
+  for(unsigned long long i=0; ok && i<n; i++) {
+    unsigned long long nl=0,nd=0;
+    ok=ok && std::fread(&nl,sizeof(nl),1,fp)==1;
+    std::string label(nl,' ');
+    ok=ok && std::fread(&label[0],1,nl,fp)==nl;
+    ok=ok && std::fread(&nd,sizeof(nd),1,fp)==1;
+    if(!ok) break;
+    std::vector<char> & data(sections[label]);
+    data.resize(nd);
+    ok=std::fread(data.data(),1,nd,fp)==nd;
+  }
+  std::fclose(fp);
+  plumed_massert(ok,"file " + fname + " is not a valid checkpoint");
+  step=s;
+}
+
+}
@@ -0,0 +1,148 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2020 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_Checkpoint_h
+#define __PLUMED_tools_Checkpoint_h
+
+#include <vector>
+#include <string>
+#include <map>
+#include <cstring>
+#include <type_traits>
+#include "Exception.h"
+
+namespace PLMD {
+
+/**
+\ingroup TOOLBOX
+Class storing the internal state of a set of actions in binary form.
+
+The state is organized in sections, one per action, identified by
+the action label. Each section is a plain sequence of bytes that
+is filled with put() and consumed, in the same order, with get().
+Only trivially copyable types, std::string and std::vector of these can be stored.
+Checkpoints are written atomically: data is first dumped on a temporary file
+which is then renamed, so that a crash while writing never leaves a corrupted file.
+
+\verbatim
+PLMD::Checkpoint cpt;
+cpt.beginSection("metad");
+cpt.put(nhills);
+cpt.put(centers);
+cpt.endSection();
+cpt.write("state.cpt");
+
+PLMD::Checkpoint rcpt;
+rcpt.read("state.cpt");
+rcpt.openSection("metad");
+rcpt.get(nhills);
+rcpt.get(centers);
+rcpt.closeSection();
+\endverbatim
+*/
+class Checkpoint {
+/// Raw data of each section, indexed by label
+  std::map<std::string,std::vector<char> > sections;
+/// Step at which the checkpoint was taken
+  long int step;
+/// Label of the section currently being written or read
+  std::string current;
+/// Position of the read cursor in the current section
+  std::size_t pos;
+/// Pointer to the section currently being written or read
+  std::vector<char>* buffer;
+  void putBytes(const void*,std::size_t);
+  void getBytes(void*,std::size_t);
+public:
+  Checkpoint();
+/// Remove all the sections
+  void clear();
+/// Set the step at which the checkpoint is taken
+  void setStep(long int s) {step=s;}
+/// Get the step at which the checkpoint was taken
+  long int getStep()const {return step;}
+/// Check if a section with this label exists
+  bool hasSection(const std::string&)const;
+/// Get the number of sections
+  unsigned getNumberOfSections()const {return sections.size();}
+/// Get the total size in bytes of the stored data
+  std::size_t getSize()const;
+/// Start writing a new section
+  void beginSection(const std::string&);
+/// Finish writing the current section
+  void endSection();
+/// Start reading a section
+  void openSection(const std::string&);
+/// Finish reading the current section, checking that all the data was consumed
+  void closeSection();
+/// Append a trivially copyable object to the current section
+  template<typename T>
+  void put(const T&);
+/// Append a vector to the current section
+  template<typename T>
+  void put(const std::vector<T>&);
+/// Append a string to the current section
+  void put(const std::string&);
+/// Read a trivially copyable object from the current section
+  template<typename T>
+  void get(T&);
+/// Read a vector from the current section
+  template<typename T>
+  void get(std::vector<T>&);
+/// Read a string from the current section
+  void get(std::string&);
+/// Write the checkpoint on a file, atomically
+  void write(const std::string&)const;
+/// Read the checkpoint from a file
+  void read(const std::string&);
+};
+
+template<typename T>
+void Checkpoint::put(const T&t) {
+  static_assert(std::is_trivially_copyable<T>::value,"only trivially copyable types can be stored in a checkpoint");
+  putBytes(&t,sizeof(T));
+}
+
+template<typename T>
+void Checkpoint::put(const std::vector<T>&v) {
+  static_assert(std::is_trivially_copyable<T>::value,"only trivially copyable types can be stored in a checkpoint");
+  put(static_cast<unsigned long long>(v.size()));
+  if(v.size()>0) putBytes(v.data(),v.size()*sizeof(T));
+}
+
+template<typename T>
+void Checkpoint::get(T&t) {
+  static_assert(std::is_trivially_copyable<T>::value,"only trivially copyable types can be stored in a checkpoint");
+  getBytes(&t,sizeof(T));
+}
+
+template<typename T>
+void Checkpoint::get(std::vector<T>&v) {
+  static_assert(std::is_trivially_copyable<T>::value,"only trivially copyable types can be stored in a checkpoint");
+  unsigned long long n;
+  get(n);
+  v.resize(n);
+  if(n>0) getBytes(v.data(),n*sizeof(T));
+}
+
+}
+
+#endif
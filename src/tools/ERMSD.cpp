@@ -29,16 +29,23 @@
 #include "PDB.h"
 #include "Matrix.h"
 #include "Tensor.h"
+#include "OpenMP.h"
 
 #include "Pbc.h"
 #include <cmath>
 #include <iostream>
+#include <algorithm>
 
 
 namespace PLMD {
 
+// Form factors - should this be somewhere else?
+static const Vector form_factor = Vector(2.0,2.0,1.0/0.3);
+
 void ERMSD::clear() {
+  reference_pairs.clear();
   reference_mat.clear();
+  reference_index.clear();
 }
 
 //void ERMSD::calcLcs(const vector<Vector> & positions, vector<Vector> &)
@@ -48,43 +55,52 @@ void ERMSD::setReference(const std::vector<Vector> & reference, const std::vecto
   natoms = reference.size();
   nresidues = natoms/3;
   unsigned npairs = pairs_vec.size()/2;
-  pairs.resize(npairs);
+  pairs.clear();
   for(unsigned i=0; i<npairs; ++i) {
-
-    pairs[i].first = pairs_vec[2*i];
-    pairs[i].second = pairs_vec[2*i+1];
+    const unsigned a=pairs_vec[2*i];
+    const unsigned b=pairs_vec[2*i+1];
+    if(a==b) continue;
+    pairs.push_back(std::make_pair(a,b));
+    pairs.push_back(std::make_pair(b,a));
   }
+  std::sort(pairs.begin(),pairs.end());
+  pairs.erase(std::unique(pairs.begin(),pairs.end()),pairs.end());
 
+  // the cell list used in calc() needs a positive cutoff
+  plumed_massert(mycutoff>0.0,"ERMSD cutoff should be positive");
   cutoff = mycutoff;
-  std::vector<TensorGeneric<4,3> > deri;
-  deri.resize(natoms*natoms);
-  reference_mat.resize(nresidues*nresidues);
-  Pbc fake_pbc;
-
-  calcMat(reference,fake_pbc,reference_mat,deri);
 
+  std::vector<Vector> centers;
+  std::vector<Vector3d> pos;
+  std::vector<Tensor3d> deri;
+  calcFrames(reference,centers,pos,deri);
+  std::vector<std::pair<unsigned,unsigned> > neigh;
+  getNeighborPairs(centers,neigh);
+  std::sort(neigh.begin(),neigh.end());
+
+  clear();
+  TensorGeneric<4,3> gderi[6];
+  for(const auto & p : neigh) {
+    Vector4d g;
+    if(calcPair(p.first,p.second,centers,pos,deri,g,gderi)) {
+      reference_index[p.first*nresidues+p.second]=reference_pairs.size();
+      reference_pairs.push_back(p);
+      reference_mat.push_back(g);
+    }
+  }
 }
 
-bool ERMSD::inPair(unsigned i, unsigned j) {
+bool ERMSD::inPair(unsigned i, unsigned j) const {
 
   if(pairs.size()==0) return true;
-  for(unsigned idx=0; idx<pairs.size(); idx++) {
-    if(pairs[idx].first == i && pairs[idx].second == j) return true;
-    if(pairs[idx].second == i && pairs[idx].first == j) return true;
-  }
-  return false;
+  return std::binary_search(pairs.begin(),pairs.end(),std::make_pair(i,j));
 }
 
-void ERMSD::calcMat(const std::vector<Vector> & positions,const Pbc& pbc, std::vector<Vector4d> &mat, std::vector<TensorGeneric<4,3> > &Gderi) {
-
-  std::vector<Vector3d> pos;
-  pos.resize(3*nresidues);
+void ERMSD::calcFrames(const std::vector<Vector> & positions, std::vector<Vector> & centers, std::vector<Vector3d> & pos, std::vector<Tensor3d> & deri) const {
 
-  std::vector<Tensor3d> deri;
-  deri.resize(nresidues*9);
-
-  std::vector<Vector> centers;
-  centers.resize(nresidues);
+  pos.assign(3*nresidues,Vector3d());
+  deri.assign(nresidues*9,Tensor3d());
+  centers.assign(nresidues,Vector());
 
   unsigned idx_deri = 0;
 
@@ -96,12 +112,9 @@ void ERMSD::calcMat(const std::vector<Vector> & positions,const Pbc& pbc, std::v
   Tensor db_dxb = (2./3.)*Tensor::identity();
   Tensor db_dxc = -(1./3.)*Tensor::identity();
 
-  // Form factors - should this be somewhere else?
-
   double w = 1./3.;
-  Vector form_factor = Vector(2.0,2.0,1.0/0.3);
 
-  for(unsigned res_idx=0; res_idx<natoms/3; res_idx++) {
+  for(unsigned res_idx=0; res_idx<nresidues; res_idx++) {
 
 
     const unsigned at_idx = 3*res_idx;
@@ -157,104 +170,138 @@ void ERMSD::calcMat(const std::vector<Vector> & positions,const Pbc& pbc, std::v
     // End derivatives ///////
 
   }
+}
 
+void ERMSD::getNeighborPairs(const std::vector<Vector> & centers, std::vector<std::pair<unsigned,unsigned> > & neigh) const {
 
-  // Initialization (unnecessary?)
-  for (unsigned i1=0; i1<nresidues*nresidues; i1++) {
-    for (unsigned i2=0; i2<4; i2++) {
-      mat[i1][i2] = 0.0;
+  // since |rtilde| >= 2 |r|, no pair farther than this can be within the ellipsoidal cutoff
+  const double maxdist = cutoff/form_factor[0];
+  const double maxdist2 = maxdist*maxdist;
+  neigh.clear();
+
+  // if the pairs are listed explicitly there is no need to search them
+  if(pairs.size()>0) {
+    for(const auto & p : pairs) {
+      if(p.first>=nresidues || p.second>=nresidues) continue;
+      if(delta(centers[p.first],centers[p.second]).modulo2()<maxdist2) neigh.push_back(p);
+    }
+    return;
+  }
+  if(nresidues==0) return;
+
+  // cell list on the base centers, with cells at least as large as maxdist
+  Vector lower=centers[0], upper=centers[0];
+  for(unsigned i=1; i<nresidues; i++) {
+    for(unsigned k=0; k<3; k++) {
+      lower[k]=std::min(lower[k],centers[i][k]);
+      upper[k]=std::max(upper[k],centers[i][k]);
     }
   }
+  double side=maxdist;
+  unsigned ncells[3];
+  for(;;) {
+    for(unsigned k=0; k<3; k++) ncells[k]=static_cast<unsigned>((upper[k]-lower[k])/side)+1;
+    // avoid having many more cells than residues if the molecule is very sparse
+    if(static_cast<double>(ncells[0])*ncells[1]*ncells[2]<=8.0*nresidues+27.0) break;
+    side*=2.0;
+  }
+  const unsigned totcells=ncells[0]*ncells[1]*ncells[2];
+  std::vector<unsigned> cell_of(nresidues);
+  std::vector<unsigned> cell_start(totcells+1,0);
+  for(unsigned i=0; i<nresidues; i++) {
+    unsigned c[3];
+    for(unsigned k=0; k<3; k++) c[k]=std::min(ncells[k]-1,static_cast<unsigned>((centers[i][k]-lower[k])/side));
+    cell_of[i]=(c[0]*ncells[1]+c[1])*ncells[2]+c[2];
+    cell_start[cell_of[i]+1]++;
+  }
+  for(unsigned c=0; c<totcells; c++) cell_start[c+1]+=cell_start[c];
+  std::vector<unsigned> cell_list(nresidues);
+  std::vector<unsigned> fill(cell_start.begin(),cell_start.end()-1);
+  for(unsigned i=0; i<nresidues; i++) cell_list[fill[cell_of[i]]++]=i;
 
-  double maxdist = cutoff/form_factor[0];
-  double gamma = pi/cutoff;
-  unsigned idx;
-  unsigned idx1 = 0;
-  // Calculate mat
-  for (unsigned i=0; i<nresidues; i++) {
-    for (unsigned j=0; j<nresidues; j++) {
-
-      // skip i==j
-      if(inPair(i,j) and i != j) {
-        //if(i!=j){
-
-
-        // Calculate normal distance first
-        Vector diff = delta(centers[i],centers[j]);
-        double d1 = diff.modulo();
-        if(d1<maxdist) {
-
-          // calculate r_tilde_ij
-          Vector3d rtilde;
-          for (unsigned k=0; k<3; k++) {
-            for (unsigned l=0; l<3; l++) {
-              rtilde[l] += pos[3*i+l][k]*diff[k]*form_factor[l];
-            }
+  for(unsigned i=0; i<nresidues; i++) {
+    const unsigned ci=cell_of[i];
+    const int cx=ci/(ncells[1]*ncells[2]);
+    const int cy=(ci/ncells[2])%ncells[1];
+    const int cz=ci%ncells[2];
+    for(int dx=-1; dx<=1; dx++) {
+      if(cx+dx<0 || cx+dx>=int(ncells[0])) continue;
+      for(int dy=-1; dy<=1; dy++) {
+        if(cy+dy<0 || cy+dy>=int(ncells[1])) continue;
+        for(int dz=-1; dz<=1; dz++) {
+          if(cz+dz<0 || cz+dz>=int(ncells[2])) continue;
+          const unsigned cj=((cx+dx)*ncells[1]+(cy+dy))*ncells[2]+(cz+dz);
+          for(unsigned k=cell_start[cj]; k<cell_start[cj+1]; k++) {
+            const unsigned j=cell_list[k];
+            if(j==i) continue;
+            if(delta(centers[i],centers[j]).modulo2()<maxdist2) neigh.push_back(std::make_pair(i,j));
           }
-          double rtilde_norm = rtilde.modulo();
-
-          double irnorm = 1./rtilde_norm;
-
-          // ellipsoidal cutoff
-          if(rtilde_norm < cutoff) {
-            idx = i*nresidues + j;
-
-
-            // fill 4d matrix
-            double dummy = sin(gamma*rtilde_norm)/(rtilde_norm*gamma);
-            mat[idx][0] = dummy*rtilde[0];
-            mat[idx][1] = dummy*rtilde[1];
-            mat[idx][2] = dummy*rtilde[2];
-            mat[idx][3] = (1.+ cos(gamma*rtilde_norm))/gamma;
-
-            // Derivative (drtilde_dx)
-            std::vector<Tensor3d> drtilde_dx;
-            drtilde_dx.resize(6);
-            unsigned pos_idx = 3*i;
-            unsigned deri_idx = 9*i;
-            for (unsigned at=0; at<3; at++) {
-              for (unsigned l=0; l<3; l++) {
-                Vector3d rvec = form_factor[l]*((pos[pos_idx+l])/3.);
-                Vector3d vvec = form_factor[l]*(matmul(deri[deri_idx+3*at+l],diff));
-                drtilde_dx[at].setRow(l,vvec-rvec);
-                drtilde_dx[at+3].setRow(l,rvec);
-              }
-            }
-
-            double dummy1 = (cos(gamma*rtilde_norm) - dummy);
-
-            idx1 = i*nresidues*6 + j*6;
-
-            for (unsigned l=0; l<6; l++) {
-              //std::cout << i << " " << j << " " << idx1 << " " << idx1+l << "\n";
-
-              // components 1,2,3
-              // sin(gamma*|rtilde|)/gamma*|rtilde|*d_rtilde +
-              // + ((d_rtilde*r_tilde/r_tilde^2) out r_tilde)*
-              // (cos(gamma*|rtilde| - sin(gamma*|rtilde|)/gamma*|rtilde|))
-              Vector3d rdr = matmul(rtilde,drtilde_dx[l]);
-              Tensor tt = dummy*drtilde_dx[l] + (dummy1*irnorm*irnorm)*Tensor(rtilde,rdr);
-              for (unsigned m=0; m<3; m++) {
-                // Transpose here
-                //dG_dx[l].setRow(m,tt.getRow(m));
-                Gderi[idx1+l].setRow(m,tt.getRow(m));
-              }
-              // component 4
-              // - sin(gamma*|rtilde|)/|rtilde|*(r_tilde*d_rtilde)
-              //dG_dx[l].setRow(3,-dummy*gamma*rdr);
-              Gderi[idx1+l].setRow(3,-dummy*gamma*rdr);
-            }
-
+        }
+      }
+    }
+  }
+}
 
+bool ERMSD::calcPair(unsigned i, unsigned j, const std::vector<Vector> & centers, const std::vector<Vector3d> & pos,
+                     const std::vector<Tensor3d> & deri, Vector4d & g, TensorGeneric<4,3>* gderi) const {
 
+  const double gamma = pi/cutoff;
+  g.zero();
 
-          }
-        }
-      }
+  Vector diff = delta(centers[i],centers[j]);
 
+  // calculate r_tilde_ij
+  Vector3d rtilde;
+  for (unsigned k=0; k<3; k++) {
+    for (unsigned l=0; l<3; l++) {
+      rtilde[l] += pos[3*i+l][k]*diff[k]*form_factor[l];
+    }
+  }
+  double rtilde_norm = rtilde.modulo();
+
+  // ellipsoidal cutoff
+  if(!(rtilde_norm < cutoff)) return false;
+
+  double irnorm = 1./rtilde_norm;
+
+  // fill 4d vector
+  double dummy = sin(gamma*rtilde_norm)/(rtilde_norm*gamma);
+  g[0] = dummy*rtilde[0];
+  g[1] = dummy*rtilde[1];
+  g[2] = dummy*rtilde[2];
+  g[3] = (1.+ cos(gamma*rtilde_norm))/gamma;
+
+  // Derivative (drtilde_dx)
+  Tensor3d drtilde_dx[6];
+  unsigned pos_idx = 3*i;
+  unsigned deri_idx = 9*i;
+  for (unsigned at=0; at<3; at++) {
+    for (unsigned l=0; l<3; l++) {
+      Vector3d rvec = form_factor[l]*((pos[pos_idx+l])/3.);
+      Vector3d vvec = form_factor[l]*(matmul(deri[deri_idx+3*at+l],diff));
+      drtilde_dx[at].setRow(l,vvec-rvec);
+      drtilde_dx[at+3].setRow(l,rvec);
     }
   }
 
+  double dummy1 = (cos(gamma*rtilde_norm) - dummy);
+
+  for (unsigned l=0; l<6; l++) {
+    // components 1,2,3
+    // sin(gamma*|rtilde|)/gamma*|rtilde|*d_rtilde +
+    // + ((d_rtilde*r_tilde/r_tilde^2) out r_tilde)*
+    // (cos(gamma*|rtilde| - sin(gamma*|rtilde|)/gamma*|rtilde|))
+    Vector3d rdr = matmul(rtilde,drtilde_dx[l]);
+    Tensor tt = dummy*drtilde_dx[l] + (dummy1*irnorm*irnorm)*Tensor(rtilde,rdr);
+    for (unsigned m=0; m<3; m++) {
+      // Transpose here
+      gderi[l].setRow(m,tt.getRow(m));
+    }
+    // component 4
+    // - sin(gamma*|rtilde|)/|rtilde|*(r_tilde*d_rtilde)
+    gderi[l].setRow(3,-dummy*gamma*rdr);
+  }
+  return true;
 }
 
 
@@ -263,33 +310,62 @@ double ERMSD::calculate(const std::vector<Vector> & positions,const Pbc& pbc,\
 
 
   double ermsd=0.;
-  std::vector<Vector4d> mat;
-  mat.resize(nresidues*nresidues);
-
-  std::vector<TensorGeneric<4,3> > Gderi;
-  Gderi.resize(natoms*natoms);
 
-  calcMat(positions,pbc,mat,Gderi);
-
-  unsigned idx1 = 0;
-  for(unsigned i=0; i<nresidues; i++) {
-    for(unsigned j=0; j<nresidues; j++) {
-      unsigned ii = i*nresidues + j;
+  std::vector<Vector> centers;
+  std::vector<Vector3d> pos;
+  std::vector<Tensor3d> deri;
+  calcFrames(positions,centers,pos,deri);
+
+  std::vector<std::pair<unsigned,unsigned> > neigh;
+  getNeighborPairs(centers,neigh);
+
+  // reference pairs that are also close in the current structure
+  std::vector<char> matched(reference_pairs.size(),0);
+
+  unsigned nt=OpenMP::getNumThreads();
+  if(neigh.size()<100*nt) nt=1;
+  #pragma omp parallel num_threads(nt)
+  {
+    std::vector<Vector> omp_derivatives(derivatives.size());
+    double omp_ermsd=0.;
+    TensorGeneric<4,3> gderi[6];
+    #pragma omp for nowait
+    for(unsigned k=0; k<neigh.size(); k++) {
+      const unsigned i=neigh[k].first;
+      const unsigned j=neigh[k].second;
+      Vector4d g;
+      const bool inside=calcPair(i,j,centers,pos,deri,g,gderi);
+
+      Vector4d ref;
+      const auto it=reference_index.find(i*nresidues+j);
+      if(it!=reference_index.end()) {
+        ref=reference_mat[it->second];
+        matched[it->second]=1;
+      }
 
-      Vector4d dd = delta(reference_mat[ii],mat[ii]);
+      Vector4d dd = delta(ref,g);
       double val = dd.modulo2();
 
-      if(val>0.0 && i!=j) {
-
-        for(unsigned k=0; k<3; k++) {
-          idx1 = i*nresidues*6 + j*6 + k;
-
-          derivatives[3*i+k] += matmul(dd,Gderi[idx1]);
-          derivatives[3*j+k] += matmul(dd,Gderi[idx1+3]);
+      if(val>0.0) {
+        if(inside) {
+          for(unsigned l=0; l<3; l++) {
+            omp_derivatives[3*i+l] += matmul(dd,gderi[l]);
+            omp_derivatives[3*j+l] += matmul(dd,gderi[l+3]);
+          }
         }
-        ermsd += val;
+        omp_ermsd += val;
       }
     }
+    #pragma omp critical
+    {
+      for(unsigned l=0; l<derivatives.size(); l++) derivatives[l]+=omp_derivatives[l];
+      ermsd+=omp_ermsd;
+    }
+  }
+
+  // reference pairs that are far apart now only contribute to the value
+  for(unsigned k=0; k<reference_pairs.size(); k++) {
+    if(!matched[k]) ermsd += reference_mat[k].modulo2();
   }
 
   ermsd = sqrt(ermsd/nresidues);
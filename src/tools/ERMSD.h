@@ -27,7 +27,7 @@
 #include <vector>
 #include <limits>
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <utility>
 #include <cstddef>
 
@@ -38,13 +38,26 @@ class Pbc;
 
 /// A class that implements ERMSD calculations
 class ERMSD {
-  //std::map< std::pair <unsigned,unsigned> , double> targets;
-  //unsigned natoms;
+/// G vectors of the reference, only for the pairs of residues where they are not zero
+  std::vector<std::pair<unsigned,unsigned> > reference_pairs;
   std::vector<Vector4d> reference_mat;
+/// Position of a pair i*nresidues+j in reference_pairs
+  std::unordered_map<std::size_t,unsigned> reference_index;
   std::size_t natoms;
   std::size_t nresidues;
+/// Pairs of residues that should be considered (both orders), if empty all pairs are used
   std::vector<std::pair <unsigned,unsigned> > pairs;
   double cutoff;
+/// Compute the center and the local reference frame of each base, together with the derivatives
+/// of the frame versors with respect to the three atoms
+  void calcFrames(const std::vector<Vector> & positions, std::vector<Vector> & centers, std::vector<Vector3d> & pos, std::vector<Tensor3d> & deri) const;
+/// Find the pairs of residues whose centers are closer than the largest distance allowed by the
+/// ellipsoidal cutoff, using a cell list on the base centers
+  void getNeighborPairs(const std::vector<Vector> & centers, std::vector<std::pair<unsigned,unsigned> > & neigh) const;
+/// Compute the G vector of a pair and its derivatives with respect to the six atoms.
+/// Returns false if the pair is outside the cutoff, in which case G is zero
+  bool calcPair(unsigned i, unsigned j, const std::vector<Vector> & centers, const std::vector<Vector3d> & pos,
+                const std::vector<Tensor3d> & deri, Vector4d & g, TensorGeneric<4,3>* gderi) const;
 
 public:
 /// Constructor
@@ -53,16 +66,11 @@ public:
 /// clear the structure
   void clear();
 
-  bool inPair(unsigned i, unsigned j);
+  bool inPair(unsigned i, unsigned j) const;
 
 /// set reference coordinates
   void setReference(const std::vector<Vector> & reference, const std::vector<unsigned> & pairs_vec,double mycutoff=0.24);
 
-  void calcMat(const std::vector<Vector> & positions, const Pbc& pbc,std::vector<Vector4d> &mat,std::vector<TensorGeneric<4,3> > & Gderivatives);
-
-/// Compute ermsd ( no pbc )
-//  double calculate(const std::vector<Vector> & positions,
-//                   std::vector<Vector> &derivatives, Tensor& virial) const ;
 /// Compute ermsd ( with pbc )
   double calculate(const std::vector<Vector>& positions, const Pbc& pbc,std::vector<Vector> &derivatives, Tensor& virial);
 };
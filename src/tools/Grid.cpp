@@ -28,6 +28,7 @@
 #include "KernelFunctions.h"
 #include "RootFindingBase.h"
 #include "Communicator.h"
+#include "Checkpoint.h"
 
 #include <vector>
 #include <cmath>
@@ -512,6 +513,25 @@ void Grid::writeToFile(OFile& ofile) {
   }
 }
 
+void Grid::saveCheckpoint(Checkpoint& cpt) const {
+  cpt.put(maxsize_);
+  cpt.put(grid_);
+  cpt.put(der_);
+}
+
+void Grid::restoreCheckpoint(Checkpoint& cpt) {
+  index_t size;
+  cpt.get(size);
+  plumed_massert(size==maxsize_,"size of grid " + funcname + " in checkpoint does not match input");
+  cpt.get(grid_);
+  cpt.get(der_);
+  plumed_massert(grid_.size()==maxsize_ && der_.size()==(usederiv_?maxsize_*dimension_:0),"corrupted grid " + funcname + " in checkpoint");
+}
+
+std::size_t Grid::getMemoryUsage() const {
+  return (grid_.capacity()+der_.capacity())*sizeof(double);
+}
+
 void GridBase::writeCubeFile(OFile& ofile, const double& lunit) {
   plumed_assert( dimension_==3 );
   ofile.printf("PLUMED CUBE FILE\n");
@@ -536,8 +556,8 @@ void GridBase::writeCubeFile(OFile& ofile, const double& lunit) {
 
 std::unique_ptr<GridBase> GridBase::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile,
     const std::vector<std::string> & gmin,const std::vector<std::string> & gmax,
-    const std::vector<unsigned> & nbin,bool dosparse, bool dospline, bool doder) {
-  std::unique_ptr<GridBase> grid=GridBase::create(funcl,args,ifile,dosparse,dospline,doder);
+    const std::vector<unsigned> & nbin,bool dosparse, bool dospline, bool doder, bool doblock) {
+  std::unique_ptr<GridBase> grid=GridBase::create(funcl,args,ifile,dosparse,dospline,doder,doblock);
   std::vector<unsigned> cbin( grid->getNbin() );
   std::vector<std::string> cmin( grid->getMin() ), cmax( grid->getMax() );
   for(unsigned i=0; i<args.size(); ++i) {
@@ -552,7 +572,7 @@ std::unique_ptr<GridBase> GridBase::create(const std::string& funcl, const std::
   return grid;
 }
 
-std::unique_ptr<GridBase> GridBase::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile, bool dosparse, bool dospline, bool doder)
+std::unique_ptr<GridBase> GridBase::create(const std::string& funcl, const std::vector<Value*> & args, IFile& ifile, bool dosparse, bool dospline, bool doder, bool doblock)
 {
   std::unique_ptr<GridBase> grid;
   unsigned nvar=args.size(); bool hasder=false; std::string pstring;
@@ -588,7 +608,8 @@ std::unique_ptr<GridBase> GridBase::create(const std::string& funcl, const std::
     }
   }
 
-  if(!dosparse) {grid=Tools::make_unique<Grid>(funcl,args,gmin,gmax,gbin,dospline,doder);}
+  if(doblock) {grid=Tools::make_unique<BlockGrid>(funcl,args,gmin,gmax,gbin,dospline,doder);}
+  else if(!dosparse) {grid=Tools::make_unique<Grid>(funcl,args,gmin,gmax,gbin,dospline,doder);}
   else {grid=Tools::make_unique<SparseGrid>(funcl,args,gmin,gmax,gbin,dospline,doder);}
 
   std::vector<double> xx(nvar),dder(nvar);
@@ -831,6 +852,53 @@ void SparseGrid::writeToFile(OFile& ofile) {
   }
 }
 
+void SparseGrid::saveCheckpoint(Checkpoint& cpt) const {
+  std::vector<index_t> indices;
+  std::vector<double> values;
+  std::vector<double> ders;
+  indices.reserve(map_.size());
+  values.reserve(map_.size());
+  for(const auto & it : map_) {
+    indices.push_back(it.first);
+    values.push_back(it.second);
+    if(usederiv_) {
+      auto d=der_.find(it.first);
+      for(unsigned j=0; j<dimension_; ++j) ders.push_back(d!=der_.end() ? d->second[j] : 0.0);
+    }
+  }
+  cpt.put(maxsize_);
+  cpt.put(indices);
+  cpt.put(values);
+  cpt.put(ders);
+}
+
+void SparseGrid::restoreCheckpoint(Checkpoint& cpt) {
+  index_t size;
+  std::vector<index_t> indices;
+  std::vector<double> values;
+  std::vector<double> ders;
+  cpt.get(size);
+  plumed_massert(size==maxsize_,"size of grid " + funcname + " in checkpoint does not match input");
+  cpt.get(indices);
+  cpt.get(values);
+  cpt.get(ders);
+  plumed_massert(values.size()==indices.size() && ders.size()==(usederiv_?indices.size()*dimension_:0),"corrupted grid " + funcname + " in checkpoint");
+  map_.clear();
+  der_.clear();
+  for(unsigned i=0; i<indices.size(); ++i) {
+    map_[indices[i]]=values[i];
+    if(usederiv_) der_[indices[i]].assign(ders.begin()+i*dimension_,ders.begin()+(i+1)*dimension_);
+  }
+}
+
+std::size_t SparseGrid::getMemoryUsage() const {
+// each node of a std::map also stores three pointers and a color
+  const std::size_t node=3*sizeof(void*)+sizeof(int);
+  std::size_t mem=map_.size()*(node+sizeof(index_t)+sizeof(double));
+  for(const auto & d : der_) mem+=node+sizeof(index_t)+sizeof(std::vector<double>)+d.second.capacity()*sizeof(double);
+  return mem;
+}
+
 double SparseGrid::getMinValue() const {
   double minval;
   minval=0.0;
@@ -849,6 +917,198 @@ double SparseGrid::getMaxValue() const {
   return maxval;
 }
 
+void BlockGrid::setupBlocks() {
+// blocks contain a few hundred bins, enough to cover a typical hill
+  if(dimension_==1) blockbin_=64;
+  else if(dimension_==2) blockbin_=16;
+  else if(dimension_==3) blockbin_=8;
+  else if(dimension_==4) blockbin_=4;
+  else blockbin_=2;
+  unsigned maxbin=1;
+  for(unsigned i=0; i<dimension_; ++i) if(nbin_[i]>maxbin) maxbin=nbin_[i];
+  if(blockbin_>maxbin) blockbin_=maxbin;
+  blocksize_=1;
+  nblock_.resize(dimension_);
+  for(unsigned i=0; i<dimension_; ++i) {
+    blocksize_*=blockbin_;
+    nblock_[i]=(nbin_[i]+blockbin_-1)/blockbin_;
+  }
+  stride_=(usederiv_ ? 1+dimension_ : 1);
+}
+
+void BlockGrid::getBlock(index_t index, index_t& block, unsigned& offset) const {
+  index_t bstride=1;
+  unsigned ostride=1;
+  block=0; offset=0;
+  for(unsigned i=0; i<dimension_; ++i) {
+    const unsigned ind=index%nbin_[i];
+    index/=nbin_[i];
+    block+=bstride*(ind/blockbin_);
+    offset+=ostride*(ind%blockbin_);
+    bstride*=nblock_[i];
+    ostride*=blockbin_;
+  }
+}
+
+bool BlockGrid::getGridIndex(index_t block, unsigned offset, index_t& index) const {
+  index_t gstride=1;
+  index=0;
+  for(unsigned i=0; i<dimension_; ++i) {
+    const unsigned ind=(block%nblock_[i])*blockbin_+offset%blockbin_;
+    if(ind>=nbin_[i]) return false;
+    block/=nblock_[i];
+    offset/=blockbin_;
+    index+=gstride*ind;
+    gstride*=nbin_[i];
+  }
+  return true;
+}
+
+const double* BlockGrid::find(index_t index) const {
+  index_t block; unsigned offset;
+  getBlock(index,block,offset);
+  const auto it=blockpos_.find(block);
+  if(it==blockpos_.end()) return NULL;
+  return &data_[(it->second*blocksize_+offset)*stride_];
+}
+
+double* BlockGrid::allocate(index_t index) {
+  index_t block; unsigned offset;
+  getBlock(index,block,offset);
+  auto it=blockpos_.find(block);
+  if(it==blockpos_.end()) {
+    it=blockpos_.insert(std::make_pair(block,static_cast<unsigned>(blockid_.size()))).first;
+    blockid_.push_back(block);
+    data_.resize(data_.size()+blocksize_*stride_,0.0);
+  }
+  return &data_[(it->second*blocksize_+offset)*stride_];
+}
+
+Grid::index_t BlockGrid::getSize() const {
+  return maxsize_;
+}
+
+Grid::index_t BlockGrid::getAllocatedSize() const {
+  return blockid_.size()*blocksize_;
+}
+
+double BlockGrid::getValue(index_t index)const {
+  plumed_assert(index<maxsize_);
+  const double* p=find(index);
+  return (p ? p[0] : 0.0);
+}
+
+double BlockGrid::getValueAndDerivatives(index_t index, std::vector<double>& der)const {
+  plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
+  const double* p=find(index);
+  if(!p) {
+    for(unsigned int i=0; i<dimension_; ++i) der[i]=0.0;
+    return 0.0;
+  }
+  for(unsigned int i=0; i<dimension_; ++i) der[i]=p[1+i];
+  return p[0];
+}
+
+void BlockGrid::setValue(index_t index, double value) {
+  plumed_assert(index<maxsize_ && !usederiv_);
+  allocate(index)[0]=value;
+}
+
+void BlockGrid::setValueAndDerivatives(index_t index, double value, std::vector<double>& der) {
+  plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
+  double* p=allocate(index);
+  p[0]=value;
+  for(unsigned int i=0; i<dimension_; ++i) p[1+i]=der[i];
+}
+
+void BlockGrid::addValue(index_t index, double value) {
+  plumed_assert(index<maxsize_ && !usederiv_);
+  allocate(index)[0]+=value;
+}
+
+void BlockGrid::addValueAndDerivatives(index_t index, double value, std::vector<double>& der) {
+  plumed_assert(index<maxsize_ && usederiv_ && der.size()==dimension_);
+  double* p=allocate(index);
+  p[0]+=value;
+  for(unsigned int i=0; i<dimension_; ++i) p[1+i]+=der[i];
+}
+
+double BlockGrid::getMinValue() const {
+  double minval=0.0;
+  for(unsigned i=0; i<data_.size(); i+=stride_) {
+    if(data_[i]<minval) minval=data_[i];
+  }
+  return minval;
+}
+
+double BlockGrid::getMaxValue() const {
+  double maxval=0.0;
+  for(unsigned i=0; i<data_.size(); i+=stride_) {
+    if(data_[i]>maxval) maxval=data_[i];
+  }
+  return maxval;
+}
+
+void BlockGrid::writeToFile(OFile& ofile) {
+// only the allocated bins are written, sorted as in a dense grid
+  std::vector<index_t> allocated;
+  allocated.reserve(getAllocatedSize());
+  for(unsigned i=0; i<blockid_.size(); ++i) {
+    for(unsigned j=0; j<blocksize_; ++j) {
+      index_t index;
+      if(getGridIndex(blockid_[i],j,index)) allocated.push_back(index);
+    }
+  }
+  std::sort(allocated.begin(),allocated.end());
+  std::vector<double> xx(dimension_);
+  std::vector<double> der(dimension_);
+  double f;
+  writeHeader(ofile);
+  for(const auto & i : allocated) {
+    xx=getPoint(i);
+    if(usederiv_) {f=getValueAndDerivatives(i,der);}
+    else {f=getValue(i);}
+    if(i>0 && dimension_>1 && getIndices(i)[dimension_-2]==0) ofile.printf("\n");
+    for(unsigned j=0; j<dimension_; ++j) {
+      ofile.printField("min_" + argnames[j], str_min_[j] );
+      ofile.printField("max_" + argnames[j], str_max_[j] );
+      ofile.printField("nbins_" + argnames[j], static_cast<int>(nbin_[j]) );
+      if( pbc_[j] ) ofile.printField("periodic_" + argnames[j], "true" );
+      else          ofile.printField("periodic_" + argnames[j], "false" );
+    }
+    for(unsigned j=0; j<dimension_; ++j) { ofile.fmtField(" "+fmt_); ofile.printField(argnames[j],xx[j]); }
+    ofile.fmtField(" "+fmt_); ofile.printField(funcname,f);
+    if(usederiv_) for(unsigned j=0; j<dimension_; ++j) { ofile.fmtField(" "+fmt_); ofile.printField("der_" + argnames[j],der[j]); }
+    ofile.printField();
+  }
+}
+
+void BlockGrid::saveCheckpoint(Checkpoint& cpt) const {
+  cpt.put(maxsize_);
+  cpt.put(blocksize_);
+  cpt.put(blockid_);
+  cpt.put(data_);
+}
+
+void BlockGrid::restoreCheckpoint(Checkpoint& cpt) {
+  index_t size;
+  unsigned bsize;
+  cpt.get(size);
+  cpt.get(bsize);
+  plumed_massert(size==maxsize_ && bsize==blocksize_,"size of grid " + funcname + " in checkpoint does not match input");
+  cpt.get(blockid_);
+  cpt.get(data_);
+  plumed_massert(data_.size()==blockid_.size()*blocksize_*stride_,"corrupted grid " + funcname + " in checkpoint");
+  blockpos_.clear();
+  for(unsigned i=0; i<blockid_.size(); ++i) blockpos_[blockid_[i]]=i;
+}
+
+std::size_t BlockGrid::getMemoryUsage() const {
+// each node of a std::unordered_map also stores a pointer, plus one pointer per bucket
+  std::size_t mem=blockpos_.size()*(sizeof(index_t)+sizeof(unsigned)+sizeof(void*))+blockpos_.bucket_count()*sizeof(void*);
+  return mem+blockid_.capacity()*sizeof(index_t)+data_.capacity()*sizeof(double);
+}
+
 void Grid::projectOnLowDimension(double &val, std::vector<int> &vHigh, WeightBase * ptr2obj ) {
   unsigned i=0;
   for(i=0; i<vHigh.size(); i++) {
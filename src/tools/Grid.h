@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <cmath>
 #include <memory>
 #include <cstddef>
@@ -67,6 +68,7 @@ class IFile;
 class OFile;
 class KernelFunctions;
 class Communicator;
+class Checkpoint;
 
 /// \ingroup TOOLBOX
 class GridBase
@@ -158,11 +160,12 @@ public:
   void writeHeader(OFile& file);
 
 /// read grid from file
-  static std::unique_ptr<GridBase> create(const std::string&,const std::vector<Value*>&,IFile&,bool,bool,bool);
+/// the last flag requests a BlockGrid
+  static std::unique_ptr<GridBase> create(const std::string&,const std::vector<Value*>&,IFile&,bool,bool,bool,bool doblock=false);
 /// read grid from file and check boundaries are what is expected from input
   static std::unique_ptr<GridBase> create(const std::string&,const std::vector<Value*>&, IFile&,
                                           const std::vector<std::string>&,const std::vector<std::string>&,
-                                          const std::vector<unsigned>&,bool,bool,bool);
+                                          const std::vector<unsigned>&,bool,bool,bool,bool doblock=false);
 /// get grid size
   virtual index_t getSize() const=0;
 /// get grid value
@@ -196,8 +199,14 @@ public:
 
 /// dump grid on file
   virtual void writeToFile(OFile&)=0;
+/// save grid values and derivatives in a binary checkpoint
+  virtual void saveCheckpoint(Checkpoint&) const=0;
+/// restore grid values and derivatives from a binary checkpoint
+  virtual void restoreCheckpoint(Checkpoint&)=0;
 /// dump grid to gaussian cube file
   void writeCubeFile(OFile&, const double& lunit);
+/// approximate number of bytes used to store values and derivatives
+  virtual std::size_t getMemoryUsage() const=0;
 
   virtual ~GridBase() {}
 
@@ -267,6 +276,9 @@ public:
   void logAllValuesAndDerivatives( const double& scalef );
 /// dump grid on file
   void writeToFile(OFile&) override;
+  void saveCheckpoint(Checkpoint&) const override;
+  void restoreCheckpoint(Checkpoint&) override;
+  std::size_t getMemoryUsage() const override;
 
 /// Set the minimum value of the grid to zero and translates accordingly
   void setMinToZero();
@@ -331,9 +343,85 @@ public:
   double getMaxValue() const override;
 /// dump grid on file
   void writeToFile(OFile&) override;
+  void saveCheckpoint(Checkpoint&) const override;
+  void restoreCheckpoint(Checkpoint&) override;
+  std::size_t getMemoryUsage() const override;
 
   virtual ~SparseGrid() {}
 };
+
+/// Grid where bins are grouped in blocks that are only allocated the first time
+/// one of their values is set, so that memory is only used in the explored regions.
+/// Unallocated bins have zero value and derivatives.
+class BlockGrid : public GridBase
+{
+/// number of bins per dimension in each block
+  unsigned blockbin_;
+/// number of bins in each block
+  unsigned blocksize_;
+/// number of values stored for each bin (value and derivatives)
+  unsigned stride_;
+/// number of blocks per dimension
+  std::vector<unsigned> nblock_;
+/// position in data_ of each allocated block
+  std::unordered_map<index_t,unsigned> blockpos_;
+/// global block index of each allocated block
+  std::vector<index_t> blockid_;
+/// values and derivatives of all the allocated blocks
+  std::vector<double> data_;
+/// split a grid index into the index of its block and the offset inside the block
+  void getBlock(index_t index, index_t& block, unsigned& offset) const;
+/// values and derivatives of a bin, or NULL if its block is not allocated
+  const double* find(index_t index) const;
+/// values and derivatives of a bin, allocating its block if needed
+  double* allocate(index_t index);
+/// grid index of a bin in a block, returns false for bins beyond the grid boundaries
+  bool getGridIndex(index_t block, unsigned offset, index_t& index) const;
+/// set up the block decomposition
+  void setupBlocks();
+
+public:
+  BlockGrid(const std::string& funcl, const std::vector<Value*> & args, const std::vector<std::string> & gmin,
+            const std::vector<std::string> & gmax,
+            const std::vector<unsigned> & nbin, bool dospline, bool usederiv):
+    GridBase(funcl,args,gmin,gmax,nbin,dospline,usederiv) { setupBlocks(); }
+
+  index_t getSize() const override;
+/// get the number of bins that are actually stored
+  index_t getAllocatedSize() const;
+
+/// this is to access to Grid:: version of these methods (allowing overloading of virtual methods)
+  using GridBase::getValue;
+  using GridBase::getValueAndDerivatives;
+  using GridBase::setValue;
+  using GridBase::setValueAndDerivatives;
+  using GridBase::addValue;
+  using GridBase::addValueAndDerivatives;
+
+/// get grid value
+  double getValue(index_t index) const override;
+/// get grid value and derivatives
+  double getValueAndDerivatives(index_t index, std::vector<double>& der) const override;
+
+/// set grid value
+  void setValue(index_t index, double value) override;
+/// set grid value and derivatives
+  void setValueAndDerivatives(index_t index, double value, std::vector<double>& der) override;
+/// add to grid value
+  void addValue(index_t index, double value) override;
+/// add to grid value and derivatives
+  void addValueAndDerivatives(index_t index, double value, std::vector<double>& der) override;
+
+/// get minimum value
+  double getMinValue() const override;
+/// get maximum value
+  double getMaxValue() const override;
+/// dump grid on file
+  void writeToFile(OFile&) override;
+  void saveCheckpoint(Checkpoint&) const override;
+  void restoreCheckpoint(Checkpoint&) override;
+  std::size_t getMemoryUsage() const override;
+};
 }
 
 #endif
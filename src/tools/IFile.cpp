@@ -28,6 +28,7 @@
 #include "Tools.h"
 #include <cstdarg>
 #include <cstring>
+#include <cstdlib>
 #include <cmath>
 
 #include <iostream>
@@ -66,37 +67,61 @@ IFile& IFile::advanceField() {
     getline(line);
 // using explicit conversion not to confuse cppcheck 1.86
     if(!bool(*this)) {return *this;}
-    std::vector<std::string> words=Tools::getWords(line);
-    if(words.size()>=2 && words[0]=="#!" && words[1]=="FIELDS") {
-      fields.clear();
-      for(unsigned i=2; i<words.size(); i++) {
+// only lines starting with #! can change the list of fields
+    std::size_t first=line.find_first_not_of(" \t");
+    if(first!=std::string::npos && line.compare(first,2,"#!")==0) {
+      std::vector<std::string> words=Tools::getWords(line);
+      if(words.size()>=2 && words[0]=="#!" && words[1]=="FIELDS") {
+        fields.clear();
+        for(unsigned i=2; i<words.size(); i++) {
+          Field field;
+          field.name=words[i];
+          fields.push_back(field);
+        }
+        nextField=0;
+        continue;
+      } else if(words.size()==4 && words[0]=="#!" && words[1]=="SET") {
         Field field;
-        field.name=words[i];
+        field.name=words[2];
+        field.value=words[3];
+        field.constant=true;
         fields.push_back(field);
+        continue;
       }
-    } else if(words.size()==4 && words[0]=="#!" && words[1]=="SET") {
-      Field field;
-      field.name=words[2];
-      field.value=words[3];
-      field.constant=true;
-      fields.push_back(field);
+    }
+    unsigned nf=0;
+    for(unsigned i=0; i<fields.size(); i++) if(!fields[i].constant) nf++;
+    Tools::trimComments(line);
+// braces group words together so in that case the general parser is needed.
+// Otherwise the positions of the words are found and the values are copied straight into the fields
+    std::vector<std::string> words;
+    bool braces=line.find_first_of("{}")!=std::string::npos;
+    std::size_t nw=0;
+    if(braces) {
+      words=Tools::getWords(line); nw=words.size();
     } else {
-      unsigned nf=0;
-      for(unsigned i=0; i<fields.size(); i++) if(!fields[i].constant) nf++;
-      Tools::trimComments(line);
-      words=Tools::getWords(line);
-      if( words.size()==nf ) {
-        unsigned j=0;
-        for(unsigned i=0; i<fields.size(); i++) {
-          if(fields[i].constant) continue;
-          fields[i].value=words[j];
-          fields[i].read=false;
-          j++;
-        }
-        done=true;
-      } else if( !words.empty() ) {
-        plumed_merror("file " + getPath() + ": mismatch between number of fields in file and expected number");
+      wordpos.clear();
+      std::size_t start=line.find_first_not_of(" \t\n");
+      while(start!=std::string::npos) {
+        std::size_t end=line.find_first_of(" \t\n",start);
+        if(end==std::string::npos) end=line.length();
+        wordpos.push_back(std::pair<std::size_t,std::size_t>(start,end-start));
+        start=line.find_first_not_of(" \t\n",end);
       }
+      nw=wordpos.size();
+    }
+    if( nw==nf ) {
+      unsigned j=0;
+      for(unsigned i=0; i<fields.size(); i++) {
+        if(fields[i].constant) continue;
+        if(braces) fields[i].value=words[j];
+        else fields[i].value.assign(line,wordpos[j].first,wordpos[j].second);
+        fields[i].read=false;
+        j++;
+      }
+      done=true;
+    } else if( nw>0 ) {
+      plumed_merror("file " + getPath() + ": mismatch between number of fields in file and expected number");
     }
   }
   inMiddleOfField=true;
@@ -134,11 +159,11 @@ IFile& IFile::scanFieldList(std::vector<std::string>&s) {
 }
 
 bool IFile::FieldExist(const std::string& s) {
-  std::vector<std::string> slist;
-  scanFieldList(slist);
-  int mycount = (int) std::count(slist.begin(), slist.end(), s);
-  if(mycount>0) return true;
-  else return false;
+  if(!inMiddleOfField) advanceField();
+// using explicit conversion not to confuse cppcheck 1.86
+  if(!bool(*this)) return false;
+  for(unsigned i=0; i<fields.size(); i++) if(fields[i].name==s) return true;
+  return false;
 }
 
 IFile& IFile::scanField(const std::string&name,std::string&str) {
@@ -152,9 +177,16 @@ IFile& IFile::scanField(const std::string&name,std::string&str) {
 }
 
 IFile& IFile::scanField(const std::string&name,double &x) {
-  std::string str;
-  scanField(name,str);
-  if(*this) Tools::convert(str,x);
+  if(!inMiddleOfField) advanceField();
+// using explicit conversion not to confuse cppcheck 1.86
+  if(!bool(*this)) return *this;
+  unsigned i=findField(name);
+  fields[i].read=true;
+// plain numbers are converted with strtod, anything else (e.g. pi) goes through Tools::convert
+  const char* str=fields[i].value.c_str(); char* end;
+  double val=std::strtod(str,&end);
+  if(end!=str && *end=='\0' && std::isfinite(val)) x=val;
+  else Tools::convert(fields[i].value,x);
   return *this;
 }
 
@@ -214,7 +246,8 @@ IFile& IFile::scanField() {
 IFile::IFile():
   inMiddleOfField(false),
   ignoreFields(false),
-  noEOL(false)
+  noEOL(false),
+  nextField(0)
 {
 }
 
@@ -227,12 +260,29 @@ IFile& IFile::getline(std::string &str) {
   str="";
   fpos_t pos;
   fgetpos(fp,&pos);
-  while(llread(&tmp,1)==1 && tmp && tmp!='\n' && tmp!='\r' && !eof && !err) {
-    str+=tmp;
-  }
-  if(tmp=='\r') {
-    llread(&tmp,1);
-    plumed_massert(tmp=='\n',"plumed only accepts \\n (unix) or \\r\\n (dos) new lines");
+  if(gzfp) {
+    while(llread(&tmp,1)==1 && tmp && tmp!='\n' && tmp!='\r' && !eof && !err) {
+      str+=tmp;
+    }
+    if(tmp=='\r') {
+      llread(&tmp,1);
+      plumed_massert(tmp=='\n',"plumed only accepts \\n (unix) or \\r\\n (dos) new lines");
+    }
+  } else {
+// plain files are read with getc, which is much faster than reading one character at a time with llread
+    int c;
+    while((c=std::getc(fp))!=EOF && c && c!='\n' && c!='\r') {
+      tmp=c; str+=tmp;
+    }
+    if(c==EOF) {
+      if(std::feof(fp)) eof=true;
+      if(std::ferror(fp)) err=true;
+    } else tmp=c;
+    if(tmp=='\r') {
+      c=std::getc(fp);
+      plumed_massert(c=='\n',"plumed only accepts \\n (unix) or \\r\\n (dos) new lines");
+      tmp=c;
+    }
   }
   if(eof && noEOL) {
     if(str.length()>0) eof=false;
@@ -251,12 +301,15 @@ IFile& IFile::getline(std::string &str) {
   return *this;
 }
 
-unsigned IFile::findField(const std::string&name)const {
-  unsigned i;
-  for(i=0; i<fields.size(); i++) if(fields[i].name==name) break;
+unsigned IFile::findField(const std::string&name) {
+  unsigned i=nextField;
+  if(i>=fields.size() || fields[i].name!=name) {
+    for(i=0; i<fields.size(); i++) if(fields[i].name==name) break;
+  }
   if(i>=fields.size()) {
     plumed_merror("file " + getPath() + ": field " + name + " cannot be found");
   }
+  nextField=i+1;
   return i;
 }
 
@@ -58,10 +58,15 @@ class IFile:
   bool ignoreFields;
 /// Set to true to allow files without end-of-line at the end
   bool noEOL;
+/// Index of the field that follows the last one that was found.
+/// Fields are usually read in the order they appear in the file so this is checked first
+  unsigned nextField;
+/// Positions and lengths of the words in the last line that was read
+  std::vector<std::pair<std::size_t,std::size_t> > wordpos;
 /// Advance to next field (= read one line)
   IFile& advanceField();
 /// Find field index by name
-  unsigned findField(const std::string&name)const;
+  unsigned findField(const std::string&name);
 public:
 /// Constructor
   IFile();
@@ -29,6 +29,7 @@
 #include <vector>
 #include <algorithm>
 #include <numeric>
+#include <sstream>
 
 namespace PLMD {
 
@@ -53,6 +54,9 @@ NeighborList::NeighborList(const std::vector<AtomNumber>& list0, const std::vect
   }
   initialize();
   lastupdate_=0;
+  cacheversion_=0;
+  nbuilt_=0;
+  ncopied_=0;
 }
 
 NeighborList::NeighborList(const std::vector<AtomNumber>& list0, const bool& serial, const bool& do_pbc,
@@ -66,6 +70,9 @@ NeighborList::NeighborList(const std::vector<AtomNumber>& list0, const bool& ser
   nallpairs_=nlist0_*(nlist0_-1)/2;
   initialize();
   lastupdate_=0;
+  cacheversion_=0;
+  nbuilt_=0;
+  ncopied_=0;
 }
 
 void NeighborList::initialize() {
@@ -94,11 +101,31 @@ std::pair<unsigned,unsigned> NeighborList::getIndexPair(unsigned ipair) {
   return index;
 }
 
+bool NeighborList::cacheMatches(const std::vector<Vector>& positions) const {
+  if(!cache_->valid || cache_->positions.size()!=positions.size()) return false;
+  if(do_pbc_) {
+    const Tensor & box=pbc_->getBox();
+    for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) if(box(i,j)!=cache_->box(i,j)) return false;
+  }
+  for(unsigned i=0; i<positions.size(); i++) for(unsigned j=0; j<3; j++) {
+      if(positions[i][j]!=cache_->positions[i][j]) return false;
+    }
+  return true;
+}
+
 void NeighborList::update(const std::vector<Vector>& positions) {
-  neighbors_.clear();
-  const double d2=distance_*distance_;
   // check if positions array has the correct length
   plumed_assert(positions.size()==fullatomlist_.size());
+  // reuse the pairs found by another neighbor list with the same positions
+  if(cache_ && cacheMatches(positions)) {
+    neighbors_=cache_->neighbors;
+    cacheversion_=cache_->nbuilds;
+    ncopied_++;
+    setRequestList();
+    return;
+  }
+  neighbors_.clear();
+  const double d2=distance_*distance_;
 
   unsigned stride=comm.Get_size();
   unsigned rank=comm.Get_rank();
@@ -110,28 +137,50 @@ void NeighborList::update(const std::vector<Vector>& positions) {
   }
   std::vector<unsigned> local_flat_nl;
 
-  #pragma omp parallel num_threads(nt)
-  {
-    std::vector<unsigned> private_flat_nl;
-    #pragma omp for nowait
-    for(unsigned int i=rank; i<nallpairs_; i+=stride) {
-      std::pair<unsigned,unsigned> index=getIndexPair(i);
-      unsigned index0=index.first;
-      unsigned index1=index.second;
-      Vector distance;
-      if(do_pbc_) {
-        distance=pbc_->distance(positions[index0],positions[index1]);
-      } else {
-        distance=delta(positions[index0],positions[index1]);
+  auto isClose=[&](unsigned index0,unsigned index1) {
+    Vector distance;
+    if(do_pbc_) {
+      distance=pbc_->distance(positions[index0],positions[index1]);
+    } else {
+      distance=delta(positions[index0],positions[index1]);
+    }
+    return modulo2(distance)<=d2;
+  };
+
+  if(!twolists_) {
+// single list: each thread of each process takes a block of rows of the upper triangle
+// with the same number of pairs. Blocks are merged in order, so that pairs are sorted
+// as in a serial run
+    std::vector<unsigned> bounds;
+    OpenMP::getTriangularBlocks(nlist0_,stride*nt,bounds);
+    std::vector<std::vector<unsigned>> blocks_flat_nl(nt);
+    #pragma omp parallel for num_threads(nt)
+    for(unsigned b=0; b<nt; b++) {
+      for(unsigned index0=bounds[rank*nt+b]; index0<bounds[rank*nt+b+1]; index0++) {
+        for(unsigned index1=index0+1; index1<nlist0_; index1++) {
+          if(isClose(index0,index1)) {
+            blocks_flat_nl[b].push_back(index0);
+            blocks_flat_nl[b].push_back(index1);
+          }
+        }
       }
-      double value=modulo2(distance);
-      if(value<=d2) {
-        private_flat_nl.push_back(index0);
-        private_flat_nl.push_back(index1);
+    }
+    for(const auto & b : blocks_flat_nl) local_flat_nl.insert(local_flat_nl.end(), b.begin(), b.end());
+  } else {
+    #pragma omp parallel num_threads(nt)
+    {
+      std::vector<unsigned> private_flat_nl;
+      #pragma omp for nowait
+      for(unsigned int i=rank; i<nallpairs_; i+=stride) {
+        std::pair<unsigned,unsigned> index=getIndexPair(i);
+        if(isClose(index.first,index.second)) {
+          private_flat_nl.push_back(index.first);
+          private_flat_nl.push_back(index.second);
+        }
       }
+      #pragma omp critical
+      local_flat_nl.insert(local_flat_nl.end(), private_flat_nl.begin(), private_flat_nl.end());
     }
-    #pragma omp critical
-    local_flat_nl.insert(local_flat_nl.end(), private_flat_nl.begin(), private_flat_nl.end());
   }
 
   // find total dimension of neighborlist
@@ -139,26 +188,38 @@ void NeighborList::update(const std::vector<Vector>& positions) {
   local_nl_size[rank] = local_flat_nl.size();
   if(!serial_) comm.Sum(&local_nl_size[0], stride);
   int tot_size = std::accumulate(local_nl_size.begin(), local_nl_size.end(), 0);
-  if(tot_size==0) {setRequestList(); return;}
-  // merge
-  std::vector<unsigned> merge_nl(tot_size, 0);
-  // calculate vector of displacement
-  std::vector<int> disp(stride);
-  disp[0] = 0;
-  int rank_size = 0;
-  for(unsigned i=0; i<stride-1; ++i) {
-    rank_size += local_nl_size[i];
-    disp[i+1] = rank_size;
+  if(tot_size>0) {
+    // merge
+    std::vector<unsigned> merge_nl(tot_size, 0);
+    // calculate vector of displacement
+    std::vector<int> disp(stride);
+    disp[0] = 0;
+    int rank_size = 0;
+    for(unsigned i=0; i<stride-1; ++i) {
+      rank_size += local_nl_size[i];
+      disp[i+1] = rank_size;
+    }
+    // Allgather neighbor list
+    if(comm.initialized()&&!serial_) comm.Allgatherv((!local_flat_nl.empty()?&local_flat_nl[0]:NULL), local_nl_size[rank], &merge_nl[0], &local_nl_size[0], &disp[0]);
+    else merge_nl = local_flat_nl;
+    // resize neighbor stuff
+    neighbors_.resize(tot_size/2);
+    for(unsigned i=0; i<tot_size/2; i++) {
+      unsigned j=2*i;
+      neighbors_[i] = std::make_pair(merge_nl[j],merge_nl[j+1]);
+    }
   }
-  // Allgather neighbor list
-  if(comm.initialized()&&!serial_) comm.Allgatherv((!local_flat_nl.empty()?&local_flat_nl[0]:NULL), local_nl_size[rank], &merge_nl[0], &local_nl_size[0], &disp[0]);
-  else merge_nl = local_flat_nl;
-  // resize neighbor stuff
-  neighbors_.resize(tot_size/2);
-  for(unsigned i=0; i<tot_size/2; i++) {
-    unsigned j=2*i;
-    neighbors_[i] = std::make_pair(merge_nl[j],merge_nl[j+1]);
+
+  if(cache_) {
+    cache_->valid=true;
+    cache_->positions=positions;
+    if(do_pbc_) cache_->box=pbc_->getBox();
+    cache_->neighbors=neighbors_;
+    cache_->hasReduced=false;
+    cache_->nbuilds++;
+    cacheversion_=cache_->nbuilds;
   }
+  nbuilt_++;
 
   setRequestList();
 }
@@ -174,6 +235,12 @@ void NeighborList::setRequestList() {
 }
 
 std::vector<AtomNumber>& NeighborList::getReducedAtomList() {
+  // the list is shared and another neighbor list already reduced it
+  const bool shared=(cache_ && cache_->valid && cacheversion_==cache_->nbuilds);
+  if(!reduced && shared && cache_->hasReduced) {
+    neighbors_=cache_->reducedNeighbors;
+    reduced=true;
+  }
   if(!reduced)for(unsigned int i=0; i<size(); ++i) {
       unsigned newindex0=0,newindex1=0;
       AtomNumber index0=fullatomlist_[neighbors_[i].first];
@@ -183,6 +250,10 @@ std::vector<AtomNumber>& NeighborList::getReducedAtomList() {
       p = std::find(requestlist_.begin(), requestlist_.end(), index1); plumed_dbg_assert(p!=requestlist_.end()); newindex1=p-requestlist_.begin();
       neighbors_[i]=std::pair<unsigned,unsigned>(newindex0,newindex1);
     }
+  if(!reduced && shared) {
+    cache_->reducedNeighbors=neighbors_;
+    cache_->hasReduced=true;
+  }
   reduced=true;
   return requestlist_;
 }
@@ -213,6 +284,26 @@ std::pair<AtomNumber,AtomNumber> NeighborList::getClosePairAtomNumber(unsigned i
   return Aneigh;
 }
 
+std::string NeighborList::getCacheKey() const {
+  std::ostringstream ostr;
+  ostr<<std::hexfloat<<distance_<<" "<<twolists_<<do_pair_<<do_pbc_<<serial_<<" "<<nlist0_;
+  for(const auto & a : fullatomlist_) ostr<<" "<<a.index();
+  return ostr.str();
+}
+
+void NeighborList::setCache(const std::shared_ptr<NeighborListCache>& cache) {
+  cache_=cache;
+  cacheversion_=0;
+}
+
+unsigned long NeighborList::getNumberOfBuilds() const {
+  return nbuilt_;
+}
+
+unsigned long NeighborList::getNumberOfCopies() const {
+  return ncopied_;
+}
+
 std::vector<unsigned> NeighborList::getNeighbors(unsigned index) {
   std::vector<unsigned> neighbors;
   for(unsigned int i=0; i<size(); ++i) {
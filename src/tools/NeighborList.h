@@ -23,8 +23,11 @@
 #define __PLUMED_tools_NeighborList_h
 
 #include "Vector.h"
+#include "Tensor.h"
 #include "AtomNumber.h"
 
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace PLMD {
@@ -32,6 +35,29 @@ namespace PLMD {
 class Pbc;
 class Communicator;
 
+/// \ingroup TOOLBOX
+/// Close pairs found by NeighborList::update(), which can be shared among
+/// neighbor lists built on the same atoms with the same settings (e.g. several
+/// COORDINATION actions using the same groups and cutoff).
+/// When a neighbor list is updated with the same positions and box used
+/// to build the shared pairs, it just copies them instead of looping
+/// over all the possible pairs again.
+class NeighborListCache {
+  friend class NeighborList;
+/// True when the data below refer to a complete update
+  bool valid=false;
+/// Positions and box used in the last update
+  std::vector<Vector> positions;
+  Tensor box;
+/// Close pairs, with indexes in the full list of atoms
+  std::vector<std::pair<unsigned,unsigned> > neighbors;
+/// Close pairs, with indexes in the reduced list of atoms
+  std::vector<std::pair<unsigned,unsigned> > reducedNeighbors;
+  bool hasReduced=false;
+/// Number of times the pairs were computed, used to tell which version is stored
+  unsigned long nbuilds=0;
+};
+
 /// \ingroup TOOLBOX
 /// A class that implements neighbor lists from two lists or a single list of atoms
 class NeighborList
@@ -45,6 +71,14 @@ class NeighborList
   std::vector<std::pair<unsigned,unsigned> > neighbors_;
   double distance_;
   unsigned stride_,nlist0_,nlist1_,nallpairs_,lastupdate_;
+/// Pairs shared with other neighbor lists, if any
+  std::shared_ptr<NeighborListCache> cache_;
+/// Version of the shared pairs stored in neighbors_
+  unsigned long cacheversion_;
+/// Number of updates where the pairs were computed or copied from the cache
+  unsigned long nbuilt_,ncopied_;
+/// Check if the shared pairs were computed with these positions
+  bool cacheMatches(const std::vector<PLMD::Vector>& positions) const;
 /// Initialize the neighbor list with all possible pairs
   void initialize();
 /// Return the pair of indexes in the positions array
@@ -87,6 +121,15 @@ public:
   ~NeighborList() {}
 /// Get the i-th pair of AtomNumbers from the neighbor list
   std::pair<AtomNumber,AtomNumber> getClosePairAtomNumber(unsigned i) const;
+/// Get a string that identifies the atoms and settings of this neighbor list.
+/// Neighbor lists with the same key can share a NeighborListCache.
+  std::string getCacheKey() const;
+/// Share the close pairs with the other neighbor lists using the same cache
+  void setCache(const std::shared_ptr<NeighborListCache>& cache);
+/// Get the number of updates where the close pairs were computed
+  unsigned long getNumberOfBuilds() const;
+/// Get the number of updates where the close pairs were copied from another neighbor list
+  unsigned long getNumberOfCopies() const;
 };
 
 }
@@ -22,6 +22,8 @@
 
 #include "OpenMP.h"
 #include "Tools.h"
+#include "Log.h"
+#include <chrono>
 #include <cstdlib>
 #if defined(_OPENMP)
 #include <omp.h>
@@ -35,6 +37,8 @@ struct OpenMPVars {
   bool cache_set=false;
   unsigned num_threads=1;
   bool nt_env_set=false;
+  bool autotune=false;
+  bool autotune_set=false;
 };
 
 static OpenMPVars & getOpenMPVars() {
@@ -62,6 +66,19 @@ unsigned OpenMP::getNumThreads() {
   return getOpenMPVars().num_threads;
 }
 
+bool OpenMP::getAutotune() {
+  if(!getOpenMPVars().autotune_set) {
+    if(std::getenv("PLUMED_OPENMP_AUTOTUNE")) getOpenMPVars().autotune=(std::string(std::getenv("PLUMED_OPENMP_AUTOTUNE"))=="yes");
+    getOpenMPVars().autotune_set = true;
+  }
+  return getOpenMPVars().autotune;
+}
+
+void OpenMP::setAutotune(bool autotune) {
+  getOpenMPVars().autotune=autotune;
+  getOpenMPVars().autotune_set=true;
+}
+
 unsigned OpenMP::getThreadNum() {
 #if defined(_OPENMP)
   return omp_get_thread_num();
@@ -70,9 +87,87 @@ unsigned OpenMP::getThreadNum() {
 #endif
 }
 
+void OpenMP::getBalancedBlocks(const std::vector<double>& cost,unsigned nblocks,std::vector<unsigned>& bounds) {
+  plumed_assert(nblocks>0);
+  const unsigned n=cost.size();
+  double total=0.0;
+  for(const auto & c : cost) total+=c;
+  bounds.assign(nblocks+1,n);
+  bounds[0]=0;
+  unsigned k=0;
+  double prefix=0.0;
+  for(unsigned b=1; b<nblocks; b++) {
+    const double target=total*b/nblocks;
+// a task goes in the current block if most of its cost falls before the target
+    while(k<n && prefix+0.5*cost[k]<target) {
+      prefix+=cost[k];
+      k++;
+    }
+    bounds[b]=k;
+  }
+}
+
+void OpenMP::getTriangularBlocks(unsigned n,unsigned nblocks,std::vector<unsigned>& bounds) {
+  std::vector<double> cost(n);
+  for(unsigned i=0; i<n; i++) cost[i]=n-1-i;
+  getBalancedBlocks(cost,nblocks,bounds);
+}
+
+static double getSeconds() {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
+void OpenMPTuner::link(Log&l,const std::string&n) {
+  log=&l;
+  name=n;
+}
 
+unsigned OpenMPTuner::workloadClass(unsigned long workload)const {
+  unsigned c=0;
+  while(workload>1) {
+    workload/=2;
+    c++;
+  }
+  return c;
 }
 
+unsigned OpenMPTuner::begin(unsigned long workload,unsigned suggested) {
+  current=nullptr;
+  const unsigned maxnt=OpenMP::getNumThreads();
+  if(!OpenMP::getAutotune() || maxnt==1) return suggested;
+  const unsigned c=workloadClass(workload);
+  Tuning & t(tunings[c]);
+  if(t.candidates.empty()) {
+    t.workload_class=c;
+    for(unsigned nt=1; nt<maxnt; nt*=2) t.candidates.push_back(nt);
+    t.candidates.push_back(maxnt);
+    t.times.assign(t.candidates.size(),-1.0);
+  }
+  if(t.ncalls>=ntrials*t.candidates.size()) return t.chosen;
+// candidates are alternated, so that slow drifts in the timings affect all of them
+  current=&t;
+  current_nt=t.candidates[t.ncalls%t.candidates.size()];
+  start=getSeconds();
+  return current_nt;
+}
 
+void OpenMPTuner::end() {
+  if(!current) return;
+  const double elapsed=getSeconds()-start;
+  Tuning & t(*current);
+  current=nullptr;
+  const unsigned i=t.ncalls%t.candidates.size();
+  if(t.times[i]<0.0 || elapsed<t.times[i]) t.times[i]=elapsed;
+  t.ncalls++;
+  if(t.ncalls<ntrials*t.candidates.size()) return;
+  unsigned best=0;
+  for(unsigned j=1; j<t.candidates.size(); j++) if(t.times[j]<t.times[best]) best=j;
+  t.chosen=t.candidates[best];
+  if(log) {
+    log->printf("  OpenMP autotuning of %s: workload of order 2^%u, using %u threads (",name.c_str(),t.workload_class,t.chosen);
+    for(unsigned j=0; j<t.candidates.size(); j++) log->printf(" %u:%g",t.candidates[j],t.times[j]);
+    log->printf(" seconds )\n");
+  }
+}
 
+}
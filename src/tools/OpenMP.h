@@ -22,10 +22,14 @@
 #ifndef __PLUMED_tools_OpenMP_h
 #define __PLUMED_tools_OpenMP_h
 
+#include <map>
+#include <string>
 #include <vector>
 
 namespace PLMD {
 
+class Log;
+
 class OpenMP {
 
 public:
@@ -50,6 +54,61 @@ public:
   template<typename T>
   static unsigned getGoodNumThreads(const std::vector<T> & v);
 
+/// Returns true if the number of threads of the parallel regions should be tuned
+/// at runtime (environment variable PLUMED_OPENMP_AUTOTUNE set to yes)
+  static bool getAutotune();
+
+/// Enable or disable autotuning
+  static void setAutotune(bool);
+
+/// Split a list of tasks with the given costs in nblocks contiguous blocks with approximately
+/// the same total cost. Block b contains tasks bounds[b] to bounds[b+1]-1.
+  static void getBalancedBlocks(const std::vector<double>& cost,unsigned nblocks,std::vector<unsigned>& bounds);
+
+/// Split the rows of the strict upper triangle of a n x n matrix (row i contains the n-1-i pairs (i,j) with j>i)
+/// in nblocks contiguous blocks of rows with approximately the same number of pairs.
+  static void getTriangularBlocks(unsigned n,unsigned nblocks,std::vector<unsigned>& bounds);
+
+};
+
+/// \ingroup TOOLBOX
+/// Chooses the number of threads of a parallel region by timing it.
+/// When autotuning is disabled, begin() just returns the number of threads suggested by the caller.
+/// Otherwise the region is run with 1, 2, 4, ... threads up to OpenMP::getNumThreads(),
+/// a few times each, and the fastest choice is kept.
+/// The workload is split in classes of sizes differing by a factor two,
+/// and the tuning is repeated when a new class is found.
+/// \verbatim
+/// unsigned nt=tuner.begin(n,n<10*OpenMP::getNumThreads()?1:OpenMP::getNumThreads());
+/// #pragma omp parallel num_threads(nt)
+/// { ... }
+/// tuner.end();
+/// \endverbatim
+class OpenMPTuner {
+  struct Tuning {
+    std::vector<unsigned> candidates;
+    std::vector<double> times;
+    unsigned workload_class=0;
+    unsigned ncalls=0;
+    unsigned chosen=0;
+  };
+  Log* log=nullptr;
+  std::string name;
+  std::map<unsigned,Tuning> tunings;
+  Tuning* current=nullptr;
+  unsigned current_nt=1;
+  double start=0.0;
+  unsigned workloadClass(unsigned long workload)const;
+public:
+/// Number of times each candidate is timed. The shortest time is used
+  static const unsigned ntrials=3;
+/// Set the log where decisions are written and the name used there
+  void link(Log&,const std::string&);
+/// Number of threads to be used for the next execution of the region.
+/// suggested is the number of threads that would be used without autotuning
+  unsigned begin(unsigned long workload,unsigned suggested);
+/// To be called after the region
+  void end();
 };
 
 template<typename T>
@@ -27,6 +27,9 @@
 #include <iostream>
 #include "core/GenericMolInfo.h"
 #include "Tensor.h"
+#include "OpenMP.h"
+#include <cstdlib>
+#include <cstring>
 
 //+PLUMEDOC INTERNAL pdbreader
 /*
@@ -281,34 +284,134 @@ unsigned PDB::size()const {
   return positions.size();
 }
 
+namespace {
+
+/// Convert a fixed-width column without building a std::string.
+/// Returns false if the field is not a plain number, in which case
+/// the caller should fall back to Tools::convert.
+bool convertField(const char* field,unsigned width,double & d) {
+  char buffer[32];
+  if(width>=sizeof(buffer)) return false;
+  std::memcpy(buffer,field,width);
+  buffer[width]='\0';
+  char* endptr;
+  d=std::strtod(buffer,&endptr);
+  if(endptr==buffer) return false;
+  for(; *endptr; ++endptr) if(*endptr!=' ' && *endptr!='\t') return false;
+  return true;
+}
+
+bool convertField(const char* field,unsigned width,unsigned & u) {
+  char buffer[32];
+  if(width>=sizeof(buffer)) return false;
+  std::memcpy(buffer,field,width);
+  buffer[width]='\0';
+  char* endptr;
+  long l=std::strtol(buffer,&endptr,10);
+  if(endptr==buffer || l<0) return false;
+  for(; *endptr; ++endptr) if(*endptr!=' ' && *endptr!='\t') return false;
+  u=l;
+  return true;
+}
+
+template<typename T>
+void convertColumn(const std::string & line,unsigned start,unsigned width,T & t) {
+  if(!convertField(line.c_str()+start,width,t)) Tools::convert(line.substr(start,width),t);
+}
+
+}
+
+void PDB::parseAtomRecords(const std::vector<std::string>& lines,double scale) {
+  const unsigned nold=positions.size();
+  const unsigned n=lines.size();
+  numbers.resize(nold+n);
+  atomsymb.resize(nold+n);
+  residue.resize(nold+n);
+  chain.resize(nold+n);
+  occupancy.resize(nold+n);
+  beta.resize(nold+n);
+  positions.resize(nold+n);
+  residuenames.resize(nold+n);
+
+// lines are independent, so large blocks are parsed in parallel
+  unsigned nt=OpenMP::getNumThreads();
+  if(n<1000) nt=1;
+  std::string errmsg;
+  #pragma omp parallel for num_threads(nt)
+  for(unsigned i=0; i<n; i++) {
+    const std::string & line(lines[i]);
+    const unsigned k=nold+i;
+    {
+      int result;
+      auto trimmed=line.substr(6,5);
+      Tools::trim(trimmed);
+      while(trimmed.length()<5) trimmed = std::string(" ") + trimmed;
+      const char* err = h36::hy36decode(5, trimmed.c_str(),trimmed.length(), &result);
+      if(err) {
+        #pragma omp critical
+        if(errmsg.length()==0) errmsg=err;
+        continue;
+      }
+      numbers[k].setSerial(result);
+    }
+    convertColumn(line,22,4,residue[k]);
+    convertColumn(line,54,6,occupancy[k]);
+    convertColumn(line,60,6,beta[k]);
+    Vector & p(positions[k]);
+    convertColumn(line,30,8,p[0]);
+    convertColumn(line,38,8,p[1]);
+    convertColumn(line,46,8,p[2]);
+    // scale into nm
+    p*=scale;
+    std::size_t startpos=line.find_first_not_of(" \t",12);
+    std::size_t endpos=line.find_last_not_of(" \t",15);
+    if(startpos<=15 && endpos>=12) atomsymb[k]=line.substr(startpos, endpos-startpos+1);
+    else atomsymb[k]="";
+    chain[k]=line.substr(21,1);
+    residuenames[k]=line.substr(17,3);
+  }
+  if(errmsg.length()>0) plumed_merror(errmsg);
+
+  for(unsigned i=0; i<n; i++) number2index[numbers[nold+i]]=nold+i;
+}
+
+void PDB::buildIndexes() {
+  residue2index.clear();
+  chain2index.clear();
+  for(unsigned i=0; i<residue.size(); ++i) {
+    residue2index[residue[i]].push_back(i);
+    chain2index[chain[i]].push_back(i);
+  }
+}
+
 bool PDB::readFromFilepointer(FILE *fp,bool naturalUnits,double scale) {
   //cerr<<file<<endl;
   bool file_is_alive=false;
   if(naturalUnits) scale=1.0;
   std::string line;
   fpos_t pos; bool between_ters=true;
+// consecutive ATOM/HETATM records are accumulated here and parsed in blocks
+  std::vector<std::string> atomlines;
+  const unsigned maxblock=100000;
   while(Tools::getline(fp,line)) {
     //cerr<<line<<"\n";
     fgetpos (fp,&pos);
-    while(line.length()<80) line.push_back(' ');
+    if(line.length()<80) line.resize(80,' ');
     std::string record=line.substr(0,6);
-    std::string serial=line.substr(6,5);
-    std::string atomname=line.substr(12,4);
-    std::string residuename=line.substr(17,3);
-    std::string chainID=line.substr(21,1);
-    std::string resnum=line.substr(22,4);
-    std::string x=line.substr(30,8);
-    std::string y=line.substr(38,8);
-    std::string z=line.substr(46,8);
-    std::string occ=line.substr(54,6);
-    std::string bet=line.substr(60,6);
-    std::string BoxX=line.substr(6,9);
-    std::string BoxY=line.substr(15,9);
-    std::string BoxZ=line.substr(24,9);
-    std::string BoxA=line.substr(33,7);
-    std::string BoxB=line.substr(40,7);
-    std::string BoxG=line.substr(47,7);
     Tools::trim(record);
+    if(record=="ATOM" || record=="HETATM") {
+      between_ters=true;
+      atomlines.push_back(std::move(line));
+      if(atomlines.size()>=maxblock) {
+        parseAtomRecords(atomlines,scale);
+        atomlines.clear();
+      }
+      continue;
+    }
+    if(atomlines.size()>0) {
+      parseAtomRecords(atomlines,scale);
+      atomlines.clear();
+    }
     if(record=="TER") { between_ters=false; block_ends.push_back( positions.size() ); }
     if(record=="END") { file_is_alive=true;  break;}
     if(record=="ENDMDL") { file_is_alive=true;  break;}
@@ -317,12 +420,12 @@ bool PDB::readFromFilepointer(FILE *fp,bool naturalUnits,double scale) {
       addRemark( v1 );
     }
     if(record=="CRYST1") {
-      Tools::convert(BoxX,BoxXYZ[0]);
-      Tools::convert(BoxY,BoxXYZ[1]);
-      Tools::convert(BoxZ,BoxXYZ[2]);
-      Tools::convert(BoxA,BoxABG[0]);
-      Tools::convert(BoxB,BoxABG[1]);
-      Tools::convert(BoxG,BoxABG[2]);
+      Tools::convert(line.substr(6,9),BoxXYZ[0]);
+      Tools::convert(line.substr(15,9),BoxXYZ[1]);
+      Tools::convert(line.substr(24,9),BoxXYZ[2]);
+      Tools::convert(line.substr(33,7),BoxABG[0]);
+      Tools::convert(line.substr(40,7),BoxABG[1]);
+      Tools::convert(line.substr(47,7),BoxABG[2]);
       BoxXYZ*=scale;
       double cosA=cos(BoxABG[0]*pi/180.);
       double cosB=cos(BoxABG[1]*pi/180.);
@@ -336,46 +439,10 @@ bool PDB::readFromFilepointer(FILE *fp,bool naturalUnits,double scale) {
       Box[2][1]=(BoxXYZ[2]*BoxXYZ[1]*cosA-Box[2][0]*Box[1][0])/Box[1][1];
       Box[2][2]=std::sqrt(BoxXYZ[2]*BoxXYZ[2]-Box[2][0]*Box[2][0]-Box[2][1]*Box[2][1]);
     }
-    if(record=="ATOM" || record=="HETATM") {
-      between_ters=true;
-      AtomNumber a; unsigned resno;
-      double o,b;
-      Vector p;
-      {
-        int result;
-        auto trimmed=serial;
-        Tools::trim(trimmed);
-        while(trimmed.length()<5) trimmed = std::string(" ") + trimmed;
-        const char* errmsg = h36::hy36decode(5, trimmed.c_str(),trimmed.length(), &result);
-        if(errmsg) {
-          std::string msg(errmsg);
-          plumed_merror(msg);
-        }
-        a.setSerial(result);
-      }
-
-      Tools::convert(resnum,resno);
-      Tools::convert(occ,o);
-      Tools::convert(bet,b);
-      Tools::convert(x,p[0]);
-      Tools::convert(y,p[1]);
-      Tools::convert(z,p[2]);
-      // scale into nm
-      p*=scale;
-      numbers.push_back(a);
-      number2index[a]=positions.size();
-      std::size_t startpos=atomname.find_first_not_of(" \t");
-      std::size_t endpos=atomname.find_last_not_of(" \t");
-      atomsymb.push_back( atomname.substr(startpos, endpos-startpos+1) );
-      residue.push_back(resno);
-      chain.push_back(chainID);
-      occupancy.push_back(o);
-      beta.push_back(b);
-      positions.push_back(p);
-      residuenames.push_back(residuename);
-    }
   }
+  if(atomlines.size()>0) parseAtomRecords(atomlines,scale);
   if( between_ters ) block_ends.push_back( positions.size() );
+  buildIndexes();
   return file_is_alive;
 }
 
@@ -396,52 +463,37 @@ void PDB::getChainNames( std::vector<std::string>& chains ) const {
 }
 
 void PDB::getResidueRange( const std::string& chainname, unsigned& res_start, unsigned& res_end, std::string& errmsg ) const {
-  bool inres=false, foundchain=false;
-  for(unsigned i=0; i<size(); ++i) {
-    if( chain[i]==chainname ) {
-      if(!inres) {
-        if(foundchain) errmsg="found second start of chain named " + chainname;
-        res_start=residue[i];
-      }
-      inres=true; foundchain=true;
-    } else if( inres && chain[i]!=chainname ) {
-      inres=false;
-      res_end=residue[i-1];
-    }
-  }
-  if(inres) res_end=residue[size()-1];
+  const auto p=chain2index.find(chainname);
+  if(p==chain2index.end()) return;
+  const std::vector<unsigned> & ind(p->second);
+  // atoms are stored in file order, so the chain is contiguous only if there are no gaps
+  if( ind.back()-ind.front()+1!=ind.size() ) errmsg="found second start of chain named " + chainname;
+  res_start=residue[ind.front()];
+  res_end=residue[ind.back()];
 }
 
 void PDB::getAtomRange( const std::string& chainname, AtomNumber& a_start, AtomNumber& a_end, std::string& errmsg ) const {
-  bool inres=false, foundchain=false;
-  for(unsigned i=0; i<size(); ++i) {
-    if( chain[i]==chainname ) {
-      if(!inres) {
-        if(foundchain) errmsg="found second start of chain named " + chainname;
-        a_start=numbers[i];
-      }
-      inres=true; foundchain=true;
-    } else if( inres && chain[i]!=chainname ) {
-      inres=false;
-      a_end=numbers[i-1];
-    }
-  }
-  if(inres) a_end=numbers[size()-1];
+  const auto p=chain2index.find(chainname);
+  if(p==chain2index.end()) return;
+  const std::vector<unsigned> & ind(p->second);
+  if( ind.back()-ind.front()+1!=ind.size() ) errmsg="found second start of chain named " + chainname;
+  a_start=numbers[ind.front()];
+  a_end=numbers[ind.back()];
 }
 
 std::string PDB::getResidueName( const unsigned& resnum ) const {
-  for(unsigned i=0; i<size(); ++i) {
-    if( residue[i]==resnum ) return residuenames[i];
-  }
+  const auto p=residue2index.find(resnum);
+  if(p!=residue2index.end()) return residuenames[p->second[0]];
   std::string num; Tools::convert( resnum, num );
   plumed_merror("residue " + num + " not found" );
   return "";
 }
 
 std::string PDB::getResidueName(const unsigned& resnum,const std::string& chainid ) const {
-  for(unsigned i=0; i<size(); ++i) {
-    if( residue[i]==resnum && ( chainid=="*" || chain[i]==chainid) ) return residuenames[i];
-  }
+  const auto p=residue2index.find(resnum);
+  if(p!=residue2index.end()) for(const auto & i : p->second) {
+      if( chainid=="*" || chain[i]==chainid ) return residuenames[i];
+    }
   std::string num; Tools::convert( resnum, num );
   plumed_merror("residue " + num + " not found in chain " + chainid );
   return "";
@@ -449,18 +501,20 @@ std::string PDB::getResidueName(const unsigned& resnum,const std::string& chaini
 
 
 AtomNumber PDB::getNamedAtomFromResidue( const std::string& aname, const unsigned& resnum ) const {
-  for(unsigned i=0; i<size(); ++i) {
-    if( residue[i]==resnum && atomsymb[i]==aname ) return numbers[i];
-  }
+  const auto p=residue2index.find(resnum);
+  if(p!=residue2index.end()) for(const auto & i : p->second) {
+      if( atomsymb[i]==aname ) return numbers[i];
+    }
   std::string num; Tools::convert( resnum, num );
   plumed_merror("residue " + num + " does not contain an atom named " + aname );
   return numbers[0]; // This is to stop compiler errors
 }
 
 AtomNumber PDB::getNamedAtomFromResidueAndChain( const std::string& aname, const unsigned& resnum, const std::string& chainid ) const {
-  for(unsigned i=0; i<size(); ++i) {
-    if( residue[i]==resnum && atomsymb[i]==aname && ( chainid=="*" || chain[i]==chainid) ) return numbers[i];
-  }
+  const auto p=residue2index.find(resnum);
+  if(p!=residue2index.end()) for(const auto & i : p->second) {
+      if( atomsymb[i]==aname && ( chainid=="*" || chain[i]==chainid) ) return numbers[i];
+    }
   std::string num; Tools::convert( resnum, num );
   plumed_merror("residue " + num + " from chain " + chainid + " does not contain an atom named " + aname );
   return numbers[0]; // This is to stop compiler errors
@@ -468,9 +522,10 @@ AtomNumber PDB::getNamedAtomFromResidueAndChain( const std::string& aname, const
 
 std::vector<AtomNumber> PDB::getAtomsInResidue(const unsigned& resnum,const std::string& chainid)const {
   std::vector<AtomNumber> tmp;
-  for(unsigned i=0; i<size(); ++i) {
-    if( residue[i]==resnum && ( chainid=="*" || chain[i]==chainid) ) tmp.push_back(numbers[i]);
-  }
+  const auto p=residue2index.find(resnum);
+  if(p!=residue2index.end()) for(const auto & i : p->second) {
+      if( chainid=="*" || chain[i]==chainid ) tmp.push_back(numbers[i]);
+    }
   if(tmp.size()==0) {
     std::string num; Tools::convert( resnum, num );
     plumed_merror("Cannot find residue " + num + " from chain " + chainid  );
@@ -480,8 +535,10 @@ std::vector<AtomNumber> PDB::getAtomsInResidue(const unsigned& resnum,const std:
 
 std::vector<AtomNumber> PDB::getAtomsInChain(const std::string& chainid)const {
   std::vector<AtomNumber> tmp;
-  for(unsigned i=0; i<size(); ++i) {
-    if( chainid=="*" || chain[i]==chainid ) tmp.push_back(numbers[i]);
+  if( chainid=="*" ) tmp=numbers;
+  else {
+    const auto p=chain2index.find(chainid);
+    if(p!=chain2index.end()) for(const auto & i : p->second) tmp.push_back(numbers[i]);
   }
   if(tmp.size()==0) {
     plumed_merror("Cannot find atoms from chain " + chainid  );
@@ -490,9 +547,8 @@ std::vector<AtomNumber> PDB::getAtomsInChain(const std::string& chainid)const {
 }
 
 std::string PDB::getChainID(const unsigned& resnumber) const {
-  for(unsigned i=0; i<size(); ++i) {
-    if(resnumber==residue[i]) return chain[i];
-  }
+  const auto p=residue2index.find(resnumber);
+  if(p!=residue2index.end()) return chain[p->second[0]];
   plumed_merror("Not enough residues in pdb input file");
 }
 
@@ -27,6 +27,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include "Tensor.h"
 
 
@@ -48,6 +49,10 @@ class PDB {
   std::vector<double> beta;
   std::vector<AtomNumber> numbers;
   std::map<AtomNumber,unsigned> number2index;
+/// Indexes of the atoms belonging to each residue number, in file order
+  std::unordered_map<unsigned,std::vector<unsigned> > residue2index;
+/// Indexes of the atoms belonging to each chain, in file order
+  std::unordered_map<std::string,std::vector<unsigned> > chain2index;
   std::vector<std::string> residuenames;
   std::string mtype;
   std::vector<std::string> flags;
@@ -55,6 +60,10 @@ class PDB {
   std::map<std::string,double> arg_data;
   Vector BoxXYZ,BoxABG;
   Tensor Box;
+/// Parse a block of ATOM/HETATM records and append them
+  void parseAtomRecords(const std::vector<std::string>& lines,double scale);
+/// Rebuild the residue and chain lookup tables
+  void buildIndexes();
 public:
 /// Read the pdb from a file, scaling positions by a factor scale
   bool read(const std::string&file,bool naturalUnits,double scale);
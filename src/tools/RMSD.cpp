@@ -25,11 +25,13 @@
 #include "Exception.h"
 #include <cmath>
 #include <iostream>
+#include <limits>
 #include "Tools.h"
 
 namespace PLMD {
 
-RMSD::RMSD() : alignmentMethod(SIMPLE),reference_center_is_calculated(false),reference_center_is_removed(false),positions_center_is_calculated(false),positions_center_is_removed(false) {}
+RMSD::RMSD() : alignmentMethod(SIMPLE),reference_center_is_calculated(false),reference_center_is_removed(false),positions_center_is_calculated(false),positions_center_is_removed(false),
+  rotationCacheEpsilon(-1.0),rotationCacheReuse(false),rotationCacheValid(false) {}
 
 ///
 /// general method to set all the rmsd property at once by using a pdb where occupancy column sets the weights for the atoms involved in the
@@ -75,6 +77,35 @@ void RMSD::clear() {
   positions_center.zero();
   positions_center_is_calculated=false;
   positions_center_is_removed=false;
+  rotationCacheValid=false;
+}
+
+void RMSD::setRotationCache(double epsilon) {
+  rotationCacheEpsilon=epsilon;
+  rotationCacheValid=false;
+  rotationCachePositions.clear();
+}
+
+///
+/// Performs the core calculation. When the rotation cache is enabled, reuse is allowed and the positions are
+/// within rotationCacheEpsilon from the ones of the last full alignment, the cached rotation is used
+/// instead of diagonalizing the quaternion matrix. Only the distance is accurate in this case (its error is
+/// second order in the rotation error), so reuse should be allowed only when the derivatives are not used.
+///
+void RMSD::doCoreCalcWithRotationCache(RMSDCoreData & cd, bool safe, bool alEqDis) const {
+  if(rotationCacheEpsilon<=0.0) {
+    cd.doCoreCalc(safe,alEqDis);
+    return;
+  }
+  if(rotationCacheReuse && rotationCacheValid && cd.getCenteredPositionsDrift(rotationCachePositions)<rotationCacheEpsilon) {
+    cd.doCoreCalcWithCachedRotation(alEqDis,rotationCacheRotation);
+    return;
+  }
+  // too far (or first time): full alignment, which becomes the new close structure
+  cd.doCoreCalc(safe,alEqDis);
+  rotationCacheRotation=cd.getRotationMatrixReferenceToPositions();
+  rotationCachePositions=cd.getCenteredPositions();
+  rotationCacheValid=true;
 }
 
 std::string RMSD::getMethod() {
@@ -91,6 +122,7 @@ std::string RMSD::getMethod() {
 /// considering uniform weights for alignment
 ///
 void RMSD::setReference(const std::vector<Vector> & reference) {
+  rotationCacheValid=false;
   unsigned n=reference.size();
   this->reference=reference;
   plumed_massert(align.empty(),"you should first clear() an RMSD object, then set a new reference");
@@ -110,6 +142,7 @@ std::vector<Vector> RMSD::getReference() {
 /// the alignment weights are here normalized to 1 and  the center of the reference is removed accordingly
 ///
 void RMSD::setAlign(const std::vector<double> & align, bool normalize_weights, bool remove_center) {
+  rotationCacheValid=false;
   unsigned n=reference.size();
   plumed_massert(this->align.size()==align.size(),"mismatch in dimension of align/displace arrays");
   this->align=align;
@@ -429,6 +462,20 @@ double RMSD::optimalAlignment(const  std::vector<double>  & align,
                               const std::vector<Vector> & positions,
                               const std::vector<Vector> & reference,
                               std::vector<Vector>  & derivatives, bool squared)const {
+  if(rotationCacheEpsilon>0.0) {
+    // the cached rotation is handled through the core data structure
+    RMSDCoreData cd(align,displace,positions,reference);
+    cd.setPositionsCenterIsRemoved(positions_center_is_removed);
+    if(positions_center_is_calculated) {cd.setPositionsCenter(positions_center);}
+    else {cd.calcPositionsCenter();};
+    cd.setReferenceCenterIsRemoved(reference_center_is_removed);
+    if(!reference_center_is_calculated) {cd.calcReferenceCenter();}
+    else {cd.setReferenceCenter(reference_center);}
+    doCoreCalcWithRotationCache(cd,safe,alEqDis);
+    double dist=cd.getDistance(squared);
+    derivatives=cd.getDDistanceDPositions();
+    return dist;
+  }
   const unsigned n=reference.size();
 // This is the trace of positions*positions + reference*reference
   double rr00(0);
@@ -633,7 +680,7 @@ double RMSD::optimalAlignment(const  std::vector<double>  & align,
   else {cd.setReferenceCenter(reference_center);}
 
   // Perform the diagonalization and all the needed stuff
-  cd.doCoreCalc(safe,alEqDis);
+  doCoreCalcWithRotationCache(cd,safe,alEqDis);
   // make the core calc distance
   double dist=cd.getDistance(squared);
 //  make the derivatives by using pieces calculated in coreCalc (probably the best is just to copy the vector...)
@@ -1141,6 +1188,46 @@ double RMSDCoreData::getDistance( bool squared) {
   return dist;
 }
 
+void RMSDCoreData::doCoreCalcWithCachedRotation(bool alEqDis, const Tensor & rot) {
+
+  retrieve_only_rotation=false;
+  const unsigned n=static_cast<unsigned int>(reference.size());
+
+  plumed_massert(creference_is_calculated,"the center of the reference frame must be already provided at this stage");
+  plumed_massert(cpositions_is_calculated,"the center of the positions frame must be already provided at this stage");
+
+  Vector cp; cp.zero(); if(!cpositions_is_removed)cp=cpositions;
+  Vector cr; cr.zero(); if(!creference_is_removed)cr=creference;
+
+  // no diagonalization: the rotation is the one of the close structure
+  rotation=rot;
+
+  d.resize(n);
+  #pragma omp simd
+  for(unsigned iat=0; iat<n; iat++) d[iat]=positions[iat]-cp - matmul(rotation,reference[iat]-cr);
+
+  // the dependence of the rotation on the positions is not known here,
+  // so the derivatives would only be approximate and they are not computed
+  for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) drotation_drr01[i][j].zero();
+  ddist_drotation.zero();
+  ddist_drr01.zero();
+
+  this->alEqDis=alEqDis;
+  // eigenvalues are not available, so the distance must be computed from the components
+  this->safe=true;
+  isInitialized=true;
+}
+
+double RMSDCoreData::getCenteredPositionsDrift(const std::vector<Vector> & centeredpositions) const {
+  const unsigned n=static_cast<unsigned int>(positions.size());
+  plumed_massert(cpositions_is_calculated,"the center of the positions frame must be already provided at this stage");
+  if(centeredpositions.size()!=n) return std::numeric_limits<double>::max();
+  double drift=0.0;
+  #pragma omp simd reduction(+:drift)
+  for(unsigned iat=0; iat<n; iat++) drift+=align[iat]*modulo2(positions[iat]-cpositions-centeredpositions[iat]);
+  return std::sqrt(drift);
+}
+
 void RMSDCoreData::doCoreCalcWithCloseStructure(bool safe,bool alEqDis, Tensor & rotationPosClose, Tensor & rotationRefClose, std::array<std::array<Tensor,3>,3> & drotationPosCloseDrr01) {
 
   unsigned natoms = reference.size();
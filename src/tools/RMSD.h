@@ -33,6 +33,7 @@ namespace PLMD {
 
 class Log;
 class PDB;
+class RMSDCoreData;
 
 /** \ingroup TOOLBOX
 A class that implements RMSD calculations
@@ -79,6 +80,14 @@ class RMSD
   Vector positions_center;
   bool positions_center_is_calculated;
   bool positions_center_is_removed;
+// Rotation cache used to skip the optimal alignment when only the distance is needed (see setRotationCache)
+  double rotationCacheEpsilon;
+  bool rotationCacheReuse;
+  mutable bool rotationCacheValid;
+  mutable std::vector<Vector> rotationCachePositions;
+  mutable Tensor rotationCacheRotation;
+// does the core calc, reusing the cached rotation when allowed and the positions are close to the cached ones
+  void doCoreCalcWithRotationCache(RMSDCoreData & cd, bool safe, bool alEqDis) const;
 // calculates the center from the position provided
   Vector calculateCenter(std::vector<Vector> &p,std::vector<double> &w) {
     plumed_massert(p.size()==w.size(),"mismatch in dimension of position/align arrays while calculating the center");
@@ -117,6 +126,15 @@ public:
   std::vector<double> getDisplace();
 ///
   std::string getMethod();
+/// enable the rotation cache: the optimal rotation of the last full alignment is stored, and it is
+/// reused when allowed by setRotationCacheReuse() and the centered positions moved less than epsilon
+/// (weighted RMSD, no realignment) from those of the last full alignment. Since the distance is minimal
+/// with respect to the rotation, its error is second order in the rotation error, whereas derivatives
+/// and rotated positions have first order errors. A non positive epsilon disables it.
+  void setRotationCache(double epsilon);
+  double getRotationCacheEpsilon() const {return rotationCacheEpsilon;}
+/// allow the cached rotation to be reused: this should be set only when the derivatives are not used
+  void setRotationCacheReuse(bool reuse) {rotationCacheReuse=reuse;}
 /// workhorses
   double simpleAlignment(const  std::vector<double>  & align,
                          const  std::vector<double>  & displace,
@@ -331,6 +349,11 @@ public:
   //  does the core calc : first thing to call after the constructor:
   // only_rotation=true does not retrieve the derivatives, just retrieve the optimal rotation (the same calc cannot be exploit further)
   void doCoreCalc(bool safe,bool alEqDis, bool only_rotation=false);
+  // do calculation reusing the rotation of a close structure: only the distance should be retrieved,
+  // and it is always computed explicitly from the components (as in safe mode)
+  void doCoreCalcWithCachedRotation(bool alEqDis, const Tensor & rotation);
+  // weighted RMSD (without alignment) between the centered positions and the provided centered positions
+  double getCenteredPositionsDrift(const std::vector<Vector> & centeredpositions) const;
   // do calculation with close structure data structures
   void doCoreCalcWithCloseStructure(bool safe,bool alEqDis, Tensor & rotationPosClose, Tensor & rotationRefClose, std::array<std::array<Tensor,3>,3> & drotationPosCloseDrr01);
   // retrieve the distance if required after doCoreCalc
@@ -168,6 +168,19 @@ removed in the future. Similarly, the STRETCH keyword is still allowed but has n
 Notice that switching functions defined with the simplified syntax are never stretched
 for backward compatibility. This might change in the future.
 
+When a D_MAX is given, the switching function can also be precomputed on a table
+by adding the parameter TABLE to its definition.  For instance
+\verbatim
+KEYWORD={RATIONAL R_0=0.5 NN=8 MM=16 D_MAX=1.5 TABLE=2000}
+\endverbatim
+will tabulate the function and its derivative on 2000 equally spaced intervals of the squared distance
+between zero and \f$d_{\textrm{max}}^2\f$.  The function is then evaluated by cubic Hermite interpolation,
+which avoids square roots, powers and exponentials and makes all the switching functions (including CUSTOM ones)
+as cheap as a table lookup.  The maximum interpolation error is estimated when the table is
+built and is reported in the log together with the description of the function, so that the number of
+points can be increased if the accuracy is not sufficient.  Functions that are not smooth in \f$r^2\f$
+at the origin (e.g. EXP with D_0=0) are poorly represented close to \f$r=0\f$ and require more points.
+
 */
 //+ENDPLUMEDOC
 
@@ -206,6 +219,11 @@ void SwitchingFunction::set(const std::string & definition,std::string& errormsg
   present=Tools::findKeyword(data,"D_MAX");
   if(present && !Tools::parse(data,"D_MAX",dmax)) errormsg="could not parse D_MAX";
   if(dmax<std::sqrt(std::numeric_limits<double>::max())) dmax_2=dmax*dmax;
+  unsigned ntable=0;
+  tabulated=false;
+  present=Tools::findKeyword(data,"TABLE");
+  if(present && !Tools::parse(data,"TABLE",ntable)) errormsg="could not parse TABLE";
+  if(ntable>0 && dmax==std::numeric_limits<double>::max()) errormsg="TABLE can only be used when D_MAX is given";
   bool dostretch=false;
   Tools::parseFlag(data,"STRETCH",dostretch); // this is ignored now
   dostretch=true;
@@ -313,6 +331,37 @@ void SwitchingFunction::set(const std::string & definition,std::string& errormsg
   }
   plumed_assert(!(leptonx2 && d0!=0.0)) << "You cannot use lepton x2 optimization with d0!=0.0 (d0=" << d0 <<")\n"
                                         << "Please rewrite your function using x as a variable";
+  if(ntable>0 && errormsg.empty()) buildTable(ntable);
+}
+
+void SwitchingFunction::buildTable(unsigned n) {
+  plumed_assert(n>0 && dmax_2<std::numeric_limits<double>::max());
+  tabulated=false;
+  const double delta=dmax_2/n;
+  table.resize(2*(n+2));
+  for(unsigned i=0; i<=n; i++) {
+    double df;
+    table[2*i]=calculateSqr(i*delta,df);
+// calculateSqr returns 2*ds/dr^2, the table stores ds/dr^2 in units of the spacing
+    table[2*i+1]=0.5*df*delta;
+  }
+// padding so that distance2==dmax_2 can be interpolated without a further check
+  table[2*(n+1)]=table[2*n];
+  table[2*(n+1)+1]=table[2*n+1];
+  table_invdelta=1.0/delta;
+// the largest error of a cubic Hermite interpolant is usually found close to the center of each interval
+  double maxerr=0.0;
+  for(unsigned i=0; i<n; i++) {
+    double df;
+    double exact=calculateSqr((i+0.5)*delta,df);
+    tabulated=true;
+    double dtab;
+    double approx=calculateSqr((i+0.5)*delta,dtab);
+    tabulated=false;
+    maxerr=std::max(maxerr,std::fabs(exact-approx));
+  }
+  table_error=maxerr;
+  tabulated=true;
 }
 
 std::string SwitchingFunction::description() const {
@@ -352,6 +401,7 @@ std::string SwitchingFunction::description() const {
     ostr<<" func="<<lepton_func;
 
   }
+  if(tabulated) ostr<<" tabulated with "<<table.size()/2-2<<" intervals (max error "<<table_error<<")";
   return ostr.str();
 }
 
@@ -365,8 +415,8 @@ double SwitchingFunction::do_rational(double rdist,double&dfunc,int nn,int mm)co
     result = iden;
   } else {
     if(rdist>(1.-100.0*epsilon) && rdist<(1+100.0*epsilon)) {
-      result=nn/mm;
-      dfunc=0.5*nn*(nn-mm)/mm;
+      result=static_cast<double>(nn)/mm;
+      dfunc=0.5*nn*(nn-mm)/static_cast<double>(mm);
     } else {
       double rNdist=Tools::fastpow(rdist,nn-1);
       double rMdist=Tools::fastpow(rdist,mm-1);
@@ -381,7 +431,28 @@ double SwitchingFunction::do_rational(double rdist,double&dfunc,int nn,int mm)co
 }
 
 double SwitchingFunction::calculateSqr(double distance2,double&dfunc)const {
-  if(fastrational) {
+  if(tabulated) {
+    if(distance2>dmax_2) {
+      dfunc=0.0;
+      return 0.0;
+    }
+    const double x=distance2*table_invdelta;
+    const unsigned i=static_cast<unsigned>(x);
+    const double t=x-i;
+    const double* p=&table[2*i];
+// cubic Hermite interpolation between nodes i and i+1
+    const double t2=t*t;
+    const double t3=t2*t;
+    const double h00=2*t3-3*t2+1;
+    const double h10=t3-2*t2+t;
+    const double h01=-2*t3+3*t2;
+    const double h11=t3-t2;
+    const double dh00=6*t2-6*t;
+    const double dh10=3*t2-4*t+1;
+    const double dh11=3*t2-2*t;
+    dfunc=2*table_invdelta*(dh00*(p[0]-p[2])+dh10*p[1]+dh11*p[3]);
+    return h00*p[0]+h10*p[1]+h01*p[2]+h11*p[3];
+  } else if(fastrational) {
     if(distance2>dmax_2) {
       dfunc=0.0;
       return 0.0;
@@ -426,7 +497,7 @@ double SwitchingFunction::calculate(double distance,double&dfunc)const {
   }
 // in this case, the lepton object stores only the calculateSqr function
 // so we have to implement calculate in terms of calculateSqr
-  if(leptonx2) {
+  if(leptonx2 || tabulated) {
     return calculateSqr(distance*distance,dfunc);
   }
   const double rdist = (distance-d0)*invr0;
@@ -510,6 +581,7 @@ void SwitchingFunction::set(int nn,int mm,double r0,double d0) {
   this->dmax=d0+r0*std::pow(0.00001,1./(nn-mm));
   this->dmax_2=this->dmax*this->dmax;
   this->leptonx2=false;
+  this->tabulated=false;
   this->fastrational=(nn%2==0 && mm%2==0 && d0==0.0);
 
   double dummy;
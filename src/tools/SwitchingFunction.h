@@ -87,6 +87,17 @@ class SwitchingFunction {
   bool fastrational=false;
 /// Set to true if lepton only uses x2
   bool leptonx2=false;
+/// Set to true if the function is evaluated from a precomputed table
+  bool tabulated=false;
+/// Inverse of the spacing of the table (in units of squared distance)
+  double table_invdelta=0.0;
+/// Maximum interpolation error of the table, estimated at setup
+  double table_error=0.0;
+/// Tabulated values and derivatives with respect to the squared distance,
+/// stored interleaved as (s_0,ds_0,s_1,ds_1,...) for cubic Hermite interpolation
+  std::vector<double> table;
+/// Build a table with n intervals spanning squared distances in [0,dmax^2]
+  void buildTable(unsigned n);
 public:
   static void registerKeywords( Keywords& keys );
 /// Set a "rational" switching function.
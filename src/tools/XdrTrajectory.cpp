@@ -0,0 +1,850 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2021 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "XdrTrajectory.h"
+#include "Exception.h"
+#include "OpenMP.h"
+#include "Tools.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+namespace PLMD {
+
+namespace {
+
+const int xtcMagic=1995;
+/// xtc frames written by recent GROMACS versions, where the size of
+/// the compressed data is stored with 64 bits
+const int xtcMagicLarge=2023;
+const int trrMagic=1993;
+const char trrVersion[]="GMX_trn_file";
+
+// The compression algorithm of xtc files was written by Frans van Hoesel
+// as part of the Europort project in 1995. The implementation below
+// follows the one in the xdrfile library and in the molfile plugins,
+// and produces identical files.
+
+const int magicints[] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 10, 12, 16, 20, 25, 32, 40, 50, 64,
+  80, 101, 128, 161, 203, 256, 322, 406, 512, 645, 812, 1024, 1290,
+  1625, 2048, 2580, 3250, 4096, 5060, 6501, 8192, 10321, 13003, 16384,
+  20642, 26007, 32768, 41285, 52015, 65536, 82570, 104031, 131072,
+  165140, 208063, 262144, 330280, 416127, 524287, 660561, 832255,
+  1048576, 1321122, 1664510, 2097152, 2642245, 3329021, 4194304,
+  5284491, 6658042, 8388607, 10568983, 13316085, 16777216
+};
+
+const int firstidx=9;
+const int lastidx=sizeof(magicints)/sizeof(*magicints);
+
+/// Number of bits needed to store integers in [0,size)
+unsigned sizeofint(unsigned size) {
+  unsigned num=1;
+  unsigned nbits=0;
+  while(size>=num && nbits<32) {
+    nbits++;
+    num<<=1;
+  }
+  return nbits;
+}
+
+/// Number of bits needed to store three integers in [0,sizes[i]) as a single number
+unsigned sizeofints(const unsigned sizes[3]) {
+  unsigned bytes[32];
+  unsigned nbytes=1;
+  bytes[0]=1;
+  for(unsigned i=0; i<3; i++) {
+    unsigned tmp=0;
+    unsigned bytecnt;
+    for(bytecnt=0; bytecnt<nbytes; bytecnt++) {
+      tmp=bytes[bytecnt]*sizes[i]+tmp;
+      bytes[bytecnt]=tmp&0xff;
+      tmp>>=8;
+    }
+    while(tmp!=0) {
+      bytes[bytecnt++]=tmp&0xff;
+      tmp>>=8;
+    }
+    nbytes=bytecnt;
+  }
+  unsigned num=1;
+  unsigned nbits=0;
+  nbytes--;
+  while(bytes[nbytes]>=num) {
+    nbits++;
+    num*=2;
+  }
+  return nbits+nbytes*8;
+}
+
+unsigned getUnsigned(const unsigned char*p) {
+  return (unsigned(p[0])<<24) | (unsigned(p[1])<<16) | (unsigned(p[2])<<8) | unsigned(p[3]);
+}
+
+int getInt(const unsigned char*p) {
+  return int(getUnsigned(p));
+}
+
+/// Sequential access to xdr (big endian) data stored in memory
+class XdrInput {
+  const unsigned char* data;
+  size_t size;
+  size_t pos=0;
+  const unsigned char* get(size_t n) {
+    if(pos+n>size) plumed_merror("unexpected end of frame");
+    const unsigned char* p=data+pos;
+    pos+=n;
+    return p;
+  }
+public:
+  explicit XdrInput(const std::vector<unsigned char>&buf):
+    data(buf.data()),
+    size(buf.size())
+  {}
+  int getInt() {
+    return ::PLMD::getInt(get(4));
+  }
+  unsigned getUnsigned() {
+    return ::PLMD::getUnsigned(get(4));
+  }
+  uint64_t getUnsigned64() {
+    uint64_t hi=getUnsigned();
+    return (hi<<32) | getUnsigned();
+  }
+  float getFloat() {
+    uint32_t i=getUnsigned();
+    float f;
+    std::memcpy(&f,&i,4);
+    return f;
+  }
+  double getDouble() {
+    uint64_t i=getUnsigned64();
+    double d;
+    std::memcpy(&d,&i,8);
+    return d;
+  }
+  double getReal(unsigned prec) {
+    if(prec==sizeof(double)) return getDouble();
+    return getFloat();
+  }
+/// Opaque data, padded to a multiple of four bytes
+  const unsigned char* getOpaque(size_t n) {
+    const unsigned char* p=get(n);
+    get((4-n%4)%4);
+    return p;
+  }
+  void skip(size_t n) {
+    get(n);
+  }
+};
+
+/// Sequential writing of xdr (big endian) data
+class XdrOutput {
+  std::vector<unsigned char>&buf;
+public:
+  explicit XdrOutput(std::vector<unsigned char>&buf):
+    buf(buf)
+  {}
+  void putUnsigned(unsigned i) {
+    buf.push_back((i>>24)&0xff);
+    buf.push_back((i>>16)&0xff);
+    buf.push_back((i>>8)&0xff);
+    buf.push_back(i&0xff);
+  }
+  void putInt(int i) {
+    putUnsigned(unsigned(i));
+  }
+  void putFloat(float f) {
+    uint32_t i;
+    std::memcpy(&i,&f,4);
+    putUnsigned(i);
+  }
+  void putOpaque(const unsigned char*p,size_t n) {
+    buf.insert(buf.end(),p,p+n);
+    buf.insert(buf.end(),(4-n%4)%4,0);
+  }
+};
+
+/// Reading of the bit stream of compressed xtc coordinates
+class BitInput {
+  const unsigned char* data;
+  size_t size;
+  size_t cnt=0;
+  unsigned lastbits=0;
+  unsigned lastbyte=0;
+  unsigned next() {
+    if(cnt>=size) plumed_merror("corrupted xtc frame");
+    return data[cnt++];
+  }
+public:
+  BitInput(const unsigned char*data,size_t size):
+    data(data),
+    size(size)
+  {}
+  int receivebits(unsigned nbits) {
+    unsigned mask=(nbits<32 ? (1u<<nbits)-1 : 0xffffffffu);
+    unsigned num=0;
+    while(nbits>=8) {
+      lastbyte=(lastbyte<<8) | next();
+      num|=(lastbyte>>lastbits)<<(nbits-8);
+      nbits-=8;
+    }
+    if(nbits>0) {
+      if(lastbits<nbits) {
+        lastbits+=8;
+        lastbyte=(lastbyte<<8) | next();
+      }
+      lastbits-=nbits;
+      num|=(lastbyte>>lastbits) & ((1u<<nbits)-1);
+    }
+    return int(num&mask);
+  }
+  void receiveints(unsigned nbits,const unsigned sizes[3],int nums[3]) {
+    unsigned bytes[32];
+    unsigned nbytes=0;
+    bytes[1]=bytes[2]=bytes[3]=0;
+    while(nbits>8) {
+      bytes[nbytes++]=receivebits(8);
+      nbits-=8;
+    }
+    if(nbits>0) bytes[nbytes++]=receivebits(nbits);
+    for(unsigned i=2; i>0; i--) {
+      unsigned num=0;
+      for(int j=nbytes-1; j>=0; j--) {
+        num=(num<<8) | bytes[j];
+        unsigned p=num/sizes[i];
+        bytes[j]=p;
+        num=num-p*sizes[i];
+      }
+      nums[i]=num;
+    }
+    nums[0]=bytes[0] | (bytes[1]<<8) | (bytes[2]<<16) | (bytes[3]<<24);
+  }
+};
+
+/// Writing of the bit stream of compressed xtc coordinates
+class BitOutput {
+  std::vector<unsigned char> data;
+  unsigned cnt=0;
+  unsigned lastbits=0;
+  unsigned lastbyte=0;
+public:
+  explicit BitOutput(size_t size):
+    data(size+16)
+  {}
+  void sendbits(unsigned nbits,unsigned num) {
+    if(cnt+8>=data.size()) data.resize(2*data.size());
+    while(nbits>=8) {
+      lastbyte=(lastbyte<<8) | (num>>(nbits-8));
+      data[cnt++]=(lastbyte>>lastbits)&0xff;
+      nbits-=8;
+    }
+    if(nbits>0) {
+      lastbyte=(lastbyte<<nbits) | num;
+      lastbits+=nbits;
+      if(lastbits>=8) {
+        lastbits-=8;
+        data[cnt++]=(lastbyte>>lastbits)&0xff;
+      }
+    }
+    if(lastbits>0) data[cnt]=(lastbyte<<(8-lastbits))&0xff;
+  }
+  void sendints(unsigned nbits,const unsigned sizes[3],const unsigned nums[3]) {
+    unsigned bytes[32];
+    unsigned nbytes=0;
+    unsigned tmp=nums[0];
+    do {
+      bytes[nbytes++]=tmp&0xff;
+      tmp>>=8;
+    } while(tmp!=0);
+    for(unsigned i=1; i<3; i++) {
+      if(nums[i]>=sizes[i]) plumed_merror("major breakdown in xtc compression");
+      tmp=nums[i];
+      unsigned bytecnt;
+      for(bytecnt=0; bytecnt<nbytes; bytecnt++) {
+        tmp=bytes[bytecnt]*sizes[i]+tmp;
+        bytes[bytecnt]=tmp&0xff;
+        tmp>>=8;
+      }
+      while(tmp!=0) {
+        bytes[bytecnt++]=tmp&0xff;
+        tmp>>=8;
+      }
+      nbytes=bytecnt;
+    }
+    if(nbits>=nbytes*8) {
+      for(unsigned i=0; i<nbytes; i++) sendbits(8,bytes[i]);
+      sendbits(nbits-nbytes*8,0);
+    } else {
+      for(unsigned i=0; i<nbytes-1; i++) sendbits(8,bytes[i]);
+      sendbits(nbits-(nbytes-1)*8,bytes[nbytes-1]);
+    }
+  }
+/// Number of bytes written so far, including the last incomplete one
+  size_t getSize()const {
+    return cnt+(lastbits!=0 ? 1 : 0);
+  }
+  const unsigned char* getData()const {
+    return data.data();
+  }
+};
+
+void decodeXtcCoordinates(XdrInput&in,bool large,int natoms,double&precision,std::vector<double>&positions) {
+  int lsize=in.getInt();
+  if(lsize!=natoms) plumed_merror("inconsistent number of atoms in xtc frame");
+  positions.resize(3*natoms);
+  if(natoms<=9) {
+    for(int i=0; i<3*natoms; i++) positions[i]=in.getFloat();
+    return;
+  }
+  float fprecision=in.getFloat();
+  precision=fprecision;
+  int minint[3],maxint[3];
+  for(unsigned k=0; k<3; k++) minint[k]=in.getInt();
+  for(unsigned k=0; k<3; k++) maxint[k]=in.getInt();
+  unsigned sizeint[3],bitsizeint[3]= {0,0,0};
+  for(unsigned k=0; k<3; k++) sizeint[k]=maxint[k]-minint[k]+1;
+  unsigned bitsize=0;
+// large sizes cannot be multiplied and are stored separately
+  if((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff) {
+    for(unsigned k=0; k<3; k++) bitsizeint[k]=sizeofint(sizeint[k]);
+  } else {
+    bitsize=sizeofints(sizeint);
+  }
+  int smallidx=in.getInt();
+  if(smallidx<firstidx || smallidx>=lastidx) plumed_merror("corrupted xtc frame");
+  int smaller=magicints[std::max(firstidx,smallidx-1)]/2;
+  int small=magicints[smallidx]/2;
+  unsigned sizesmall[3];
+  sizesmall[0]=sizesmall[1]=sizesmall[2]=magicints[smallidx];
+  size_t nbytes=(large ? in.getUnsigned64() : in.getUnsigned());
+  BitInput bits(in.getOpaque(nbytes),nbytes);
+
+  const float inv_precision=1.0f/fprecision;
+  const size_t size3=3*size_t(natoms);
+  size_t n=0;
+  auto store=[&](const int c[3]) {
+    if(n+3>size3) plumed_merror("corrupted xtc frame");
+    for(unsigned k=0; k<3; k++) positions[n++]=float(c[k]*inv_precision);
+  };
+  int run=0;
+  int i=0;
+  int thiscoord[3],prevcoord[3];
+  while(i<natoms) {
+    if(bitsize==0) {
+      for(unsigned k=0; k<3; k++) thiscoord[k]=bits.receivebits(bitsizeint[k]);
+    } else {
+      bits.receiveints(bitsize,sizeint,thiscoord);
+    }
+    i++;
+    for(unsigned k=0; k<3; k++) {
+      thiscoord[k]+=minint[k];
+      prevcoord[k]=thiscoord[k];
+    }
+    int flag=bits.receivebits(1);
+    int is_smaller=0;
+    if(flag==1) {
+      run=bits.receivebits(5);
+      is_smaller=run%3;
+      run-=is_smaller;
+      is_smaller--;
+    }
+    if(run>0) {
+      for(int k=0; k<run; k+=3) {
+        bits.receiveints(smallidx,sizesmall,thiscoord);
+        i++;
+        for(unsigned l=0; l<3; l++) thiscoord[l]+=prevcoord[l]-small;
+        if(k==0) {
+// the first two atoms of a run were swapped for a better compression of water molecules
+          for(unsigned l=0; l<3; l++) std::swap(thiscoord[l],prevcoord[l]);
+          store(prevcoord);
+        } else {
+          for(unsigned l=0; l<3; l++) prevcoord[l]=thiscoord[l];
+        }
+        store(thiscoord);
+      }
+    } else {
+      store(thiscoord);
+    }
+    smallidx+=is_smaller;
+    if(smallidx<firstidx || smallidx>=lastidx) plumed_merror("corrupted xtc frame");
+    if(is_smaller<0) {
+      small=smaller;
+      smaller=(smallidx>firstidx ? magicints[smallidx-1]/2 : 0);
+    } else if(is_smaller>0) {
+      smaller=small;
+      small=magicints[smallidx]/2;
+    }
+    sizesmall[0]=sizesmall[1]=sizesmall[2]=magicints[smallidx];
+  }
+  if(n!=size3) plumed_merror("corrupted xtc frame");
+}
+
+void encodeXtcCoordinates(XdrOutput&out,const std::vector<float>&positions,float precision) {
+  const int natoms=positions.size()/3;
+  out.putInt(natoms);
+// few atoms are not compressed
+  if(natoms<=9) {
+    for(unsigned i=0; i<positions.size(); i++) out.putFloat(positions[i]);
+    return;
+  }
+  out.putFloat(precision);
+  const float maxabs=INT_MAX-2;
+  std::vector<int> ip(positions.size());
+  int minint[3]= {INT_MAX,INT_MAX,INT_MAX};
+  int maxint[3]= {INT_MIN,INT_MIN,INT_MIN};
+  int mindiff=INT_MAX;
+  int oldlint[3]= {0,0,0};
+  for(int i=0; i<natoms; i++) {
+    int lint[3];
+    for(unsigned k=0; k<3; k++) {
+      float lf;
+      if(positions[3*i+k]>=0.0) lf=positions[3*i+k]*precision+0.5;
+      else lf=positions[3*i+k]*precision-0.5;
+      if(std::fabs(lf)>maxabs) plumed_merror("coordinates are too large to be written in xtc format with this precision");
+      lint[k]=int(lf);
+      minint[k]=std::min(minint[k],lint[k]);
+      maxint[k]=std::max(maxint[k],lint[k]);
+      ip[3*i+k]=lint[k];
+    }
+    int diff=std::abs(oldlint[0]-lint[0])+std::abs(oldlint[1]-lint[1])+std::abs(oldlint[2]-lint[2]);
+    if(diff<mindiff && i>0) mindiff=diff;
+    for(unsigned k=0; k<3; k++) oldlint[k]=lint[k];
+  }
+  for(unsigned k=0; k<3; k++) out.putInt(minint[k]);
+  for(unsigned k=0; k<3; k++) out.putInt(maxint[k]);
+  for(unsigned k=0; k<3; k++) if(float(maxint[k])-float(minint[k])>=maxabs)
+      plumed_merror("coordinates are too spread to be written in xtc format with this precision");
+  unsigned sizeint[3],bitsizeint[3]= {0,0,0};
+  for(unsigned k=0; k<3; k++) sizeint[k]=maxint[k]-minint[k]+1;
+  unsigned bitsize=0;
+  if((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff) {
+    for(unsigned k=0; k<3; k++) bitsizeint[k]=sizeofint(sizeint[k]);
+  } else {
+    bitsize=sizeofints(sizeint);
+  }
+  int smallidx=firstidx;
+  while(smallidx<lastidx-1 && magicints[smallidx]<mindiff) smallidx++;
+  out.putInt(smallidx);
+  const int maxidx=std::min(lastidx-1,smallidx+8);
+  const int minidx=maxidx-8;
+  int smaller=magicints[std::max(firstidx,smallidx-1)]/2;
+  int small=magicints[smallidx]/2;
+  unsigned sizesmall[3];
+  sizesmall[0]=sizesmall[1]=sizesmall[2]=magicints[smallidx];
+  const int larger=magicints[maxidx]/2;
+
+  BitOutput bits(positions.size()*sizeof(int)*6/5);
+  int prevcoord[3]= {0,0,0};
+  int prevrun=-1;
+  int i=0;
+  while(i<natoms) {
+    int is_small=0;
+    int is_smaller;
+    int* thiscoord=&ip[3*i];
+    if(smallidx<maxidx && i>=1 &&
+        std::abs(thiscoord[0]-prevcoord[0])<larger &&
+        std::abs(thiscoord[1]-prevcoord[1])<larger &&
+        std::abs(thiscoord[2]-prevcoord[2])<larger) {
+      is_smaller=1;
+    } else if(smallidx>minidx) {
+      is_smaller=-1;
+    } else {
+      is_smaller=0;
+    }
+    if(i+1<natoms) {
+      if(std::abs(thiscoord[0]-thiscoord[3])<small &&
+          std::abs(thiscoord[1]-thiscoord[4])<small &&
+          std::abs(thiscoord[2]-thiscoord[5])<small) {
+// swap the first two atoms for a better compression of water molecules
+        for(unsigned k=0; k<3; k++) std::swap(thiscoord[k],thiscoord[k+3]);
+        is_small=1;
+      }
+    }
+    unsigned tmpcoord[30];
+    for(unsigned k=0; k<3; k++) tmpcoord[k]=thiscoord[k]-minint[k];
+    if(bitsize==0) {
+      for(unsigned k=0; k<3; k++) bits.sendbits(bitsizeint[k],tmpcoord[k]);
+    } else {
+      bits.sendints(bitsize,sizeint,tmpcoord);
+    }
+    for(unsigned k=0; k<3; k++) prevcoord[k]=thiscoord[k];
+    thiscoord+=3;
+    i++;
+
+    int run=0;
+    if(is_small==0 && is_smaller==-1) is_smaller=0;
+    while(is_small && run<8*3) {
+      if(is_smaller==-1 && (
+            (thiscoord[0]-prevcoord[0])*(thiscoord[0]-prevcoord[0]) +
+            (thiscoord[1]-prevcoord[1])*(thiscoord[1]-prevcoord[1]) +
+            (thiscoord[2]-prevcoord[2])*(thiscoord[2]-prevcoord[2]) >= smaller*smaller)) {
+        is_smaller=0;
+      }
+      for(unsigned k=0; k<3; k++) tmpcoord[run++]=thiscoord[k]-prevcoord[k]+small;
+      for(unsigned k=0; k<3; k++) prevcoord[k]=thiscoord[k];
+      i++;
+      thiscoord+=3;
+      is_small=0;
+      if(i<natoms &&
+          std::abs(thiscoord[0]-prevcoord[0])<small &&
+          std::abs(thiscoord[1]-prevcoord[1])<small &&
+          std::abs(thiscoord[2]-prevcoord[2])<small) {
+        is_small=1;
+      }
+    }
+    if(run!=prevrun || is_smaller!=0) {
+      prevrun=run;
+      bits.sendbits(1,1);
+      bits.sendbits(5,run+is_smaller+1);
+    } else {
+      bits.sendbits(1,0);
+    }
+    for(int k=0; k<run; k+=3) bits.sendints(smallidx,sizesmall,&tmpcoord[k]);
+    if(is_smaller!=0) {
+      smallidx+=is_smaller;
+      if(is_smaller<0) {
+        small=smaller;
+        smaller=magicints[smallidx-1]/2;
+      } else {
+        smaller=small;
+        small=magicints[smallidx]/2;
+      }
+      sizesmall[0]=sizesmall[1]=sizesmall[2]=magicints[smallidx];
+    }
+  }
+  out.putUnsigned(bits.getSize());
+  out.putOpaque(bits.getData(),bits.getSize());
+}
+
+/// Header of a trr frame
+struct TrrHeader {
+  int box_size=0;
+  int vir_size=0;
+  int pres_size=0;
+  int x_size=0;
+  int v_size=0;
+  int f_size=0;
+  int natoms=0;
+  int step=0;
+/// size of the reals (4 or 8)
+  unsigned prec=0;
+/// size of the data following the header
+  size_t getDataSize()const {
+    return size_t(box_size)+vir_size+pres_size+x_size+v_size+f_size;
+  }
+};
+
+/// Parse the integer part of a trr header, which starts at p
+void parseTrrHeader(const unsigned char*p,TrrHeader&h) {
+// ir_size and e_size are not used
+  h.box_size=getInt(p+8);
+  h.vir_size=getInt(p+12);
+  h.pres_size=getInt(p+16);
+// top_size and sym_size are not used
+  h.x_size=getInt(p+28);
+  h.v_size=getInt(p+32);
+  h.f_size=getInt(p+36);
+  h.natoms=getInt(p+40);
+  h.step=getInt(p+44);
+  if(h.natoms<=0) plumed_merror("corrupted trr header");
+  int nflsz=0;
+  if(h.box_size) nflsz=h.box_size/9;
+  else if(h.x_size) nflsz=h.x_size/(3*h.natoms);
+  else if(h.v_size) nflsz=h.v_size/(3*h.natoms);
+  else if(h.f_size) nflsz=h.f_size/(3*h.natoms);
+  if(nflsz!=sizeof(float) && nflsz!=sizeof(double)) plumed_merror("cannot determine the precision of trr file");
+  h.prec=nflsz;
+}
+
+}
+
+XdrReader::XdrReader(const std::string&path,const std::string&format):
+  path(path)
+{
+  if(format=="xtc") xtc=true;
+  else if(format=="trr") xtc=false;
+  else plumed_merror("unknown xdr format "+format);
+  fp=std::fopen(path.c_str(),"rb");
+  if(!fp) plumed_merror("cannot open file "+path);
+  std::fseek(fp,0,SEEK_END);
+  filesize=std::ftell(fp);
+  std::fseek(fp,0,SEEK_SET);
+  std::vector<unsigned char> buf;
+  if(readFrame(buf,true)) {
+    if(xtc) natoms=getInt(&buf[4]);
+    else {
+      TrrHeader h;
+      parseTrrHeader(&buf[12+getInt(&buf[8])+(4-getInt(&buf[8])%4)%4],h);
+      natoms=h.natoms;
+    }
+  }
+  std::fseek(fp,0,SEEK_SET);
+  offsets.clear();
+  indexed=false;
+  next=0;
+  setChunkSize(2*OpenMP::getNumThreads());
+}
+
+XdrReader::~XdrReader() {
+  if(fp) std::fclose(fp);
+}
+
+void XdrReader::setChunkSize(unsigned n) {
+  chunk=std::max(n,1u);
+}
+
+bool XdrReader::readBytes(std::vector<unsigned char>&buf,size_t n) {
+  size_t old=buf.size();
+  buf.resize(old+n);
+  return n==0 || std::fread(&buf[old],1,n,fp)==n;
+}
+
+bool XdrReader::readFrame(std::vector<unsigned char>&buf,bool skip) {
+  buf.clear();
+  size_t datasize=0;
+  if(!readBytes(buf,4)) return false;
+  int magic=getInt(&buf[0]);
+  if(xtc) {
+    if(magic!=xtcMagic && magic!=xtcMagicLarge) plumed_merror("file "+path+" is not a valid xtc file");
+// natoms, step, time, box and again natoms
+    if(!readBytes(buf,52)) return false;
+    int n=getInt(&buf[4]);
+    if(n<0 || getInt(&buf[52])!=n) plumed_merror("corrupted xtc frame in file "+path);
+    if(n<=9) {
+      datasize=12*size_t(n);
+    } else {
+// precision, minint, maxint, smallidx and the number of bytes
+      if(magic==xtcMagicLarge) {
+        if(!readBytes(buf,40)) return false;
+        datasize=(uint64_t(getUnsigned(&buf[88]))<<32) | getUnsigned(&buf[92]);
+      } else {
+        if(!readBytes(buf,36)) return false;
+        datasize=getUnsigned(&buf[88]);
+      }
+      datasize+=(4-datasize%4)%4;
+    }
+  } else {
+    if(magic!=trrMagic) plumed_merror("file "+path+" is not a valid trr file");
+    if(!readBytes(buf,8)) return false;
+    int slen=getInt(&buf[8]);
+    if(slen<0 || slen>1024) plumed_merror("corrupted trr frame in file "+path);
+    size_t start=12+slen+(4-slen%4)%4;
+    if(!readBytes(buf,start-12+52)) return false;
+    TrrHeader h;
+    parseTrrHeader(&buf[start],h);
+// time and lambda
+    if(!readBytes(buf,2*h.prec)) return false;
+    datasize=h.getDataSize();
+  }
+  if(skip) {
+    long pos=std::ftell(fp);
+    if(pos+long(datasize)>filesize) return false;
+    std::fseek(fp,datasize,SEEK_CUR);
+    return true;
+  }
+  return readBytes(buf,datasize);
+}
+
+void XdrReader::scan(unsigned n) {
+  if(indexed || n<offsets.size()) return;
+  long pos=std::ftell(fp);
+  std::vector<unsigned char> buf;
+  if(offsets.size()>0) {
+    std::fseek(fp,offsets.back(),SEEK_SET);
+    plumed_assert(readFrame(buf,true));
+  } else std::fseek(fp,0,SEEK_SET);
+  while(offsets.size()<=n) {
+    long start=std::ftell(fp);
+    if(!readFrame(buf,true)) {
+      indexed=true;
+      break;
+    }
+    offsets.push_back(start);
+  }
+  std::fseek(fp,pos,SEEK_SET);
+}
+
+bool XdrReader::fill() {
+  nbuffer=0;
+  ibuffer=0;
+  if(raw.size()<chunk) raw.resize(chunk);
+  if(buffer.size()<chunk) buffer.resize(chunk);
+// reading is serial
+  while(nbuffer<chunk) {
+    long start=std::ftell(fp);
+    if(next<offsets.size()) plumed_assert(offsets[next]==start);
+    if(!readFrame(raw[nbuffer],false)) {
+      if(next>=offsets.size()) indexed=true;
+      break;
+    }
+    if(next==offsets.size()) offsets.push_back(start);
+    next++;
+    nbuffer++;
+  }
+// decoding is done in parallel
+  std::vector<std::string> errors(nbuffer);
+  unsigned nt=std::min(OpenMP::getNumThreads(),nbuffer);
+  if(nt<1) nt=1;
+  #pragma omp parallel for num_threads(nt) schedule(dynamic,1)
+  for(unsigned i=0; i<nbuffer; i++) {
+    try {
+      decode(raw[i],xtc,buffer[i]);
+    } catch(const std::exception& e) {
+      errors[i]=e.what();
+    }
+  }
+  for(unsigned i=0; i<nbuffer; i++) if(errors[i].length()>0) {
+      std::string frame;
+      Tools::convert(next-nbuffer+i,frame);
+      plumed_merror("error reading frame "+frame+" of file "+path+"\n"+errors[i]);
+    }
+  return nbuffer>0;
+}
+
+bool XdrReader::read(XdrFrame&frame) {
+  while(true) {
+    if(ibuffer==nbuffer && !fill()) return false;
+    XdrFrame& f(buffer[ibuffer++]);
+    if(f.positions.empty()) continue;
+    std::swap(frame,f);
+    return true;
+  }
+}
+
+unsigned XdrReader::getNumberOfFrames() {
+  scan(UINT_MAX-1);
+  return offsets.size();
+}
+
+void XdrReader::seek(unsigned n) {
+  scan(n);
+  if(n>=offsets.size()) {
+    std::string nn;
+    Tools::convert(n,nn);
+    plumed_merror("frame "+nn+" not found in file "+path);
+  }
+  std::fseek(fp,offsets[n],SEEK_SET);
+  next=n;
+  nbuffer=0;
+  ibuffer=0;
+}
+
+void XdrReader::decode(const std::vector<unsigned char>&buf,bool xtc,XdrFrame&frame) {
+  XdrInput in(buf);
+  int magic=in.getInt();
+  frame.positions.clear();
+  frame.lambda=0.0;
+  frame.precision=0.0;
+  if(xtc) {
+    frame.natoms=in.getInt();
+    frame.step=in.getInt();
+    frame.time=in.getFloat();
+    for(unsigned i=0; i<9; i++) frame.box[i]=in.getFloat();
+    decodeXtcCoordinates(in,magic==xtcMagicLarge,frame.natoms,frame.precision,frame.positions);
+  } else {
+    in.skip(4);
+    int slen=in.getInt();
+    in.getOpaque(slen);
+    TrrHeader h;
+    parseTrrHeader(in.getOpaque(52),h);
+    frame.natoms=h.natoms;
+    frame.step=h.step;
+    frame.time=in.getReal(h.prec);
+    frame.lambda=in.getReal(h.prec);
+    frame.box.fill(0.0);
+    if(h.box_size) for(unsigned i=0; i<9; i++) frame.box[i]=in.getReal(h.prec);
+    in.skip(h.vir_size);
+    in.skip(h.pres_size);
+    if(h.x_size) {
+      frame.positions.resize(3*h.natoms);
+      for(unsigned i=0; i<frame.positions.size(); i++) frame.positions[i]=in.getReal(h.prec);
+    }
+  }
+}
+
+XdrWriter::XdrWriter(const std::string&path,const std::string&format,const std::string&mode) {
+  if(format=="xtc") xtc=true;
+  else if(format=="trr") xtc=false;
+  else plumed_merror("unknown xdr format "+format);
+  std::string m=mode;
+  if(m.find('b')==std::string::npos) m+="b";
+  fp=std::fopen(path.c_str(),m.c_str());
+  if(!fp) plumed_merror("cannot open file "+path);
+}
+
+XdrWriter::~XdrWriter() {
+  if(fp) std::fclose(fp);
+}
+
+void XdrWriter::encode(long step,float time,const std::array<float,9>&box,const std::vector<float>&positions,float precision,
+                       bool xtc,std::vector<unsigned char>&buf) {
+  plumed_massert(positions.size()%3==0,"positions should have three components per atom");
+  const int natoms=positions.size()/3;
+  buf.clear();
+  XdrOutput out(buf);
+  if(xtc) {
+    out.putInt(xtcMagic);
+    out.putInt(natoms);
+    out.putInt(step);
+    out.putFloat(time);
+    for(unsigned i=0; i<9; i++) out.putFloat(box[i]);
+    encodeXtcCoordinates(out,positions,precision);
+  } else {
+    const size_t slen=std::strlen(trrVersion);
+    out.putInt(trrMagic);
+    out.putInt(slen+1);
+    out.putInt(slen);
+    out.putOpaque(reinterpret_cast<const unsigned char*>(trrVersion),slen);
+    out.putInt(0);                        // ir_size
+    out.putInt(0);                        // e_size
+    out.putInt(9*sizeof(float));          // box_size
+    out.putInt(0);                        // vir_size
+    out.putInt(0);                        // pres_size
+    out.putInt(0);                        // top_size
+    out.putInt(0);                        // sym_size
+    out.putInt(3*natoms*sizeof(float));   // x_size
+    out.putInt(0);                        // v_size
+    out.putInt(0);                        // f_size
+    out.putInt(natoms);
+    out.putInt(step);
+    out.putInt(0);                        // nre
+    out.putFloat(time);
+    out.putFloat(0.0);                    // lambda
+    for(unsigned i=0; i<9; i++) out.putFloat(box[i]);
+    for(unsigned i=0; i<positions.size(); i++) out.putFloat(positions[i]);
+  }
+}
+
+void XdrWriter::write(long step,float time,const std::array<float,9>&box,const std::vector<float>&positions,float precision) {
+  encode(step,time,box,positions,precision,xtc,buf);
+  if(std::fwrite(buf.data(),1,buf.size(),fp)!=buf.size()) plumed_merror("error writing xdr file");
+}
+
+void XdrWriter::flush() {
+  std::fflush(fp);
+}
+
+}
@@ -0,0 +1,138 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2021 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_XdrTrajectory_h
+#define __PLUMED_tools_XdrTrajectory_h
+
+#include <array>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace PLMD {
+
+/// \ingroup TOOLBOX
+/// A frame of a GROMACS xtc or trr trajectory.
+/// As in the files, lengths are in nm and times in ps.
+struct XdrFrame {
+/// number of atoms
+  int natoms=0;
+/// MD step
+  long step=0;
+/// time
+  double time=0.0;
+/// lambda (trr only)
+  double lambda=0.0;
+/// precision of the compressed coordinates (xtc only)
+  double precision=0.0;
+/// box vectors, stored by rows
+  std::array<double,9> box{};
+/// positions, stored as x0,y0,z0,x1,...
+/// It is empty for trr frames that only contain velocities or forces.
+  std::vector<double> positions;
+};
+
+/// \ingroup TOOLBOX
+/// Native reader for GROMACS xtc and trr files.
+/// Generic (triclinic) boxes are supported, and trr files can be
+/// either in single or double precision.
+/// Frames are read from the file in chunks and decoded in parallel
+/// with OpenMP. The offsets of the frames found so far are kept in an
+/// index, so that one can jump to an arbitrary frame with seek().
+class XdrReader {
+  FILE* fp=nullptr;
+  std::string path;
+  bool xtc=true;
+  long filesize=0;
+  int natoms=0;
+/// number of frames decoded at a time
+  unsigned chunk=1;
+/// offsets of the frames found so far
+  std::vector<long> offsets;
+/// true when offsets contains all the frames in the file
+  bool indexed=false;
+/// index of the next frame that will be read from the file
+  unsigned next=0;
+/// raw and decoded frames of the current chunk
+  std::vector<std::vector<unsigned char> > raw;
+  std::vector<XdrFrame> buffer;
+  unsigned nbuffer=0;
+  unsigned ibuffer=0;
+  bool readBytes(std::vector<unsigned char>&,size_t);
+/// Read the next frame in the file, storing its bytes in buf.
+/// If skip is true, only the header is stored and the rest is skipped.
+/// Returns false at the end of the file (or on a truncated frame).
+  bool readFrame(std::vector<unsigned char>&buf,bool skip);
+/// Extend the index until frame n is found
+  void scan(unsigned n);
+/// Read and decode the next chunk of frames
+  bool fill();
+public:
+/// Open a file. format should be either xtc or trr
+  XdrReader(const std::string&path,const std::string&format);
+  XdrReader(const XdrReader&)=delete;
+  XdrReader& operator=(const XdrReader&)=delete;
+  ~XdrReader();
+/// Number of atoms, as found in the first frame
+  int getNumberOfAtoms()const {
+    return natoms;
+  }
+/// Set the number of frames that are decoded at a time.
+/// By default, this is twice the number of OpenMP threads.
+  void setChunkSize(unsigned);
+/// Read the next frame. Returns false at the end of the file.
+/// Frames without positions are skipped.
+  bool read(XdrFrame&);
+/// Total number of frames in the file. This completes the index.
+  unsigned getNumberOfFrames();
+/// Move to frame n, so that the next call to read() returns it
+  void seek(unsigned n);
+/// Decode a frame from its raw bytes
+  static void decode(const std::vector<unsigned char>&buf,bool xtc,XdrFrame&);
+};
+
+/// \ingroup TOOLBOX
+/// Native writer for GROMACS xtc and trr files.
+/// trr files are written in single precision, and the written files
+/// are identical to the ones produced by the xdrfile library.
+class XdrWriter {
+  FILE* fp=nullptr;
+  bool xtc=true;
+  std::vector<unsigned char> buf;
+public:
+/// Open a file. format should be either xtc or trr, mode is passed to fopen
+  XdrWriter(const std::string&path,const std::string&format,const std::string&mode="w");
+  XdrWriter(const XdrWriter&)=delete;
+  XdrWriter& operator=(const XdrWriter&)=delete;
+  ~XdrWriter();
+/// Write a frame. box is stored by rows and positions as x0,y0,z0,x1,...
+/// precision is only used for xtc files.
+  void write(long step,float time,const std::array<float,9>&box,const std::vector<float>&positions,float precision=1000.0);
+/// Encode a frame into its raw bytes
+  static void encode(long step,float time,const std::array<float,9>&box,const std::vector<float>&positions,float precision,
+                     bool xtc,std::vector<unsigned char>&buf);
+/// Flush the file
+  void flush();
+};
+
+}
+
+#endif
@@ -61,6 +61,7 @@ ActionWithVessel::ActionWithVessel(const ActionOptions&ao):
   weightHasDerivatives(false),
   mydata(NULL)
 {
+  tuner.link(log,getLabel());
   maxderivatives=309; parse("MAXDERIVATIVES",maxderivatives);
   if( keywords.exists("SERIAL") ) parseFlag("SERIAL",serial);
   else serial=true;
@@ -259,6 +260,14 @@ unsigned ActionWithVessel::getSizeOfBuffer( unsigned& bufsize ) {
   return bufsize;
 }
 
+void ActionWithVessel::getMemoryUsage( std::vector<std::pair<std::string,std::size_t> >& usage ) const {
+  usage.push_back( std::make_pair( "task buffer", buffer.capacity()*sizeof(double) + der_list.capacity()*sizeof(unsigned) ) );
+  for(unsigned i=0; i<functions.size(); ++i) {
+    std::size_t mem=functions[i]->getMemoryUsage();
+    if( mem>0 ) usage.push_back( std::make_pair( "vessel " + functions[i]->getName(), mem ) );
+  }
+}
+
 void ActionWithVessel::runAllTasks() {
   plumed_massert( !contributorsAreUnlocked && functions.size()>0, "you must have a call to readVesselKeywords somewhere" );
   unsigned stride=comm.Get_size();
@@ -272,7 +281,8 @@ void ActionWithVessel::runAllTasks() {
 
   // Get number of threads for OpenMP
   unsigned nt=OpenMP::getNumThreads();
-  if( nt*stride*2>nactive_tasks || !threadSafe()) nt=1;
+  if( !threadSafe() ) nt=1;
+  else nt=tuner.begin(nactive_tasks/stride,nt*stride*2>nactive_tasks?1:nt);
 
   // Get size for buffer
   unsigned bsize=0, bufsize=getSizeOfBuffer( bsize );
@@ -319,6 +329,7 @@ void ActionWithVessel::runAllTasks() {
     #pragma omp critical
     if(nt>1) for(unsigned i=0; i<bufsize; ++i) buffer[i]+=omp_buffer[i];
   }
+  tuner.end();
   if(timers) stopwatch.stop("2 Loop over tasks");
   // Turn back on derivative calculation
   dertime=true;
@@ -33,6 +33,7 @@
 namespace PLMD {
 class Value;
 class Stopwatch;
+class OpenMPTuner;
 
 namespace vesselbase {
 
@@ -90,6 +91,9 @@ private:
   ForwardDecl<Stopwatch> stopwatch_fwd;
 /// The stopwatch that times the different parts of the calculation
   Stopwatch& stopwatch=*stopwatch_fwd;
+  ForwardDecl<OpenMPTuner> tuner_fwd;
+/// Chooses the number of threads used in the loop over tasks
+  OpenMPTuner& tuner=*tuner_fwd;
 /// These are used to minmise computational expense in complex functions
   bool dertime_can_be_off;
 protected:
@@ -150,6 +154,8 @@ public:
   bool taskIsCurrentlyActive( const unsigned& index ) const ;
 /// Are derivatives required for this quantity
   bool derivativesAreRequired() const ;
+/// Report the memory used by the buffer and by the vessels
+  void getMemoryUsage( std::vector<std::pair<std::string,std::size_t> >& usage ) const override;
 /// Is this action thread safe
   virtual bool threadSafe() const { return true; }
 /// Finish running all the calculations
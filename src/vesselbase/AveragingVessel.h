@@ -63,6 +63,8 @@ public:
   void setNorm( const double& snorm );
   double getNorm() const ;
   bool applyForce(  std::vector<double>& forces ) override { return false; }
+/// Return the number of bytes used to store the averages
+  std::size_t getMemoryUsage() const override { return data.capacity()*sizeof(double); }
 };
 
 inline
@@ -160,6 +160,10 @@ void StoreDataVessel::finish( const std::vector<double>& buffer ) {
   for(unsigned i=0; i<local_buffer.size(); ++i) local_buffer[i]=buffer[bufstart+i];
 }
 
+std::size_t StoreDataVessel::getMemoryUsage() const {
+  return local_buffer.capacity()*sizeof(double) + active_der.capacity()*sizeof(unsigned);
+}
+
 
 void StoreDataVessel::setActiveValsAndDerivatives( const std::vector<unsigned>& der_index ) {
   if( !getAction()->lowmem && getAction()->derivativesAreRequired() ) {
@@ -124,6 +124,8 @@ public:
   virtual void activateIndices( ActionWithVessel* ) {}
 /// Forces on vectors should always be applied elsewhere
   bool applyForce(std::vector<double>&) override { return false; }
+/// Return the number of bytes used to store the data
+  std::size_t getMemoryUsage() const override ;
 ///  Get the number of data users
   unsigned getNumberOfDataUsers() const ;
 /// Get one of the ith data user
@@ -24,6 +24,7 @@
 
 #include <string>
 #include <cstring>
+#include <cstddef>
 #include <vector>
 #include <algorithm>
 #include "tools/Exception.h"
@@ -151,6 +152,8 @@ public:
   virtual void resize()=0;
 /// Retrieve the forces on the quantities in the vessel
   virtual bool applyForce( std::vector<double>& forces )=0;
+/// Return the approximate number of bytes stored in the vessel
+  virtual std::size_t getMemoryUsage() const { return 0; }
 };
 
 template<class T>